@@ -9,10 +9,12 @@ void AdderAdd(ThreadedBrain & brain, Checker & cResult, Checker & cCarry)
 	const int c = isSensorSet(brain, {0,-3}) ? 1 : 0;
 
 	const int r = a + b + c;
-	//Result
-	brain.setDirectionalTile(cResult(r & 1), {0,0});
-	//Carry
-	brain.setDirectionalTile(cCarry(r & 2), {1,-3});
+	brain.transaction()
+			//Result
+			.setDirectionalTile(cResult(r & 1), {0,0})
+			//Carry
+			.setDirectionalTile(cCarry(r & 2), {1,-3})
+			.commit();
 
 	brain.move();
 }
@@ -31,3 +31,29 @@ void Follow(ThreadedBrain &brain)
 	//Run as long as we have where to move
 	while (brain && advance(brain)) ;
 }
+
+Turtle::Task FollowAsync(ThreadedBrain &brain)
+{
+	while (brain)
+	{
+		//Ask for all the sensors at once, so they share a single wait
+		auto forward = brain.getTileAsync({1, 0});
+		auto right = brain.getTileAsync({0, -1});
+		auto left = brain.getTileAsync({0, 1});
+
+		if (isSet(co_await forward))
+			co_await brain.moveAsync();
+		else if (isSet(co_await right))
+		{
+			co_await brain.rotateAsync(-0.25);
+			co_await brain.moveAsync();
+		}
+		else if (isSet(co_await left))
+		{
+			co_await brain.rotateAsync(0.25);
+			co_await brain.moveAsync();
+		}
+		else
+			break;
+	}
+}
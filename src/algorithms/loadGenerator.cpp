@@ -0,0 +1,216 @@
+#include "main.h"
+#include "CommandStatistics.h"
+#include "FrameStatistics.h"
+#include "LatencyHistogram.h"
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <random>
+
+using Turtle::CommandStatistics;
+using Turtle::FrameStatistics;
+using Turtle::LatencyHistogram;
+
+namespace
+{
+	enum Kind
+	{
+		Get,
+		Set,
+		TileRead,
+		Log,
+		Kinds
+	};
+
+	QString microseconds(std::uint64_t nanoseconds)
+	{
+		return QString::number(static_cast<double>(nanoseconds) * 1e-3, 'f', 0);
+	}
+
+	QString latencies(const LatencyHistogram & histogram)
+	{
+		return QString("p50 %1, p99 %2, p99.9 %3, max %4 µs")
+				.arg(microseconds(histogram.percentile(0.5)))
+				.arg(microseconds(histogram.percentile(0.99)))
+				.arg(microseconds(histogram.percentile(0.999)))
+				.arg(microseconds(histogram.max()));
+	}
+
+	//The frames of the user interface since a starting point
+	struct Frames
+	{
+		explicit Frames(const FrameStatistics & statistics) :
+			frames{statistics.frames()},
+			late{statistics.late()},
+			dropped{statistics.dropped()}
+		{}
+
+		QString since(const Frames & start) const
+		{
+			return QString("frames %1, late %2, dropped %3")
+					.arg(frames - start.frames)
+					.arg(late - start.late)
+					.arg(dropped - start.dropped);
+		}
+
+		std::uint64_t frames;
+		std::uint64_t late;
+		std::uint64_t dropped;
+	};
+}
+
+//Floods the controller with a mix of commands at a target rate, reporting how it keeps up
+//The commands are sent on a fixed schedule, and their latency is measured from when they
+// were due, so a controller falling behind shows as growing latency rather than as a
+// lower rate of sending.
+void LoadGenerator(ThreadedBrain & brain)
+{
+	const QString title = "Load generator";
+	bool ok;
+
+	const int rate = brain.getInteger(title, "Target commands per second, or 0 for as many as possible", 1000, &ok);
+	if (!ok || (rate < 0))
+		return;
+
+	const int duration = brain.getInteger(title, "Duration, in seconds", 10, &ok);
+	if (!ok || (duration <= 0))
+		return;
+
+	const QString mix = brain.getString(title, "Weights of Get, Set, tile read and log commands", "40,30,20,10", &ok);
+	if (!ok)
+		return;
+
+	const QStringList parts = mix.split(",");
+	std::array<double, Kinds> weights {};
+	double weightSum = 0;
+	for (int i = 0; (i < Kinds) && (i < parts.size()); ++i)
+	{
+		weights[static_cast<size_t>(i)] = std::max(0.0, parts[i].trimmed().toDouble());
+		weightSum += weights[static_cast<size_t>(i)];
+	}
+
+	if ((parts.size() != Kinds) || (weightSum <= 0))
+	{
+		brain.log("<b>Invalid mix!</b>");
+		return;
+	}
+
+	//Every command should reach the controller, instead of being served locally
+	const bool stateCached = brain.isStateCached();
+	const bool floorMirrored = brain.isFloorMirrored();
+	brain.setStateCached(false);
+	brain.setFloorMirrored(false);
+
+	std::mt19937 random(1);
+	std::discrete_distribution<int> kind(weights.cbegin(), weights.cend());
+	std::uniform_int_distribution<int> offset(-3, 3);
+	std::uniform_real_distribution<double> hue(0, 1);
+
+	//Too large for the stack of a fiber
+	auto total = std::make_unique<LatencyHistogram>();
+	auto window = std::make_unique<LatencyHistogram>();
+
+	const FrameStatistics & frameStatistics = FrameStatistics::global();
+	const Frames firstFrames(frameStatistics);
+	Frames windowFrames = firstFrames;
+
+	std::array<std::uint64_t, Kinds> counts {};
+
+	const qint64 second = 1000000000;
+	const qint64 period = rate ? (second / rate) : 0;
+	const qint64 start = CommandStatistics::now();
+	const qint64 end = start + duration * second;
+	qint64 windowStart = start;
+	std::uint64_t sent = 0;
+
+	brain.log(
+				QString("Generating %1 commands/s for %2 s, weighted %3")
+				.arg(rate ? QString::number(rate) : "as many")
+				.arg(duration)
+				.arg(mix));
+
+	while (brain)
+	{
+		const qint64 due = period ? start + static_cast<qint64>(sent) * period : CommandStatistics::now();
+		if (due >= end)
+			break;
+
+		const qint64 early = due - CommandStatistics::now();
+		if (early > 0)
+			brain.sleepFor(std::chrono::nanoseconds(early));
+
+		const int next = kind(random);
+		switch (next)
+		{
+			case Get:
+				brain.getCurrentPosition();
+				break;
+
+			case Set:
+				brain.setPenColor(hue(random), 1);
+				break;
+
+			case TileRead:
+				brain.getAbsoluteTile({offset(random), offset(random)});
+				break;
+
+			case Log:
+				brain.log(QString("Load %1").arg(sent));
+				break;
+		}
+
+		const qint64 done = CommandStatistics::now();
+		total->record(static_cast<std::uint64_t>(done - due));
+		window->record(static_cast<std::uint64_t>(done - due));
+		++counts[static_cast<size_t>(next)];
+		++sent;
+
+		//Report once a second
+		if (done - windowStart >= second)
+		{
+			const Frames frames(frameStatistics);
+
+			brain.log(
+						QString("%1 s: %2 commands/s, latency %3, %4")
+						.arg((done - start) / second)
+						.arg(static_cast<double>(window->count()) * second / (done - windowStart), 0, 'f', 0)
+						.arg(latencies(*window))
+						.arg(frames.since(windowFrames)));
+
+			window->reset();
+			windowStart = done;
+			windowFrames = frames;
+		}
+	}
+
+	const qint64 elapsed = CommandStatistics::now() - start;
+	const double throughput = (elapsed > 0) ? static_cast<double>(sent) * second / elapsed : 0;
+
+	QString summary =
+			QString("<b>Sustained %1 commands/s</b>").arg(throughput, 0, 'f', 0);
+
+	//Falling more than 5% short of the target means the controller is saturated
+	if (rate)
+		summary += (throughput < rate * 0.95)
+				? QString(", <font color=\"red\">short of the %1 targeted</font>").arg(rate)
+				: QString(", keeping up with the %1 targeted").arg(rate);
+
+	brain.log(summary);
+	brain.log(
+				QString("Sent %1: %2 get, %3 set, %4 tile read, %5 log")
+				.arg(sent)
+				.arg(counts[Get])
+				.arg(counts[Set])
+				.arg(counts[TileRead])
+				.arg(counts[Log]));
+	brain.log("Latency " + latencies(*total));
+	brain.log(
+				QString("User interface: %1, frame interval p99 %2 ms, paint p99 %3 ms")
+				.arg(Frames(frameStatistics).since(firstFrames))
+				.arg(static_cast<double>(frameStatistics.intervals().percentile(0.99)) * 1e-6, 0, 'f', 1)
+				.arg(static_cast<double>(frameStatistics.paints().percentile(0.99)) * 1e-6, 0, 'f', 1));
+
+	brain.setStateCached(stateCached);
+	brain.setFloorMirrored(floorMirrored);
+}
@@ -0,0 +1,65 @@
+#include "main.h"
+
+#include <cmath>
+#include <vector>
+
+//A ring of swarm turtles, each drawing a spiral of its own
+//Every call addresses the whole ring at once, so the count costs nothing in round trips.
+void Swarm(ThreadedBrain & brain)
+{
+	bool ok;
+	const int count = brain.getInteger("Swarm", "Number of turtles", 100, &ok);
+	if (!ok || (count <= 0))
+		return;
+
+	const double tau = 2 * acos(-1);
+	const double radius = 5;
+
+	std::vector<Turtle::Position2D> positions;
+	for (int i = 0; i < count; ++i)
+	{
+		const double angle = tau * i / count;
+		positions.push_back({radius * cos(angle), radius * sin(angle)});
+	}
+
+	//Start from an empty swarm, so repeated runs don't keep growing it
+	brain.swarmClear();
+
+	const ThreadedBrain::SwarmGroup group = brain.swarmAdd(positions);
+	if (group.empty())
+		return;
+
+	//Face away from the center, each with a pen of its own color
+	std::vector<double> angles;
+	std::vector<Turtle::Command::Turtle> pens;
+	for (size_t i = 0; i < group.size(); ++i)
+	{
+		const double fraction = static_cast<double>(i) / group.size();
+		angles.push_back(fraction);
+
+		Turtle::Command::Turtle pen {};
+		pen.command = Turtle::Command::Turtle::Command::Set;
+		pen.target = Turtle::Command::Turtle::Target::Target;
+		pen.setPenColor = true;
+		pen.setPenState = true;
+		pen.penDown = true;
+		pen.color = QColor::fromHsvF(fraction, 1, 1);
+		pens.push_back(pen);
+	}
+
+	brain.swarmRotate(group, angles);
+	brain.swarmSet(group, pens);
+
+	//Grow the spirals, each turtle at one of a few paces
+	const std::vector<double> turns(group.size(), 0.05);
+	std::vector<double> distances(group.size());
+
+	for (int step = 1; brain && (step < 200); ++step)
+	{
+		for (size_t i = 0; i < group.size(); ++i)
+			distances[i] = 0.05 * step * static_cast<double>(1 + i % 3);
+
+		brain.swarmMove(group, distances);
+		brain.swarmRotate(group, turns);
+	}
+}
@@ -239,10 +239,12 @@ void writeNumber(
 
 	if (markers)
 	{
-		brain.setPenColor(Qt::green);
-		brain.setPenDown(true);
-		brain.setPenDown(false);
-		brain.jump();
+		brain.transaction()
+				.setPenColor(Qt::green)
+				.setPenDown(true)
+				.setPenDown(false)
+				.jump()
+				.commit();
 		steps++;
 	}
 
@@ -257,20 +259,22 @@ void writeNumber(
 			return;
 		}
 
-		brain.setPenColor(checker((number & (1 << i))));
-		brain.setPenDown(true);
-		brain.setPenDown(false);
-
-		brain.jump();
+		//Mark the bit and advance in a single step
+		brain.transaction()
+				.setPenColor(checker((number & (1 << i))))
+				.setPenDown(true)
+				.setPenDown(false)
+				.jump()
+				.commit();
 		steps++;
 	}
 
 	if (markers)
-	{
-		brain.setPenColor(Qt::red);
-		brain.setPenDown(true);
-		brain.setPenDown(false);
-	}
+		brain.transaction()
+				.setPenColor(Qt::red)
+				.setPenDown(true)
+				.setPenDown(false)
+				.commit();
 
 	if (reset)
 		brain.move(-steps);
@@ -0,0 +1,90 @@
+#include "Benchmark.h"
+
+#include <QJsonArray>
+#include <QSysInfo>
+
+#include <algorithm>
+#include <chrono>
+
+using namespace Turtle;
+
+void Benchmark::add(const QString & name, Case body)
+{
+	m_cases.push_back({name, std::move(body)});
+}
+
+QStringList Benchmark::names() const
+{
+	QStringList list;
+	for (const Entry & entry : m_cases)
+		list << entry.name;
+
+	return list;
+}
+
+QJsonObject Benchmark::run() const
+{
+	QJsonArray results;
+	for (const Entry & entry : m_cases)
+		if (m_options.filter.match(entry.name).hasMatch())
+			results.append(run(entry));
+
+	return
+	{
+		{"seed", static_cast<qint64>(m_options.seed)},
+		{"samples", m_options.samples},
+		{"cpu", QSysInfo::currentCpuArchitecture()},
+		{"os", QSysInfo::prettyProductName()},
+		{"results", results}
+	};
+}
+
+double Benchmark::time(const Case & body, std::uint64_t iterations)
+{
+	using Clock = std::chrono::steady_clock;
+
+	const Clock::time_point start = Clock::now();
+	body(iterations);
+	const Clock::time_point end = Clock::now();
+
+	return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+QJsonObject Benchmark::run(const Entry & entry) const
+{
+	const double sampleTime = m_options.sampleSeconds * 1e9;
+
+	//Grow the count until a sample is long enough, which also warms up the caches
+	std::uint64_t iterations = 1;
+	for (;;)
+	{
+		const double elapsed = time(entry.body, iterations);
+		if (elapsed >= sampleTime / 2)
+		{
+			iterations = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(iterations * sampleTime / elapsed));
+			break;
+		}
+
+		iterations *= (elapsed > 0) ? std::min<std::uint64_t>(100, static_cast<std::uint64_t>(sampleTime / elapsed) + 1) : 100;
+	}
+
+	std::vector<double> perIteration;
+	for (int i = 0; i < std::max(1, m_options.samples); ++i)
+		perIteration.push_back(time(entry.body, iterations) / static_cast<double>(iterations));
+
+	std::sort(perIteration.begin(), perIteration.end());
+
+	double sum = 0;
+	for (const double value : perIteration)
+		sum += value;
+
+	return
+	{
+		{"name", entry.name},
+		{"iterations", static_cast<qint64>(iterations)},
+		{"ns_min", perIteration.front()},
+		{"ns_median", perIteration[perIteration.size() / 2]},
+		{"ns_mean", sum / static_cast<double>(perIteration.size())},
+		{"ns_max", perIteration.back()}
+	};
+}
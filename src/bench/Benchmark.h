@@ -0,0 +1,77 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace Turtle
+{
+	//A minimal harness timing named cases, with results as JSON
+	//Each case is a function running a given number of iterations. The count is
+	// calibrated to last about the sample time, and several samples are taken,
+	// so the reported times per iteration are stable enough to compare between builds.
+	class Benchmark
+	{
+	public:
+		using Case = std::function<void(std::uint64_t iterations)>;
+
+		struct Options
+		{
+			//Only the cases matching are run
+			QRegularExpression filter;
+
+			int samples = 10;
+			double sampleSeconds = 0.05;
+
+			//Reported with the results, so they are known to come from the same inputs
+			quint32 seed = 1;
+		};
+
+		explicit Benchmark(const Options & options) : m_options{options} {}
+
+		void add(const QString & name, Case body);
+
+		//The names of all the cases, in order
+		QStringList names() const;
+
+		//Run all the matching cases, returning their results
+		QJsonObject run() const;
+
+		//Keep a value from being optimized away
+		template <typename T> static void keep(T && value);
+
+	private:
+		struct Entry
+		{
+			QString name;
+			Case body;
+		};
+
+		//Time a number of iterations, in nanoseconds
+		static double time(const Case & body, std::uint64_t iterations);
+
+		QJsonObject run(const Entry & entry) const;
+
+		Options m_options;
+		std::vector<Entry> m_cases;
+	};
+
+	template <typename T>
+	inline void Benchmark::keep(T && value)
+	{
+#	if defined(__GNUC__)
+		asm volatile("" : : "g"(&value) : "memory");
+#	else
+		static volatile const void * sink;
+		sink = &value;
+#	endif
+	}
+
+}
+#endif // BENCHMARK_H
@@ -0,0 +1,372 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonDocument>
+#include <QTextStream>
+
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Benchmark.h"
+#include "CommandMailbox.h"
+#include "ThreadedBrain.h"
+#include "TiledFloor.h"
+#include "TurtleActor.h"
+#include "TurtleActorController.h"
+#include "Types.h"
+#include "World.h"
+
+using namespace Turtle;
+
+namespace
+{
+	//The floor of all the cases, in tiles from the origin to the edge
+	constexpr TilePosition halfSize = 100;
+
+	//The inputs are cycled through, so their count is a power of two
+	constexpr size_t inputCount = 4096;
+	constexpr size_t inputMask = inputCount - 1;
+
+	//Random inputs, the same for a given seed
+	struct Inputs
+	{
+		explicit Inputs(quint32 seed)
+		{
+			std::mt19937 random(seed);
+			std::uniform_int_distribution<TilePosition> tile(-halfSize, halfSize);
+			std::uniform_real_distribution<double> position(-halfSize - 10.0, halfSize + 10.0);
+			std::uniform_int_distribution<int> channel(0, 255);
+
+			for (size_t i = 0; i < inputCount; ++i)
+			{
+				tiles.push_back({tile(random), tile(random)});
+				positions.push_back({position(random), position(random)});
+				colors.push_back(QColor(channel(random), channel(random), channel(random)));
+			}
+		}
+
+		std::vector<TilePosition2D> tiles;
+		std::vector<Position2D> positions;
+		std::vector<QColor> colors;
+	};
+
+	//Exposes the tile sensor update, which is otherwise run only as part of a step
+	class SensorTurtle : public TurtleActor
+	{
+	public:
+		using TurtleActor::TurtleActor;
+		using TurtleActor::updateTileSensor;
+	};
+
+	//Send a command from a brain thread and wait for its reply, a number of times
+	//The controller runs on the event loop of the calling thread, as in the applications.
+	void roundTrip(TurtleActorController & controller, const Command & command, std::uint64_t iterations)
+	{
+		CommandMailbox mailbox;
+		ThreadedBrain brain(mailbox);
+		brain.setActive(true);
+		controller.attach(&mailbox);
+
+		QEventLoop loop;
+		std::thread thread([&]
+		{
+			for (std::uint64_t i = 0; i < iterations; ++i)
+				Benchmark::keep(brain.sendCommand(command));
+
+			QMetaObject::invokeMethod(&loop, &QEventLoop::quit, Qt::QueuedConnection);
+		});
+
+		loop.exec();
+		thread.join();
+
+		controller.attach(nullptr);
+	}
+
+	void addFloorCases(Benchmark & benchmark, const Inputs & inputs)
+	{
+		static TiledFloor floor({halfSize, halfSize});
+
+		benchmark.add("TiledFloor/setColor", [&inputs](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; ++i)
+				floor.setColor(inputs.tiles[i & inputMask], inputs.colors[i & inputMask]);
+		});
+
+		benchmark.add("TiledFloor/getColor", [&inputs](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; ++i)
+				Benchmark::keep(floor.getColor(inputs.tiles[i & inputMask]));
+		});
+
+		for (const size_t size : {1, 3, 10})
+			benchmark.add(QString("TiledFloor/getTiles/%1").arg(size), [&inputs, size](std::uint64_t iterations)
+			{
+				for (std::uint64_t i = 0; i < iterations; ++i)
+					Benchmark::keep(floor.getTiles(inputs.tiles[i & inputMask], size));
+			});
+
+		benchmark.add("TiledFloor/setImage", [](std::uint64_t iterations)
+		{
+			const QImage image = floor.image().convertToFormat(QImage::Format_RGB32);
+			for (std::uint64_t i = 0; i < iterations; ++i)
+				floor.setImage(image);
+		});
+
+		benchmark.add("TiledFloor/clear", [](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; ++i)
+				floor.clear();
+		});
+	}
+
+	void addTypesCases(Benchmark & benchmark, const Inputs & inputs)
+	{
+		benchmark.add("Types/Position2D", [&inputs](std::uint64_t iterations)
+		{
+			Position2D sum;
+			for (std::uint64_t i = 0; i < iterations; ++i)
+			{
+				const Position2D & a = inputs.positions[i & inputMask];
+				const Position2D & b = inputs.positions[(i + 1) & inputMask];
+				sum += (a - b) * 0.5 + a.max(b) / 2.0;
+			}
+
+			Benchmark::keep(sum);
+		});
+
+		benchmark.add("Types/TilePosition2D", [&inputs](std::uint64_t iterations)
+		{
+			TilePosition2D sum;
+			for (std::uint64_t i = 0; i < iterations; ++i)
+			{
+				const TilePosition2D & a = inputs.tiles[i & inputMask];
+				const TilePosition2D & b = inputs.tiles[(i + 1) & inputMask];
+				sum += (a - b) * 2 + a.min(b);
+			}
+
+			Benchmark::keep(sum);
+		});
+
+		benchmark.add("Types/Position2D conversion", [&inputs](std::uint64_t iterations)
+		{
+			TilePosition2D sum;
+			for (std::uint64_t i = 0; i < iterations; ++i)
+				sum += TilePosition2D(inputs.positions[i & inputMask]);
+
+			Benchmark::keep(sum);
+		});
+	}
+
+	void addMailboxCases(Benchmark & benchmark)
+	{
+		//The handoff alone, with a thread echoing the commands back as it finds them
+		benchmark.add("CommandMailbox/roundTrip", [](std::uint64_t iterations)
+		{
+			CommandMailbox mailbox;
+			std::atomic<bool> done {false};
+
+			std::thread echo([&]
+			{
+				Command command;
+				while (!done.load(std::memory_order_relaxed))
+					if (mailbox.take(command))
+						mailbox.reply(std::move(command));
+			});
+
+			Command command {};
+			command.valid = true;
+			command.destination = Command::Destination::Turtle;
+			command.data.turtle.command = Command::Turtle::Command::Get;
+
+			Command reply;
+			for (std::uint64_t i = 0; i < iterations; ++i)
+			{
+				const quint32 sequence = mailbox.post(command, []{ return true; });
+				mailbox.wait(sequence, reply, []{ return true; });
+				Benchmark::keep(reply);
+			}
+
+			done.store(true, std::memory_order_relaxed);
+			echo.join();
+		});
+
+		//The baseline the mailbox replaced, also with no actor behind it
+		//The command went to the controller's thread as a queued signal, and the reply came
+		// back as a queued call quitting an event loop the brain waited in.
+		benchmark.add("EventLoop/roundTrip", [](std::uint64_t iterations)
+		{
+			QObject controller;
+			QEventLoop loop;
+
+			Command command {};
+			command.valid = true;
+			command.destination = Command::Destination::Turtle;
+			command.data.turtle.command = Command::Turtle::Command::Get;
+
+			std::thread brain([&]
+			{
+				QEventLoop idle;
+				Command reply;
+
+				for (std::uint64_t i = 0; i < iterations; ++i)
+				{
+					QMetaObject::invokeMethod(&controller, [&idle, &reply, command]
+					{
+						reply = command;
+						QMetaObject::invokeMethod(&idle, &QEventLoop::quit, Qt::QueuedConnection);
+					}, Qt::QueuedConnection);
+
+					idle.exec();
+					Benchmark::keep(reply);
+				}
+
+				QMetaObject::invokeMethod(&loop, &QEventLoop::quit, Qt::QueuedConnection);
+			});
+
+			loop.exec();
+			brain.join();
+		});
+	}
+
+	void addWorldCases(Benchmark & benchmark, const Inputs & inputs)
+	{
+		static World world;
+		world.resize({halfSize, halfSize});
+		world.reset();
+
+		benchmark.add("World/edge", [&inputs](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; ++i)
+				Benchmark::keep(world.edge(inputs.positions[i & inputMask], inputs.positions[(i + 1) & inputMask], {0.5, 0.5}));
+		});
+
+		benchmark.add("World/clamp", [&inputs](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; ++i)
+				Benchmark::keep(world.clamp(inputs.positions[i & inputMask], {0.5, 0.5}));
+		});
+
+		benchmark.add("TurtleActor/updateTileSensor", [](std::uint64_t iterations)
+		{
+			SensorTurtle turtle(world);
+			turtle.reset();
+
+			for (std::uint64_t i = 0; i < iterations; ++i)
+				turtle.updateTileSensor();
+		});
+
+		benchmark.add("ThreadedBrain/sendCommand/Get", [](std::uint64_t iterations)
+		{
+			TurtleActorController controller(world.mainActor());
+
+			Command command {};
+			command.valid = true;
+			command.destination = Command::Destination::Turtle;
+			command.data.turtle.command = Command::Turtle::Command::Get;
+			command.data.turtle.target = Command::Turtle::Target::Current;
+
+			roundTrip(controller, command, iterations);
+		});
+
+		benchmark.add("ThreadedBrain/sendCommand/Set", [](std::uint64_t iterations)
+		{
+			//In instant mode the reply does not wait for the world to step
+			TurtleActorController controller(world.mainActor());
+			controller.setInstant(true);
+
+			Command command {};
+			command.valid = true;
+			command.destination = Command::Destination::Turtle;
+			command.data.turtle.command = Command::Turtle::Command::Set;
+			command.data.turtle.target = Command::Turtle::Target::Current;
+			command.data.turtle.setHeading = true;
+			command.data.turtle.angle = 0.25;
+
+			roundTrip(controller, command, iterations);
+			controller.setInstant(false);
+		});
+
+		benchmark.add("ThreadedBrain/sendCommand/Log", [](std::uint64_t iterations)
+		{
+			TurtleActorController controller(world.mainActor());
+
+			Command command {};
+			command.valid = true;
+			command.destination = Command::Destination::UI;
+			command.data.ui().command = Command::UI::Command::Log;
+			command.data.ui().text = "Benchmark";
+
+			roundTrip(controller, command, iterations);
+		});
+	}
+}
+
+int main(int argc, char** argv)
+{
+	QCoreApplication qapp(argc, argv);
+	QCoreApplication::setApplicationName("turtle-bench");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Times the hot paths of the simulation, printing the results as JSON.");
+	parser.addHelpOption();
+
+	const QCommandLineOption filterOption("filter", "Run only the cases matching a regular expression.", "pattern", ".");
+	const QCommandLineOption samplesOption("samples", "Samples taken of each case.", "count", "10");
+	const QCommandLineOption sampleTimeOption("sample-time", "Duration of each sample, in milliseconds.", "ms", "50");
+	const QCommandLineOption seedOption("seed", "Seed of the random inputs.", "seed", "1");
+	const QCommandLineOption outputOption("output", "Write the results to a file instead of the standard output.", "file");
+	const QCommandLineOption listOption("list", "List the cases instead of running them.");
+
+	parser.addOptions({filterOption, samplesOption, sampleTimeOption, seedOption, outputOption, listOption});
+	parser.process(qapp);
+
+	Benchmark::Options options;
+	options.filter.setPattern(parser.value(filterOption));
+	options.samples = parser.value(samplesOption).toInt();
+	options.sampleSeconds = parser.value(sampleTimeOption).toDouble() * 1e-3;
+	options.seed = parser.value(seedOption).toUInt();
+
+	QTextStream err(stderr);
+	if (!options.filter.isValid())
+	{
+		err << "Invalid filter: " << options.filter.errorString() << "\n";
+		return 1;
+	}
+
+	const Inputs inputs(options.seed);
+
+	Benchmark benchmark(options);
+	addFloorCases(benchmark, inputs);
+	addTypesCases(benchmark, inputs);
+	addMailboxCases(benchmark);
+	addWorldCases(benchmark, inputs);
+
+	if (parser.isSet(listOption))
+	{
+		QTextStream(stdout) << benchmark.names().join("\n") << "\n";
+		return 0;
+	}
+
+	QJsonObject results = benchmark.run();
+	results.insert("benchmark", "turtle-bench");
+
+	const QByteArray json = QJsonDocument(results).toJson();
+
+	if (!parser.isSet(outputOption))
+	{
+		QTextStream(stdout) << json;
+		return 0;
+	}
+
+	QFile file(parser.value(outputOption));
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || (file.write(json) != json.size()))
+	{
+		err << "Could not write the results to " << file.fileName() << "\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,357 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	//A run of one of the algorithms of Main(), on a generated floor
+	struct Scenario
+	{
+		QString name;
+		QJsonObject parameters;
+
+		//Half-size of the field, when there is no image
+		int fieldSize;
+		QImage image;
+
+		//Starting with the algorithm selection of Main()
+		QStringList answers;
+	};
+
+	//The indices of the algorithms in Main()
+	enum Algorithm
+	{
+		GotoTopRight = 0,
+		Draw = 1,
+		Follow = 2,
+		Adder = 3,
+		MazeSolverWall = 4,
+	};
+
+	QImage blankImage(int halfSize)
+	{
+		QImage image(2 * halfSize + 1, 2 * halfSize + 1, QImage::Format_RGB32);
+		image.fill(Qt::white);
+		return image;
+	}
+
+	//A perfect maze of cells by cells, as expected by MazeSolverWall
+	//The paths are black and one tile wide, with the entrance on the bottom row
+	// and the exit on the top one.
+	QImage maze(int cells, std::mt19937 & random)
+	{
+		QImage image = blankImage(cells);
+		auto carve = [&image](int x, int y) { image.setPixelColor(x, y, Qt::black); };
+
+		std::vector<bool> visited(static_cast<size_t>(cells * cells), false);
+		std::vector<std::pair<int,int>> stack {{0, 0}};
+		visited[0] = true;
+		carve(1, 1);
+
+		//Depth first, knocking down the wall to a random unvisited neighbour
+		static const std::pair<int,int> steps[] = {{1,0}, {-1,0}, {0,1}, {0,-1}};
+		while (!stack.empty())
+		{
+			const auto [x, y] = stack.back();
+
+			std::vector<std::pair<int,int>> next;
+			for (const auto & [dx, dy] : steps)
+			{
+				const int nx = x + dx;
+				const int ny = y + dy;
+				if ((nx >= 0) && (ny >= 0) && (nx < cells) && (ny < cells) && !visited[static_cast<size_t>(ny * cells + nx)])
+					next.push_back({nx, ny});
+			}
+
+			if (next.empty())
+			{
+				stack.pop_back();
+				continue;
+			}
+
+			const auto [nx, ny] = next[std::uniform_int_distribution<size_t>(0, next.size() - 1)(random)];
+			visited[static_cast<size_t>(ny * cells + nx)] = true;
+			carve(x + nx + 1, y + ny + 1);
+			carve(2 * nx + 1, 2 * ny + 1);
+			stack.push_back({nx, ny});
+		}
+
+		std::uniform_int_distribution<int> cell(0, cells - 1);
+		carve(2 * cell(random) + 1, image.height() - 1);
+		carve(2 * cell(random) + 1, 0);
+
+		return image;
+	}
+
+	//A square spiral path out of the origin, as followed by Follow
+	//The arms are two tiles apart, so the turtle never sees the next one.
+	QImage spiral(int radius)
+	{
+		QImage image = blankImage(radius + 1);
+		const int center = radius + 1;
+
+		int x = 0;
+		int y = 0;
+		int dx = 1;
+		int dy = 0;
+
+		//The Y axis of the image points down
+		image.setPixelColor(center, center, Qt::black);
+		for (int arm = 0, length = 2;; ++arm, length += (arm % 2) ? 0 : 2)
+		{
+			for (int i = 0; i < length; ++i)
+			{
+				if ((std::abs(x + dx) > radius) || (std::abs(y + dy) > radius))
+					return image;
+
+				x += dx;
+				y += dy;
+				image.setPixelColor(center + x, center - y, Qt::black);
+			}
+
+			//Turn left
+			std::swap(dx, dy);
+			dx = -dx;
+		}
+	}
+
+	std::vector<Scenario> scenarios(quint32 seed)
+	{
+		std::mt19937 random(seed);
+		std::vector<Scenario> list;
+
+		for (const int size : {20, 100, 500})
+			list.push_back({
+				QString("gotoTR/%1").arg(size),
+				{{"field", size}},
+				size, {},
+				{QString::number(GotoTopRight)}});
+
+		for (const int radius : {10, 25, 49})
+			list.push_back({
+				QString("Draw/%1").arg(radius),
+				{{"radius", radius}},
+				radius + 2, {},
+				{QString::number(Draw), QString::number(radius)}});
+
+		for (const int radius : {10, 50, 200})
+			list.push_back({
+				QString("Follow/%1").arg(radius),
+				{{"radius", radius}},
+				0, spiral(radius),
+				{QString::number(Follow)}});
+
+		for (const int bits : {8, 16, 32})
+		{
+			//Small enough for the sum to fit
+			std::uniform_int_distribution<int> number(0, (1 << (std::min(bits, 31) - 1)) - 1);
+			const int first = number(random);
+			const int second = number(random);
+
+			list.push_back({
+				QString("Adder/%1").arg(bits),
+				{{"bits", bits}, {"first", first}, {"second", second}},
+				bits + 4, {},
+				{QString::number(Adder), QString::number(bits), "2", QString::number(first), QString::number(second)}});
+		}
+
+		for (const int cells : {8, 32, 128})
+			list.push_back({
+				QString("MazeSolverWall/%1").arg(cells),
+				{{"cells", cells}},
+				0, maze(cells, random),
+				{QString::number(MazeSolverWall), "1"}});
+
+		return list;
+	}
+
+	struct Settings
+	{
+		QString runner;
+		bool instant;
+		quint64 maxSteps;
+		int repeat;
+	};
+
+	//Run a scenario with turtle-run, returning its report
+	QJsonObject run(const Scenario & scenario, const Settings & settings, QString & error)
+	{
+		QTemporaryDir directory;
+		if (!directory.isValid())
+		{
+			error = "Could not create a temporary directory";
+			return {};
+		}
+
+		const QString report = directory.filePath("report.json");
+
+		QStringList arguments {"--quiet", "--report", report, "--max-steps", QString::number(settings.maxSteps)};
+
+		if (settings.instant)
+			arguments << "--instant";
+
+		if (scenario.image.isNull())
+			arguments << "--size" << QString::number(scenario.fieldSize);
+		else
+		{
+			const QString image = directory.filePath("floor.png");
+			if (!scenario.image.save(image))
+			{
+				error = "Could not save the floor";
+				return {};
+			}
+
+			arguments << "--image" << image;
+		}
+
+		for (const QString & answer : scenario.answers)
+			arguments << "--input" << answer;
+
+		QProcess process;
+		process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+		process.start(settings.runner, arguments);
+
+		if (!process.waitForFinished(-1) || (process.exitStatus() != QProcess::NormalExit))
+		{
+			error = "Could not run " + settings.runner + ": " + process.errorString();
+			return {};
+		}
+
+		QFile file(report);
+		if (!file.open(QIODevice::ReadOnly))
+		{
+			error = "No report from " + settings.runner;
+			return {};
+		}
+
+		return QJsonDocument::fromJson(file.readAll()).object();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	QCoreApplication qapp(argc, argv);
+	QCoreApplication::setApplicationName("turtle-scenarios");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription(
+				"Runs the bundled algorithms headless on generated floors, with turtle-run, "
+				"printing the results as JSON.");
+	parser.addHelpOption();
+
+	const QCommandLineOption filterOption("filter", "Run only the scenarios matching a regular expression.", "pattern", ".");
+	const QCommandLineOption repeatOption("repeat", "Run each scenario this many times, reporting the fastest run.", "count", "1");
+	const QCommandLineOption seedOption("seed", "Seed of the generated floors and numbers.", "seed", "1");
+	const QCommandLineOption animatedOption("animated", "Animate the motion commands, instead of completing them at once.");
+	const QCommandLineOption maxStepsOption("max-steps", "Stop a scenario after this many steps.", "steps", "100000000");
+	const QCommandLineOption runnerOption(
+				"runner",
+				"The turtle-run executable.",
+				"file",
+				QDir(QCoreApplication::applicationDirPath()).filePath("turtle-run"));
+	const QCommandLineOption outputOption("output", "Write the results to a file instead of the standard output.", "file");
+	const QCommandLineOption listOption("list", "List the scenarios instead of running them.");
+
+	parser.addOptions({
+		filterOption, repeatOption, seedOption, animatedOption, maxStepsOption,
+		runnerOption, outputOption, listOption});
+
+	parser.process(qapp);
+
+	const QRegularExpression filter(parser.value(filterOption));
+	const quint32 seed = parser.value(seedOption).toUInt();
+
+	Settings settings;
+	settings.runner = parser.value(runnerOption);
+	settings.instant = !parser.isSet(animatedOption);
+	settings.maxSteps = parser.value(maxStepsOption).toULongLong();
+	settings.repeat = std::max(1, parser.value(repeatOption).toInt());
+
+	QTextStream err(stderr);
+	if (!filter.isValid())
+	{
+		err << "Invalid filter: " << filter.errorString() << "\n";
+		return 1;
+	}
+
+	const std::vector<Scenario> list = scenarios(seed);
+
+	if (parser.isSet(listOption))
+	{
+		QTextStream out(stdout);
+		for (const Scenario & scenario : list)
+			out << scenario.name << "\n";
+
+		return 0;
+	}
+
+	QJsonArray results;
+	for (const Scenario & scenario : list)
+	{
+		if (!filter.match(scenario.name).hasMatch())
+			continue;
+
+		err << scenario.name << "\n";
+		err.flush();
+
+		QJsonObject fastest;
+		for (int i = 0; i < settings.repeat; ++i)
+		{
+			QString error;
+			const QJsonObject report = run(scenario, settings, error);
+			if (report.isEmpty())
+			{
+				err << error << "\n";
+				return 1;
+			}
+
+			if (fastest.isEmpty() || (report["wall_seconds"].toDouble() < fastest["wall_seconds"].toDouble()))
+				fastest = report;
+		}
+
+		fastest.insert("name", scenario.name);
+		fastest.insert("parameters", scenario.parameters);
+		results.append(fastest);
+	}
+
+	const QJsonObject document
+	{
+		{"benchmark", "turtle-scenarios"},
+		{"seed", static_cast<qint64>(seed)},
+		{"instant", settings.instant},
+		{"repeat", settings.repeat},
+		{"scenarios", results}
+	};
+
+	const QByteArray json = QJsonDocument(document).toJson();
+
+	if (!parser.isSet(outputOption))
+	{
+		QTextStream(stdout) << json;
+		return 0;
+	}
+
+	QFile file(parser.value(outputOption));
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || (file.write(json) != json.size()))
+	{
+		err << "Could not write the results to " << file.fileName() << "\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -2,44 +2,104 @@
 #include "algorithms/utility.h"
 
 #include <functional>
+#include <optional>
 #include <vector>
 #include <utility>
 
-void Main(ThreadedBrain & brain)
+namespace
 {
 	using Algorithm = std::function<void(ThreadedBrain&)>;
 
-	std::vector<std::pair<Algorithm, QString>> algorithms =
+	const std::vector<std::pair<Algorithm, QString>> & algorithms()
 	{
-		{gotoTR, "Goto top-right"},
-		{Draw, "Draw"},
-		{Follow, "Follow"},
-		{Adder, "Adder"},
-		{MazeSolverWall, "Maze solver: Wall"},
-	};
+		static const std::vector<std::pair<Algorithm, QString>> list =
+		{
+			{gotoTR, "Goto top-right"},
+			{Draw, "Draw"},
+			{Follow, "Follow"},
+			{Adder, "Adder"},
+			{MazeSolverWall, "Maze solver: Wall"},
+			{Swarm, "Swarm"},
+			{LoadGenerator, "Load generator"},
+		};
+
+		return list;
+	}
 
-	QString algorithmList;
-	for (size_t i = 0; i < algorithms.size(); ++i)
+	template<typename List>
+	QString describe(const List & algorithms)
 	{
-		algorithmList.append(QString::number(i) + ": ");
-		algorithmList.append(algorithms[i].second);
-		algorithmList.append("\n");
+		QString algorithmList;
+		for (size_t i = 0; i < algorithms.size(); ++i)
+		{
+			algorithmList.append(QString::number(i) + ": ");
+			algorithmList.append(algorithms[i].second);
+			algorithmList.append("\n");
+		}
+
+		return algorithmList;
 	}
+}
+
+QString algorithmList()
+{
+	return describe(algorithms());
+}
+
+int algorithmCount()
+{
+	return static_cast<int>(algorithms().size());
+}
 
-	static int lastSelection = 0;
+void Main(ThreadedBrain & brain)
+{
+	//Each brain asks on its own, see Main(brain, algorithm) for asking once for all
 	bool ok;
-	lastSelection = brain.getInteger("Select an algorithm", algorithmList, lastSelection, &ok);
+	const int selection = brain.getInteger("Select an algorithm", algorithmList(), 0, &ok);
 	if (!ok)
 		return;
 
-	const size_t algorithm = static_cast<size_t>(lastSelection);
+	Main(brain, selection);
+}
+
+void Main(ThreadedBrain & brain, int selection)
+{
+	const size_t algorithm = static_cast<size_t>(selection);
 
-	if (algorithm >= algorithms.size())
+	if ((selection < 0) || (algorithm >= algorithms().size()))
 	{
 		brain.log("<b>Invalid selection!</b>");
 		return;
 	}
 
-	brain.log("Executing algorithm: <b>" + algorithms[algorithm].second + "</b>");
-	algorithms[algorithm].first(brain);
+	brain.log("Executing algorithm: <b>" + algorithms()[algorithm].second + "</b>");
+	algorithms()[algorithm].first(brain);
+}
+
+Turtle::Task MainAsync(ThreadedBrain & brain)
+{
+	using Algorithm = std::function<Turtle::Task(ThreadedBrain&)>;
+
+	std::vector<std::pair<Algorithm, QString>> algorithms =
+	{
+		{FollowAsync, "Follow"},
+	};
+
+	const QString algorithmList = describe(algorithms);
+
+	//The worker runs other brains while this one waits for the answer
+	const std::optional<int> selection = co_await brain.getIntegerAsync("Select an algorithm", algorithmList, 0);
+	if (!selection)
+		co_return;
+
+	const size_t algorithm = static_cast<size_t>(*selection);
+
+	if ((*selection < 0) || (algorithm >= algorithms.size()))
+	{
+		co_await brain.logAsync("<b>Invalid selection!</b>");
+		co_return;
+	}
+
+	co_await brain.logAsync("Executing algorithm: <b>" + algorithms[algorithm].second + "</b>");
+	co_await algorithms[algorithm].first(brain);
 }
@@ -2,13 +2,30 @@
 #define MAINBRAIN_H
 
 #include "ThreadedBrain.h"
+#include "BrainTask.h"
 
+//Ask the brain for an algorithm, and run it
 void Main(ThreadedBrain &brain);
 
+//Run one of the algorithms of Main() right away, by its index
+void Main(ThreadedBrain &brain, int algorithm);
+
+//The algorithms of Main(), one per line with their index, and their number
+QString algorithmList();
+int algorithmCount();
+
+//The entry point of brains run as tasks, see CoroutineBrainController
+Turtle::Task MainAsync(ThreadedBrain &brain);
+
 void Draw(ThreadedBrain &brain);
 void Follow(ThreadedBrain &brain);
+Turtle::Task FollowAsync(ThreadedBrain &brain);
 void Adder(ThreadedBrain &brain);
 
 void MazeSolverWall(ThreadedBrain &brain);
 
+void Swarm(ThreadedBrain &brain);
+
+void LoadGenerator(ThreadedBrain &brain);
+
 #endif // MAINBRAIN_H
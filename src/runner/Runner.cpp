@@ -0,0 +1,292 @@
+#include "Runner.h"
+#include "JournalReplay.h"
+#include "CommandStatistics.h"
+#include "Trace.h"
+
+#include <QFile>
+#include <QImage>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+
+#ifdef _WIN32
+#	include <windows.h>
+#	include <psapi.h>
+#else
+#	include <sys/resource.h>
+#endif
+
+Runner::Runner(const Options & options, QObject *parent) :
+	QObject(parent),
+	options{options},
+	out{stdout},
+	world{},
+	steps{0},
+	commands{0},
+	running{0},
+	timedOut{false}
+{
+	world.setStepThreads(options.stepThreads);
+	world.setUnbounded(options.unbounded);
+
+	//The world is set up from the journal
+	if (!options.replay.isEmpty())
+		return;
+
+	if (options.coroutineThreads)
+		coroutines = std::make_unique<Turtle::CoroutineScheduler>(options.coroutineThreads);
+	else if (options.fiberThreads)
+		scheduler = std::make_unique<Turtle::FiberScheduler>(options.fiberThreads);
+
+	world.resize({options.fieldSize, options.fieldSize});
+
+	while (world.turtleCount() < std::max<size_t>(options.turtles, 1))
+		world.addTurtle();
+
+	for (size_t i = 0; i < world.turtleCount(); ++i)
+	{
+		TurtleActor & turtle = world.turtle(i);
+		TurtleAgent * agent = coroutines ?
+					new TurtleAgent(turtle, *coroutines, this) :
+					new TurtleAgent(turtle, scheduler.get(), this);
+		agents.push_back(agent);
+
+		//Each brain gets the same answers
+		userInputs.push_back(std::make_unique<Turtle::ScriptedUserInput>(options.answers, options.acceptDefaults));
+		agent->controller()->setUserInput(userInputs.back().get());
+		agent->controller()->setInstant(options.instant);
+		agent->controller()->setJournal(&journal, static_cast<quint32>(i));
+
+		//Only name the turtles when there are several
+		const QString name = (world.turtleCount() > 1) ? turtle.name() : QString{};
+
+		connect(agent->controller(), &TurtleActorController::log,
+				[this, name](QString text, QString title) {log(name, text, title);});
+		connect(agent->controller(), &TurtleActorController::signalCommand, [this]{++commands;});
+		connect(agent, &TurtleAgent::stopped, this, &Runner::stopped);
+	}
+
+	//A zero interval runs whenever there are no events, so commands are
+	// still taken from the brains between steps
+	stepTimer.setInterval(0);
+	connect(&stepTimer, &QTimer::timeout, this, &Runner::step);
+
+	world.reset();
+
+	if (!options.image.isEmpty())
+		world.setImage(QImage{options.image});
+}
+
+Runner::~Runner()
+{
+	world.floor().removeObserver(&tileCounter);
+
+	//The agents control the world's turtles, so they go first
+	for (auto agent = agents.rbegin(); agent != agents.rend(); ++agent)
+		delete *agent;
+}
+
+void Runner::start()
+{
+	//Added last, so loading the floor is not counted
+	world.floor().addObserver(&tileCounter);
+
+	if (!options.trace.isEmpty())
+		Turtle::Trace::start();
+
+	if (!options.metrics.isEmpty())
+		metrics = std::make_unique<MetricsFile>(options.metrics, options.metricsInterval);
+
+	if (!options.replay.isEmpty())
+	{
+		//Once the event loop runs, so finished() is seen
+		QTimer::singleShot(0, this, &Runner::replay);
+		return;
+	}
+
+	if (!options.journal.isEmpty() && !journal.open(options.journal, world))
+	{
+		out << "Could not write the journal to " << options.journal << "\n";
+		out.flush();
+	}
+
+	running = agents.size();
+
+	elapsed.start();
+	stepTimer.start();
+
+	for (TurtleAgent * agent : agents)
+		agent->start();
+}
+
+void Runner::step()
+{
+	for (int i = 0; i < options.stepsPerTick; ++i)
+		world();
+
+	steps += static_cast<quint64>(options.stepsPerTick);
+
+	if (options.maxSteps && (steps >= options.maxSteps) && !timedOut)
+	{
+		timedOut = true;
+		out << "Step limit reached" << "\n";
+		out.flush();
+
+		for (TurtleAgent * agent : agents)
+			agent->stop();
+	}
+}
+
+void Runner::stopped()
+{
+	//Wait for all of them
+	if (--running)
+		return;
+
+	stepTimer.stop();
+	journal.close();
+
+	finish(timedOut ? 2 : 0);
+}
+
+void Runner::replay()
+{
+	elapsed.start();
+
+	Turtle::JournalReplay replay(world);
+	if (!replay.open(options.replay))
+	{
+		out << "Could not read the journal from " << options.replay << "\n";
+		out.flush();
+		emit finished(1);
+		return;
+	}
+
+	const bool complete = replay.run();
+	if (!complete)
+	{
+		out << "The journal ended early" << "\n";
+		out.flush();
+	}
+
+	steps = world.stepCount();
+	commands = replay.commands();
+
+	finish(complete ? 0 : 1);
+}
+
+void Runner::finish(int code)
+{
+	if (!options.trace.isEmpty())
+	{
+		Turtle::Trace::stop();
+		if (!Turtle::Trace::save(options.trace))
+		{
+			out << "Could not write the trace to " << options.trace << "\n";
+			out.flush();
+			code = 1;
+		}
+	}
+
+	const double seconds = static_cast<double>(elapsed.nsecsElapsed()) * 1e-9;
+	const double stepRate = (seconds > 0) ? static_cast<double>(steps) / seconds : 0;
+	const double commandRate = (seconds > 0) ? static_cast<double>(commands) / seconds : 0;
+	const quint64 memory = peakMemory();
+
+	out
+			<< "Turtles: " << world.turtleCount() << "\n"
+			<< "Steps: " << steps << "\n"
+			<< "Commands: " << commands << "\n"
+			<< "Tiles written: " << tileCounter.tiles << "\n"
+			<< "Wall time [s]: " << seconds << "\n"
+			<< "Steps/s: " << stepRate << "\n"
+			<< "Commands/s: " << commandRate << "\n"
+			<< "Peak memory [MB]: " << static_cast<double>(memory) / (1 << 20) << "\n";
+
+	if (!Turtle::CommandStatistics::global().isEmpty())
+		out << "\n" << Turtle::CommandStatistics::global().report();
+
+	out.flush();
+
+	if (!options.output.isEmpty() && !world.floor().fitsImage())
+	{
+		out << "The floor is too large to save as an image, use a smaller --size\n";
+		out.flush();
+		code = 1;
+	}
+	else if (!options.output.isEmpty() && !world.floor().image().save(options.output))
+	{
+		out << "Could not save the floor to " << options.output << "\n";
+		out.flush();
+		code = 1;
+	}
+
+	if (!options.report.isEmpty())
+	{
+		const QJsonObject report
+		{
+			{"code", code},
+			{"turtles", static_cast<qint64>(world.turtleCount())},
+			{"steps", static_cast<qint64>(steps)},
+			{"commands", static_cast<qint64>(commands)},
+			{"tiles_written", static_cast<qint64>(tileCounter.tiles)},
+			{"wall_seconds", seconds},
+			{"steps_per_second", stepRate},
+			{"commands_per_second", commandRate},
+			{"peak_memory_bytes", static_cast<qint64>(memory)}
+		};
+
+		const QByteArray json = QJsonDocument(report).toJson();
+
+		QFile file(options.report);
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || (file.write(json) != json.size()))
+		{
+			out << "Could not write the report to " << options.report << "\n";
+			out.flush();
+			code = 1;
+		}
+	}
+
+	emit finished(code);
+}
+
+quint64 Runner::peakMemory()
+{
+#	ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.PeakWorkingSetSize;
+#	else
+	rusage usage;
+	if (!getrusage(RUSAGE_SELF, &usage))
+	{
+		//Reported in bytes by macOS, and in kilobytes by the rest
+#		ifdef __APPLE__
+		return static_cast<quint64>(usage.ru_maxrss);
+#		else
+		return static_cast<quint64>(usage.ru_maxrss) * 1024;
+#		endif
+	}
+#	endif
+
+	return 0;
+}
+
+void Runner::log(const QString & name, QString text, QString title)
+{
+	if (!options.log)
+		return;
+
+	//The log is meant for a rich text view
+	static const QRegularExpression tags("<[^>]*>");
+	text.remove(tags);
+
+	if (!name.isEmpty())
+		out << name << ": ";
+
+	if (!title.isEmpty())
+		out << title << ": ";
+
+	out << text << "\n";
+	out.flush();
+}
@@ -0,0 +1,143 @@
+#ifndef RUNNER_H
+#define RUNNER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QTextStream>
+
+#include <memory>
+#include <vector>
+
+#include "World.h"
+#include "TurtleAgent.h"
+#include "FiberScheduler.h"
+#include "CoroutineScheduler.h"
+#include "ScriptedUserInput.h"
+#include "CommandJournal.h"
+#include "MetricsFile.h"
+
+//Runs the world and its brains without any graphics, stepping as fast as possible
+class Runner : public QObject
+{
+	Q_OBJECT
+public:
+	struct Options
+	{
+		//Half-size of the field, in tiles
+		size_t fieldSize = 20;
+
+		//Let the turtles go beyond the field, see World::setUnbounded()
+		bool unbounded = false;
+
+		//An image to load as the floor, instead of a clear one
+		QString image;
+
+		//Save the floor here when done
+		QString output;
+
+		//Answers to each brain's input requests, see ScriptedUserInput
+		QStringList answers;
+		bool acceptDefaults = false;
+
+		//Stop the brains after this many steps, or never when 0
+		quint64 maxSteps = 0;
+
+		//Complete motion commands at once, see TurtleActor::instant()
+		bool instant = false;
+
+		//Steps to run between event processing
+		int stepsPerTick = 1;
+
+		//Threads stepping the world, see World::setStepThreads()
+		unsigned stepThreads = 0;
+
+		//Turtles in the world, each with a brain of its own
+		size_t turtles = 1;
+
+		//Run the brains on fibers over this many threads, or each on its own thread when 0
+		unsigned fiberThreads = 0;
+
+		//Run the brains as coroutines over this many threads, see CoroutineBrainController
+		//Takes precedence over fiberThreads.
+		unsigned coroutineThreads = 0;
+
+		//Print the brains' log
+		bool log = true;
+
+		//Record the commands to this journal, see Turtle::CommandJournal
+		QString journal;
+
+		//Replay this journal instead of running the brains, see Turtle::JournalReplay
+		QString replay;
+
+		//Write the statistics to this file as JSON when done
+		QString report;
+
+		//Record the spans of the whole run to this file, see Turtle::Trace
+		QString trace;
+
+		//Write the runtime metrics to this file every metricsInterval seconds, see MetricsFile
+		QString metrics;
+		int metricsInterval = 10;
+	};
+
+	explicit Runner(const Options & options, QObject *parent = nullptr);
+
+	//Stops the brains
+	~Runner() override;
+
+	//Start running, emitting finished() with the exit code when all the brains stop
+	void start();
+
+signals:
+	void finished(int code);
+
+private:
+	void step();
+	void stopped();
+	void replay();
+
+	//Print the statistics, save the floor and finish
+	void finish(int code);
+	void log(const QString & name, QString text, QString title);
+
+	//The most memory the process used so far, in bytes, or 0 when unknown
+	static quint64 peakMemory();
+
+	//Counts the tiles written to the floor
+	class TileCounter : public Turtle::FloorObserver
+	{
+	public:
+		void floorChanged(const Turtle::TiledFloor &) override {}
+		void tileChanged(const Turtle::TiledFloor &, const Turtle::TilePosition2D &, QRgb) override { ++tiles; }
+
+		quint64 tiles = 0;
+	};
+
+	Options options;
+	QTextStream out;
+
+	Turtle::World world;
+	std::unique_ptr<Turtle::FiberScheduler> scheduler;
+	std::unique_ptr<Turtle::CoroutineScheduler> coroutines;
+	std::vector<std::unique_ptr<Turtle::ScriptedUserInput>> userInputs;
+	std::vector<TurtleAgent*> agents;
+
+	//Closed before the world goes
+	Turtle::CommandJournal journal;
+
+	TileCounter tileCounter;
+
+	std::unique_ptr<MetricsFile> metrics;
+
+	QTimer stepTimer;
+	QElapsedTimer elapsed;
+
+	quint64 steps;
+	quint64 commands;
+	size_t running;
+	bool timedOut;
+};
+
+#endif // RUNNER_H
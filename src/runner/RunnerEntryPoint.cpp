@@ -0,0 +1,99 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+#include <algorithm>
+
+#include "Runner.h"
+
+int main(int argc, char** argv)
+{
+	QCoreApplication qapp(argc, argv);
+	QCoreApplication::setApplicationName("turtle-run");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Runs the turtle brain without a user interface, as fast as possible.");
+	parser.addHelpOption();
+
+	const QCommandLineOption sizeOption("size", "Half-size of the field, in tiles.", "tiles", "20");
+	const QCommandLineOption unboundedOption(
+				"unbounded",
+				"Let the turtles go and draw beyond the field, which is then only the part saved by --output.");
+	const QCommandLineOption imageOption("image", "Load the floor from an image file.", "file");
+	const QCommandLineOption outputOption("output", "Save the floor to an image file when done.", "file");
+	const QCommandLineOption inputOption(
+				"input",
+				"Answer the next input request of the brain. May be repeated.",
+				"answer");
+	const QCommandLineOption defaultsOption("accept-defaults", "Accept the default of input requests left unanswered.");
+	const QCommandLineOption maxStepsOption("max-steps", "Stop the brain after this many steps.", "steps", "0");
+	const QCommandLineOption instantOption("instant", "Complete motion commands at once, without animating them.");
+	const QCommandLineOption turtlesOption("turtles", "Number of turtles, each with a brain of its own.", "count", "1");
+	const QCommandLineOption fibersOption(
+				"fibers",
+				"Run the brains on fibers over this many threads, instead of a thread each.",
+				"threads", "0");
+	const QCommandLineOption coroutinesOption(
+				"coroutines",
+				"Run the brains as coroutines over this many threads, with the asynchronous algorithms.",
+				"threads", "0");
+	const QCommandLineOption stepThreadsOption(
+				"step-threads",
+				"Threads stepping the world, or 0 for one per hardware thread.",
+				"threads", "0");
+	const QCommandLineOption batchOption("batch", "Steps to run between event processing.", "steps", "1");
+	const QCommandLineOption quietOption("quiet", "Do not print the brain's log.");
+	const QCommandLineOption journalOption("journal", "Record all the commands and replies to a journal file.", "file");
+	const QCommandLineOption reportOption("report", "Write the statistics to a JSON file when done.", "file");
+	const QCommandLineOption traceOption("trace", "Record a trace of the run, to view in chrome://tracing or Perfetto.", "file");
+	const QCommandLineOption metricsOption(
+				"metrics",
+				"Write the runtime metrics to a file, in the Prometheus text format.",
+				"file");
+	const QCommandLineOption metricsIntervalOption(
+				"metrics-interval",
+				"Seconds between writes of the metrics file.",
+				"seconds", "10");
+	const QCommandLineOption replayOption(
+				"replay",
+				"Replay a journal file instead of running the brain, reproducing its floor.",
+				"file");
+
+	parser.addOptions({
+		sizeOption, unboundedOption, imageOption, outputOption,
+		inputOption, defaultsOption,
+		maxStepsOption, instantOption, batchOption,
+		turtlesOption, fibersOption, coroutinesOption, stepThreadsOption, quietOption,
+		journalOption, replayOption, reportOption, traceOption,
+		metricsOption, metricsIntervalOption});
+
+	parser.process(qapp);
+
+	Runner::Options options;
+	options.fieldSize = parser.value(sizeOption).toULong();
+	options.unbounded = parser.isSet(unboundedOption);
+	options.image = parser.value(imageOption);
+	options.output = parser.value(outputOption);
+	options.answers = parser.values(inputOption);
+	options.acceptDefaults = parser.isSet(defaultsOption);
+	options.maxSteps = parser.value(maxStepsOption).toULongLong();
+	options.instant = parser.isSet(instantOption);
+	options.stepsPerTick = std::max(1, parser.value(batchOption).toInt());
+	options.turtles = std::max<size_t>(1, parser.value(turtlesOption).toULong());
+	options.fiberThreads = parser.value(fibersOption).toUInt();
+	options.coroutineThreads = parser.value(coroutinesOption).toUInt();
+	options.stepThreads = parser.value(stepThreadsOption).toUInt();
+	options.log = !parser.isSet(quietOption);
+	options.journal = parser.value(journalOption);
+	options.replay = parser.value(replayOption);
+	options.report = parser.value(reportOption);
+	options.trace = parser.value(traceOption);
+	options.metrics = parser.value(metricsOption);
+	options.metricsInterval = parser.value(metricsIntervalOption).toInt();
+
+	Runner runner(options);
+	QObject::connect(&runner, &Runner::finished, &qapp, &QCoreApplication::exit);
+
+	runner.start();
+
+	return qapp.exec();
+}
@@ -0,0 +1,64 @@
+#The graphical application
+QT += core gui
+QT += widgets opengl
+
+TARGET = turtle
+TEMPLATE = app
+
+include(turtle.pri)
+include(turtle-core.pri)
+
+win32: {
+#Change this to point to where osg is installed
+INCLUDEPATH += ../../libraries/OpenSceneGraph/install/include
+LIBS += -L../../libraries/OpenSceneGraph/install/lib
+}
+
+LIBS += -lOpenThreads
+LIBS += -losg
+LIBS += -losgViewer
+LIBS += -losgGA
+LIBS += -losgDB
+LIBS += -losgUtil
+LIBS += -losgFX
+LIBS += -losgText
+
+SOURCES += \
+		ui/DialogUserInput.cpp \
+		ui/FloorRenderer.cpp \
+		ui/HudRenderer.cpp \
+		ui/ImageDisplay.cpp \
+		ui/MainEntryPoint.cpp \
+		ui/MainWindow.cpp \
+		ui/QtOSGMouseHandler.cpp \
+		ui/QtOSGWidget.cpp \
+		ui/Robot.cpp \
+		ui/Scene.cpp \
+		ui/StatisticsDialog.cpp \
+		ui/SwarmRenderer.cpp \
+		ui/TurtleRenderer.cpp \
+		ui/WorldRenderer.cpp
+
+HEADERS += \
+	ui/DialogUserInput.h \
+	ui/FloorRenderer.h \
+	ui/HudRenderer.h \
+	ui/ImageDisplay.h \
+	ui/MainWindow.h \
+	ui/OsgTypes.h \
+	ui/QtOSGMouseHandler.h \
+	ui/QtOSGWidget.h \
+	ui/Robot.h \
+	ui/Scene.h \
+	ui/StatisticsDialog.h \
+	ui/SwarmRenderer.h \
+	ui/TurtleRenderer.h \
+	ui/WorldRenderer.h
+
+FORMS += \
+	ui/MainWindow.ui
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,19 @@
+#Times the hot paths of the simulation core in isolation
+QT = core gui
+
+TARGET = turtle-bench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+include(turtle.pri)
+include(turtle-core.pri)
+
+INCLUDEPATH += $$PWD/bench
+
+SOURCES += \
+		bench/Benchmark.cpp \
+		bench/MicroBenchmarks.cpp
+
+HEADERS += \
+	bench/Benchmark.h
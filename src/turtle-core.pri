@@ -0,0 +1,6 @@
+#Link with the simulation core library
+
+LIBS += -L$$OUT_PWD/../bin -lturtle-core
+
+win32-msvc*: PRE_TARGETDEPS += $$OUT_PWD/../bin/turtle-core.lib
+else: PRE_TARGETDEPS += $$OUT_PWD/../bin/libturtle-core.a
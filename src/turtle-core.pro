@@ -0,0 +1,109 @@
+#The simulation core: the world, the actors, the brains and the algorithms
+#No widgets and no graphics, so it can run headless
+QT = core gui
+
+TARGET = turtle-core
+TEMPLATE = lib
+CONFIG += staticlib
+
+include(turtle.pri)
+
+#Let the compiler vectorize the kernels of SwarmActor
+#Only that file is built with relaxed math, the rest of the core keeps the defaults.
+VECTORIZED_SOURCES = ui/SwarmActor.cpp
+
+win32-msvc* {
+	SOURCES += $$VECTORIZED_SOURCES
+} else {
+	vectorized.input = VECTORIZED_SOURCES
+	vectorized.dependency_type = TYPE_C
+	vectorized.variable_out = OBJECTS
+	vectorized.output = ${QMAKE_VAR_OBJECTS_DIR}${QMAKE_FILE_IN_BASE}$${first(QMAKE_EXT_OBJ)}
+	vectorized.commands = $${QMAKE_CXX} $(CXXFLAGS) -ftree-vectorize -fno-math-errno -fno-trapping-math $(INCPATH) -c ${QMAKE_FILE_IN} -o ${QMAKE_FILE_OUT}
+	QMAKE_EXTRA_COMPILERS += vectorized
+}
+
+SOURCES += \
+		algorithms/Checker.cpp \
+		algorithms/adder.cpp \
+		algorithms/draw.cpp \
+		algorithms/follow.cpp \
+		algorithms/loadGenerator.cpp \
+		algorithms/mazeSolverWall.cpp \
+		algorithms/swarm.cpp \
+		algorithms/utility.cpp \
+		ui/Actor.cpp \
+		ui/Command.cpp \
+		ui/CommandJournal.cpp \
+		ui/CommandFuture.cpp \
+		ui/CommandMailbox.cpp \
+		ui/CommandStatistics.cpp \
+		ui/CoroutineBrainController.cpp \
+		ui/CoroutineRunner.cpp \
+		ui/CoroutineScheduler.cpp \
+		ui/DirtyRegion.cpp \
+		ui/Fiber.cpp \
+		ui/FiberBrainController.cpp \
+		ui/FiberScheduler.cpp \
+		ui/FloorImage.cpp \
+		ui/FloorMirror.cpp \
+		ui/FrameStatistics.cpp \
+		ui/JournalReplay.cpp \
+		ui/LatencyHistogram.cpp \
+		ui/MetricsFile.cpp \
+		ui/RuntimeMetrics.cpp \
+		ui/ScriptedUserInput.cpp \
+		ui/ThreadedBrain.cpp \
+		ui/ThreadedBrainController.cpp \
+		main.cpp \
+		ui/TileSensor.cpp \
+		ui/TiledFloor.cpp \
+		ui/TurtleActor.cpp \
+		ui/TurtleActorController.cpp \
+		ui/TurtleAgent.cpp \
+		ui/Trace.cpp \
+		ui/WorkStealingPool.cpp \
+		ui/World.cpp
+
+HEADERS += \
+	algorithms/Checker.h \
+	algorithms/utility.h \
+	ui/Actor.h \
+	ui/BrainTask.h \
+	ui/Command.h \
+	ui/CommandFuture.h \
+	ui/CommandJournal.h \
+	ui/CommandMailbox.h \
+	ui/CommandStatistics.h \
+	ui/CoroutineBrainController.h \
+	ui/CoroutineRunner.h \
+	ui/CoroutineScheduler.h \
+	ui/DirtyRegion.h \
+	ui/Fiber.h \
+	ui/FiberBrainController.h \
+	ui/FiberScheduler.h \
+	ui/FloorImage.h \
+	ui/FloorMirror.h \
+	ui/FloorObserver.h \
+	ui/FrameStatistics.h \
+	ui/JournalReplay.h \
+	ui/LatencyHistogram.h \
+	ui/MetricsFile.h \
+	ui/RuntimeMetrics.h \
+	ui/ScriptedUserInput.h \
+	ui/SeqLock.h \
+	ui/SpscRing.h \
+	ui/SwarmActor.h \
+	ui/ThreadedBrain.h \
+	ui/ThreadedBrainController.h \
+	main.h \
+	ui/TileSensor.h \
+	ui/TiledFloor.h \
+	ui/TurtleActor.h \
+	ui/TurtleActorController.h \
+	ui/TurtleAgent.h \
+	ui/Trace.h \
+	ui/Types.h \
+	ui/UserInput.h \
+	ui/WorkStealingPool.h \
+	ui/World.h
@@ -0,0 +1,25 @@
+#Runs the simulation core headless, for batch evaluation
+QT = core gui
+
+TARGET = turtle-run
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+include(turtle.pri)
+include(turtle-core.pri)
+
+SOURCES += \
+		runner/Runner.cpp \
+		runner/RunnerEntryPoint.cpp
+
+HEADERS += \
+	runner/Runner.h
+
+#For the peak memory
+win32: LIBS += -lpsapi
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,12 @@
+#Runs the bundled algorithms end to end with turtle-run, on generated floors
+QT = core gui
+
+TARGET = turtle-scenarios
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+include(turtle.pri)
+
+SOURCES += \
+		bench/ScenarioBenchmarks.cpp
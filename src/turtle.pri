@@ -0,0 +1,16 @@
+#Settings common to all the turtle projects
+
+#Needed for std::atomic::wait/notify
+CONFIG += c++2a
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += $$PWD $$PWD/ui
+
+DESTDIR = ../bin
+
+#All the projects are built in the same directory
+OBJECTS_DIR = .obj/$${TARGET}
+MOC_DIR = .moc/$${TARGET}
+RCC_DIR = .rcc/$${TARGET}
+UI_DIR = .ui/$${TARGET}
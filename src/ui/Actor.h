@@ -16,6 +16,14 @@ namespace Turtle
 		//Returns whether something changed
 		virtual bool operator()(int steps = 1) { Q_UNUSED(steps) return false;}
 
+		//Parallel stepping
+		//A buffered step may run concurrently with other actors' steps: it must keep its
+		// changes to the world aside, and must not call out. They are applied by commit(),
+		// which is called for all actors in a fixed order once the step is done.
+		virtual bool isParallel() const { return false; }
+		virtual void setBuffered(bool buffered) { Q_UNUSED(buffered) }
+		virtual void commit() {}
+
 		//The actor name
 		virtual const QString name() const { return m_name;}
 		explicit operator const QString() { return name();}
@@ -0,0 +1,95 @@
+#ifndef BRAINTASK_H
+#define BRAINTASK_H
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+namespace Turtle
+{
+	//A lazily started coroutine returning nothing
+	//A task is started and resumed by a CoroutineRunner, and may co_await
+	// command futures and other tasks.
+	class Task
+	{
+	public:
+		struct promise_type;
+		using Handle = std::coroutine_handle<promise_type>;
+
+		//Resume whoever awaited the task once it is done
+		struct FinalAwaiter
+		{
+			bool await_ready() const noexcept { return false; }
+			std::coroutine_handle<> await_suspend(Handle handle) noexcept
+			{
+				if (auto continuation = handle.promise().continuation)
+					return continuation;
+				return std::noop_coroutine();
+			}
+			void await_resume() const noexcept {}
+		};
+
+		struct promise_type
+		{
+			Task get_return_object() { return Task{Handle::from_promise(*this)}; }
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			FinalAwaiter final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { exception = std::current_exception(); }
+
+			std::coroutine_handle<> continuation;
+			std::exception_ptr exception;
+		};
+
+		Task() = default;
+		Task(Task && other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+		Task & operator=(Task && other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				m_handle = std::exchange(other.m_handle, {});
+			}
+			return *this;
+		}
+		Task(const Task &) = delete;
+		Task & operator=(const Task &) = delete;
+		~Task() { reset(); }
+
+		explicit operator bool() const { return static_cast<bool>(m_handle); }
+
+		bool done() const { return !m_handle || m_handle.done(); }
+
+		//The exception that ended the task, if any
+		std::exception_ptr exception() const { return m_handle ? m_handle.promise().exception : nullptr; }
+
+		Handle handle() const { return m_handle; }
+
+		//Awaiting a task from another task runs it to completion
+		bool await_ready() const noexcept { return done(); }
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept
+		{
+			m_handle.promise().continuation = awaiter;
+			return m_handle;
+		}
+		void await_resume() const
+		{
+			if (auto error = exception())
+				std::rethrow_exception(error);
+		}
+
+	private:
+		explicit Task(Handle handle) : m_handle(handle) {}
+
+		void reset()
+		{
+			if (m_handle)
+				m_handle.destroy();
+			m_handle = {};
+		}
+
+		Handle m_handle;
+	};
+}
+
+#endif // BRAINTASK_H
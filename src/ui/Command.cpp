@@ -1,3 +1,24 @@
 #include "Command.h"
 
+using namespace Turtle;
 
+const TileSensor & Command::Data::tileSensor() const
+{
+	static const TileSensor empty;
+	return m_tileSensor ? *m_tileSensor : empty;
+}
+
+Command::Data::Payload & Command::Data::payload()
+{
+	if (!m_payload)
+		m_payload = new Payload;
+
+	//Detaches when shared
+	return *m_payload;
+}
+
+const Command::Data::Payload & Command::Data::constPayload() const
+{
+	static const Payload empty;
+	return m_payload ? *m_payload.constData() : empty;
+}
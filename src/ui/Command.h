@@ -4,10 +4,34 @@
 #include "Types.h"
 #include "TileSensor.h"
 
+#include <QRgba64>
+#include <QSharedData>
+#include <QSharedDataPointer>
 #include <QVariant>
 
+#include <memory>
+#include <type_traits>
+#include <vector>
+
 namespace Turtle
 {
+	//A trivially copyable color, converting to and from QColor
+	struct CommandColor
+	{
+		CommandColor() = default;
+		CommandColor(const QColor & color) : rgba(color.rgba64()) {}
+
+		operator QColor() const { return QColor(rgba); }
+
+		QRgba64 rgba;
+	};
+
+	//A command, or its reply
+	//The turtle part is trivially copyable and always stored inline, since it's used
+	// by the most frequent commands.
+	//The UI, transaction and swarm parts are allocated only by the commands using them,
+	// and shared between copies until modified.
+	//The tile sensor of a reply is shared, since it's not modified after it's made.
 	struct Command
 	{
 		struct UI
@@ -46,7 +70,10 @@ namespace Turtle
 				Get,
 
 				//Set some data
-				Set
+				Set,
+
+				//Set some data using all the Set operations in the transaction list
+				Transaction
 			} command;
 
 			//Selects the target for the command
@@ -85,7 +112,7 @@ namespace Turtle
 			TilePosition2D tile;
 
 			//Pen/tile colour
-			QColor color;
+			CommandColor color;
 
 			//Pen state
 			bool penDown;
@@ -99,8 +126,41 @@ namespace Turtle
 
 			//Absolute heading
 			Heading heading;
+		};
+
+		//Addresses many turtles of the world's swarm at once, see SwarmActor
+		//The whole command is applied in a single step.
+		struct Swarm
+		{
+			enum class Command
+			{
+				//Add a turtle for each operation, at its position and angle
+				Add,
+
+				//Retrieve the current state of each addressed turtle
+				Get,
+
+				//Apply the operations to the addressed turtles
+				Set,
+
+				//Remove all the turtles, invalidating any group
+				Clear,
+			} command;
+
+			//The swarm indices of the addressed turtles, or all of them when empty
+			//Filled with the new indices by Add replies.
+			std::vector<quint32> group;
+
+			//Set operations, either one for each addressed turtle or a single one for all of them
+			//When not absolute they are relative to each turtle's own location.
+			std::vector<Turtle> operations;
+
+			//When set, Get replies also have the tiles around each turtle, in the absolute frame
+			int sensorSize;
 
-			TileSensor tileSensor;
+			//Filled by Get replies, one for each addressed turtle
+			std::vector<Turtle> states;
+			std::vector<TileSensor> sensors;
 		};
 
 		//Top level command destination
@@ -108,7 +168,8 @@ namespace Turtle
 		enum class Destination
 		{
 			UI,
-			Turtle
+			Turtle,
+			Swarm
 		} destination;
 
 		//Set when this is a reply to a command
@@ -117,12 +178,58 @@ namespace Turtle
 		//Set when this reply has valid data
 		bool valid;
 
-		struct
+		//Assigned by the command channel, and copied to the matching reply
+		quint32 sequence;
+
+		//Stamped by the command channel, see CommandStatistics
+		//Zero when the command didn't pass that point.
+		struct Timing
+		{
+			qint64 posted = 0;
+			qint64 taken = 0;
+			qint64 replied = 0;
+		} timing;
+
+		class Data
 		{
-			UI ui;
+		public:
+			//Used by Turtle commands
 			Turtle turtle;
+
+			//Used by UI commands
+			UI & ui() { return payload().ui; }
+			const UI & ui() const { return constPayload().ui; }
+
+			//Set operations that are applied, in order, in a single step
+			std::vector<Turtle> & transaction() { return payload().transaction; }
+			const std::vector<Turtle> & transaction() const { return constPayload().transaction; }
+
+			//Used by Swarm commands
+			Swarm & swarm() { return payload().swarm; }
+			const Swarm & swarm() const { return constPayload().swarm; }
+
+			//Filled by Turtle Get replies
+			const TileSensor & tileSensor() const;
+			void setTileSensor(std::shared_ptr<const TileSensor> sensor) { m_tileSensor = std::move(sensor); }
+
+		private:
+			struct Payload : QSharedData
+			{
+				UI ui {};
+				std::vector<Turtle> transaction;
+				Swarm swarm {};
+			};
+
+			//Allocate on first use, and detach from other copies
+			Payload & payload();
+			const Payload & constPayload() const;
+
+			QSharedDataPointer<Payload> m_payload;
+			std::shared_ptr<const TileSensor> m_tileSensor;
 		} data;
 	};
+
+	static_assert(std::is_trivially_copyable<Command::Turtle>::value, "Turtle commands should be copied as plain memory");
 }
 
 Q_DECLARE_METATYPE(Turtle::Command)
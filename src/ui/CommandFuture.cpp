@@ -0,0 +1,72 @@
+#include "CommandFuture.h"
+
+#include <utility>
+
+#include "ThreadedBrain.h"
+#include "CoroutineRunner.h"
+
+using namespace Turtle;
+
+PendingReply::PendingReply(PendingReply && other) noexcept :
+	m_brain(std::exchange(other.m_brain, nullptr)),
+	m_sequence(std::exchange(other.m_sequence, 0))
+{
+}
+
+PendingReply & PendingReply::operator=(PendingReply && other) noexcept
+{
+	if (this != &other)
+	{
+		release();
+		m_brain = std::exchange(other.m_brain, nullptr);
+		m_sequence = std::exchange(other.m_sequence, 0);
+	}
+
+	return *this;
+}
+
+PendingReply::~PendingReply()
+{
+	release();
+}
+
+bool PendingReply::isReady() const
+{
+	return !m_brain || m_brain->isReplied(m_sequence);
+}
+
+bool PendingReply::await_suspend(std::coroutine_handle<> handle)
+{
+	//Outside a runner there is no one to resume us, so take() simply blocks
+	CoroutineRunner * runner = CoroutineRunner::current();
+	if (!runner || !m_brain)
+		return false;
+
+	runner->suspend(*m_brain, m_sequence, handle);
+	return true;
+}
+
+Command PendingReply::take()
+{
+	if (!m_brain)
+	{
+		Command reply {};
+		reply.reply = true;
+		return reply;
+	}
+
+	const Command reply = m_brain->takeReply(m_sequence);
+	m_brain = nullptr;
+	m_sequence = 0;
+
+	return reply;
+}
+
+void PendingReply::release()
+{
+	if (m_brain && m_sequence)
+		m_brain->forgetReply(m_sequence);
+
+	m_brain = nullptr;
+	m_sequence = 0;
+}
@@ -0,0 +1,82 @@
+#ifndef COMMANDFUTURE_H
+#define COMMANDFUTURE_H
+
+#include <coroutine>
+
+#include "Command.h"
+
+class ThreadedBrain;
+
+namespace Turtle
+{
+	//The reply to a command posted by a brain
+	//It can be waited for by blocking, or by co_await from a task running on a CoroutineRunner.
+	//A reply which is never taken is discarded when this object is destroyed.
+	class PendingReply
+	{
+	public:
+		PendingReply(ThreadedBrain * brain, quint32 sequence) :
+			m_brain(brain),
+			m_sequence(sequence) {}
+
+		PendingReply(PendingReply && other) noexcept;
+		PendingReply & operator=(PendingReply && other) noexcept;
+		PendingReply(const PendingReply &) = delete;
+		PendingReply & operator=(const PendingReply &) = delete;
+		~PendingReply();
+
+		//Return true if taking the reply will not block
+		bool isReady() const;
+
+		//Awaitable interface
+		bool await_ready() const { return isReady(); }
+		bool await_suspend(std::coroutine_handle<> handle);
+
+	protected:
+		//Wait for the reply and take it
+		//An invalid command is returned if the brain was stopped
+		Command take();
+
+	private:
+		void release();
+
+		ThreadedBrain * m_brain;
+		quint32 m_sequence;
+	};
+
+	//A pending reply, converted to the result type when taken
+	template <typename T>
+	class CommandFuture : public PendingReply
+	{
+	public:
+		using Extractor = T (*)(const Command &);
+
+		CommandFuture(ThreadedBrain * brain, quint32 sequence, Extractor extractor) :
+			PendingReply(brain, sequence),
+			m_extractor(extractor) {}
+
+		//Block until the reply is available
+		T get() { return m_extractor(take()); }
+
+		T await_resume() { return get(); }
+
+	private:
+		Extractor m_extractor;
+	};
+
+	template <>
+	class CommandFuture<void> : public PendingReply
+	{
+	public:
+		CommandFuture(ThreadedBrain * brain, quint32 sequence) :
+			PendingReply(brain, sequence) {}
+
+		//Block until the command is complete
+		//Returns false if the command failed
+		bool get() { return take().valid; }
+
+		void await_resume() { take(); }
+	};
+}
+
+#endif // COMMANDFUTURE_H
@@ -0,0 +1,380 @@
+#include "CommandJournal.h"
+#include "World.h"
+
+using namespace Turtle;
+
+namespace
+{
+	constexpr quint32 magic = 0x54524a4e;
+	constexpr quint32 version = 3;
+
+	//The bytes of a turtle command as written by writeItem()
+	constexpr qint64 turtleSize = 2 + 6 + 2 * 8 + 2 * 4 + 8 + 1 + 8 + 2;
+
+	void writeItem(QDataStream & stream, quint32 item)
+	{
+		stream << item;
+	}
+
+	bool readItem(QDataStream & stream, quint32 & item)
+	{
+		stream >> item;
+		return stream.status() == QDataStream::Ok;
+	}
+
+	//Field by field, so the journal does not depend on the layout or padding of the struct
+	void writeItem(QDataStream & stream, const Command::Turtle & turtle)
+	{
+		stream
+				<< static_cast<quint8>(turtle.command)
+				<< static_cast<quint8>(turtle.target)
+				<< turtle.setPosition
+				<< turtle.setHeading
+				<< turtle.setPenColor
+				<< turtle.setPenState
+				<< turtle.quantized
+				<< turtle.absolute
+				<< turtle.position.x()
+				<< turtle.position.y()
+				<< static_cast<qint32>(turtle.tile.x())
+				<< static_cast<qint32>(turtle.tile.y())
+				<< static_cast<quint64>(turtle.color.rgba)
+				<< turtle.penDown
+				<< turtle.angle
+				<< static_cast<quint8>(turtle.direction)
+				<< static_cast<quint8>(turtle.heading);
+	}
+
+	bool readItem(QDataStream & stream, Command::Turtle & turtle)
+	{
+		quint8 command, target, direction, heading;
+		qint32 tileX, tileY;
+		quint64 color;
+
+		stream
+				>> command
+				>> target
+				>> turtle.setPosition
+				>> turtle.setHeading
+				>> turtle.setPenColor
+				>> turtle.setPenState
+				>> turtle.quantized
+				>> turtle.absolute
+				>> turtle.position.x()
+				>> turtle.position.y()
+				>> tileX
+				>> tileY
+				>> color
+				>> turtle.penDown
+				>> turtle.angle
+				>> direction
+				>> heading;
+
+		turtle.command = static_cast<Command::Turtle::Command>(command);
+		turtle.target = static_cast<Command::Turtle::Target>(target);
+		turtle.tile = {tileX, tileY};
+		turtle.color.rgba = QRgba64::fromRgba64(color);
+		turtle.direction = static_cast<Direction>(direction);
+		turtle.heading = static_cast<Heading>(heading);
+
+		return stream.status() == QDataStream::Ok;
+	}
+
+	template <typename T>
+	void writeVector(QDataStream & stream, const std::vector<T> & items)
+	{
+		stream << static_cast<quint32>(items.size());
+		for (const T & item : items)
+			writeItem(stream, item);
+	}
+
+	template <typename T>
+	bool readVector(QDataStream & stream, std::vector<T> & items, qint64 itemSize)
+	{
+		quint32 count;
+		stream >> count;
+
+		//Don't trust the count of a corrupt journal with an allocation
+		const qint64 size = static_cast<qint64>(count) * itemSize;
+		if ((stream.status() != QDataStream::Ok) || (size > stream.device()->bytesAvailable()))
+			return false;
+
+		items.resize(count);
+		for (T & item : items)
+			if (!readItem(stream, item))
+				return false;
+
+		return true;
+	}
+
+	void writeCommand(QDataStream & stream, const Command & command)
+	{
+		stream
+				<< static_cast<quint8>(command.destination)
+				<< command.reply
+				<< command.valid
+				<< command.sequence;
+
+		writeItem(stream, command.data.turtle);
+
+		switch (command.destination)
+		{
+			case Command::Destination::UI:
+			{
+				const Command::UI & ui = command.data.ui();
+				stream
+						<< static_cast<quint8>(ui.command)
+						<< ui.title
+						<< ui.text
+						<< static_cast<qint32>(ui.level)
+						<< ui.string
+						<< static_cast<qint32>(ui.integer)
+						<< ui.real
+						<< ui.min
+						<< ui.max
+						<< ui.step;
+				break;
+			}
+
+			case Command::Destination::Turtle:
+				if (command.data.turtle.command == Command::Turtle::Command::Transaction)
+					writeVector(stream, command.data.transaction());
+				break;
+
+			case Command::Destination::Swarm:
+			{
+				//The sensors of replies are left out, as nothing is derived from them
+				const Command::Swarm & swarm = command.data.swarm();
+				stream << static_cast<quint8>(swarm.command);
+				writeVector(stream, swarm.group);
+				writeVector(stream, swarm.operations);
+				stream << static_cast<qint32>(swarm.sensorSize);
+				writeVector(stream, swarm.states);
+				break;
+			}
+		}
+	}
+
+	bool readCommand(QDataStream & stream, Command & command)
+	{
+		command = {};
+
+		quint8 destination;
+		stream
+				>> destination
+				>> command.reply
+				>> command.valid
+				>> command.sequence;
+
+		command.destination = static_cast<Command::Destination>(destination);
+
+		if (!readItem(stream, command.data.turtle))
+			return false;
+
+		switch (command.destination)
+		{
+			case Command::Destination::UI:
+			{
+				Command::UI & ui = command.data.ui();
+				quint8 type;
+				qint32 level, integer;
+				stream
+						>> type
+						>> ui.title
+						>> ui.text
+						>> level
+						>> ui.string
+						>> integer
+						>> ui.real
+						>> ui.min
+						>> ui.max
+						>> ui.step;
+
+				ui.command = static_cast<Command::UI::Command>(type);
+				ui.level = level;
+				ui.integer = integer;
+				break;
+			}
+
+			case Command::Destination::Turtle:
+				if (command.data.turtle.command == Command::Turtle::Command::Transaction)
+					return readVector(stream, command.data.transaction(), turtleSize);
+				break;
+
+			case Command::Destination::Swarm:
+			{
+				Command::Swarm & swarm = command.data.swarm();
+				quint8 type;
+				qint32 sensorSize;
+
+				stream >> type;
+				swarm.command = static_cast<Command::Swarm::Command>(type);
+
+				if (!readVector(stream, swarm.group, sizeof(quint32)) || !readVector(stream, swarm.operations, turtleSize))
+					return false;
+
+				stream >> sensorSize;
+				swarm.sensorSize = sensorSize;
+
+				return readVector(stream, swarm.states, turtleSize);
+			}
+
+			default:
+				return false;
+		}
+
+		return stream.status() == QDataStream::Ok;
+	}
+}
+
+CommandJournal::~CommandJournal()
+{
+	close();
+}
+
+bool CommandJournal::open(const QString & path, World & world)
+{
+	close();
+
+	m_file.setFileName(path);
+	if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	m_stream.setDevice(&m_file);
+	m_stream.setVersion(QDataStream::Qt_5_0);
+
+	const TiledFloor & floor = world.floor();
+	const TiledFloor::Chunks chunks = floor.chunks();
+
+	m_stream
+			<< magic
+			<< version
+			<< static_cast<qint32>(floor.halfIndexSize().x())
+			<< static_cast<qint32>(floor.halfIndexSize().y())
+			<< floor.isUnbounded()
+			<< static_cast<quint32>(TiledFloor::toRgb(floor.clearChunk()->data()))
+			<< static_cast<quint32>(chunks.size());
+
+	for (const auto & chunk : chunks)
+	{
+		m_stream << chunk.first;
+		m_stream.writeRawData(reinterpret_cast<const char *>(chunk.second->data()), static_cast<int>(chunk.second->size()));
+	}
+
+	m_stream << static_cast<quint32>(world.turtleCount());
+
+	for (size_t i = 0; i < world.turtleCount(); ++i)
+	{
+		TurtleActor & turtle = world.turtle(i);
+		m_stream
+				<< turtle.linearSpeed()
+				<< turtle.rotationSpeed()
+				<< turtle.instant();
+	}
+
+	m_world = &world;
+	m_firstStep = world.stepCount();
+	return m_stream.status() == QDataStream::Ok;
+}
+
+void CommandJournal::close()
+{
+	if (!m_world)
+		return;
+
+	record(Entry::Kind::End, 0, {});
+
+	m_world = nullptr;
+	m_stream.setDevice(nullptr);
+	m_file.close();
+}
+
+void CommandJournal::record(Entry::Kind kind, quint32 turtle, const Command & command)
+{
+	if (!m_world)
+		return;
+
+	m_stream
+			<< static_cast<quint8>(kind)
+			<< (m_world->stepCount() - m_firstStep)
+			<< turtle;
+
+	writeCommand(m_stream, command);
+}
+
+bool CommandJournal::Reader::open(const QString & path, Header & header)
+{
+	m_truncated = false;
+
+	m_file.setFileName(path);
+	if (!m_file.open(QIODevice::ReadOnly))
+		return false;
+
+	m_stream.setDevice(&m_file);
+	m_stream.setVersion(QDataStream::Qt_5_0);
+
+	quint32 fileMagic, fileVersion, turtles;
+	m_stream >> fileMagic >> fileVersion;
+
+	if ((fileMagic != magic) || (fileVersion != version))
+		return false;
+
+	qint32 halfX, halfY;
+	quint32 clearColor, chunks;
+	m_stream >> halfX >> halfY >> header.unbounded >> clearColor >> chunks;
+
+	header.halfSize = {halfX, halfY};
+	header.clearColor = clearColor;
+
+	//Don't trust the count of a corrupt journal with an allocation
+	const qint64 size = static_cast<qint64>(chunks) * static_cast<qint64>(sizeof(quint64) + sizeof(TiledFloor::Chunk));
+	if ((m_stream.status() != QDataStream::Ok) || (halfX < 0) || (halfY < 0) || (size > m_stream.device()->bytesAvailable()))
+		return false;
+
+	header.chunks.clear();
+	header.chunks.reserve(chunks);
+	for (quint32 i = 0; i < chunks; ++i)
+	{
+		quint64 key;
+		m_stream >> key;
+
+		auto chunk = std::make_shared<TiledFloor::Chunk>();
+		if (m_stream.readRawData(reinterpret_cast<char *>(chunk->data()), static_cast<int>(chunk->size())) != static_cast<int>(chunk->size()))
+			return false;
+
+		header.chunks.emplace(key, std::move(chunk));
+	}
+
+	m_stream >> turtles;
+
+	header.turtles.clear();
+	for (quint32 i = 0; (i < turtles) && (m_stream.status() == QDataStream::Ok); ++i)
+	{
+		Header::Turtle turtle;
+		m_stream >> turtle.linearSpeed >> turtle.rotationSpeed >> turtle.instant;
+		header.turtles.push_back(turtle);
+	}
+
+	return m_stream.status() == QDataStream::Ok;
+}
+
+bool CommandJournal::Reader::read(Entry & entry)
+{
+	if (m_stream.atEnd())
+	{
+		m_truncated = true;
+		return false;
+	}
+
+	quint8 kind;
+	m_stream >> kind >> entry.step >> entry.turtle;
+	entry.kind = static_cast<Entry::Kind>(kind);
+
+	if (!readCommand(m_stream, entry.command))
+	{
+		m_truncated = true;
+		return false;
+	}
+
+	return true;
+}
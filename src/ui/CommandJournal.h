@@ -0,0 +1,103 @@
+#ifndef COMMANDJOURNAL_H
+#define COMMANDJOURNAL_H
+
+#include <QDataStream>
+#include <QFile>
+#include <QString>
+
+#include <vector>
+
+#include "Command.h"
+#include "TiledFloor.h"
+
+namespace Turtle
+{
+	class World;
+
+	//An append-only binary record of the commands applied to a world, and their replies
+	//It starts with the state of the world when recording started, so replaying all
+	// the commands at their recorded steps reproduces the floor, see JournalReplay.
+	//Only turtle-run records: the GUI also changes the world outside of commands (loading,
+	// resizing and clearing the floor, changing speeds), which a replay would miss.
+	class CommandJournal
+	{
+	public:
+		//The world as it was when recording started
+		struct Header
+		{
+			//The floor is kept as its written chunks, so its size doesn't matter
+			TilePosition2D halfSize;
+			bool unbounded;
+			QRgb clearColor;
+			TiledFloor::Chunks chunks;
+
+			struct Turtle
+			{
+				double linearSpeed;
+				double rotationSpeed;
+				bool instant;
+			};
+
+			//In world order
+			std::vector<Turtle> turtles;
+		};
+
+		struct Entry
+		{
+			enum class Kind : quint8
+			{
+				Command,
+				Reply,
+
+				//Recording stopped, at the step of the entry
+				End,
+			} kind;
+
+			//The world step, counted from the start of the recording, see World::stepCount()
+			quint64 step;
+
+			//The index of the turtle in the world
+			quint32 turtle;
+
+			Command command;
+		};
+
+		~CommandJournal();
+
+		//Start recording to a new file, with the world as it is now
+		//The world should have just been reset, and no command applied since.
+		bool open(const QString & path, World & world);
+
+		//Stop recording, marking the end at the world's current step
+		void close();
+
+		bool isOpen() const { return m_world; }
+
+		void record(Entry::Kind kind, quint32 turtle, const Command & command);
+
+		//Read a journal, a header and then entries until read() returns false
+		class Reader
+		{
+		public:
+			bool open(const QString & path, Header & header);
+			bool read(Entry & entry);
+
+			//Set when the journal ends before its End entry
+			bool isTruncated() const { return m_truncated; }
+
+		private:
+			QFile m_file;
+			QDataStream m_stream;
+			bool m_truncated = false;
+		};
+
+	private:
+		World * m_world = nullptr;
+		quint64 m_firstStep = 0;
+
+		QFile m_file;
+		QDataStream m_stream;
+	};
+
+}
+#endif // COMMANDJOURNAL_H
@@ -0,0 +1,142 @@
+#include "CommandMailbox.h"
+#include "RuntimeMetrics.h"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+
+using namespace Turtle;
+
+void CommandMailbox::setNotifier(Notifier notifier)
+{
+	QMutexLocker locker(&m_notifierLock);
+	m_notifier = notifier;
+}
+
+bool CommandMailbox::take(Command & command)
+{
+	if (!m_commands.pop(command))
+		return false;
+
+	command.timing.taken = CommandStatistics::now();
+	return true;
+}
+
+void CommandMailbox::reply(Command reply)
+{
+	reply.timing.replied = CommandStatistics::now();
+
+	//The number of commands in flight is bounded by the brain,
+	// so there is always room for the reply
+	const bool pushed = m_replies.push(std::move(reply));
+	Q_ASSERT(pushed);
+	Q_UNUSED(pushed)
+	m_replyBell.ring();
+
+	//Make sure that either the brain sees the reply after sharing a bell,
+	// or we see the shared bell
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (Doorbell * shared = m_sharedBell.load(std::memory_order_seq_cst))
+		shared->ring();
+}
+
+void CommandMailbox::interrupt()
+{
+	m_replyBell.ring();
+
+	if (Doorbell * shared = m_sharedBell.load(std::memory_order_seq_cst))
+		shared->ring();
+}
+
+void CommandMailbox::shareReplyBell(Doorbell * bell)
+{
+	m_sharedBell.store(bell, std::memory_order_seq_cst);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void CommandMailbox::notify()
+{
+	//Only the first command after the consumer was woken schedules it again
+	if (m_scheduled.exchange(true, std::memory_order_acq_rel))
+		return;
+
+	QMutexLocker locker(&m_notifierLock);
+	if (m_notifier)
+		m_notifier();
+}
+
+bool CommandMailbox::poll(quint32 sequence)
+{
+	collect();
+
+	for (const auto & awaited : m_awaited)
+		if (awaited.sequence == sequence)
+			return awaited.replied;
+
+	//Not awaited, so there is nothing to wait for
+	return true;
+}
+
+void CommandMailbox::forget(quint32 sequence)
+{
+	m_awaited.erase(
+				std::remove_if(
+					m_awaited.begin(), m_awaited.end(),
+					[sequence](const Awaited & awaited) { return awaited.sequence == sequence; }),
+				m_awaited.end());
+}
+
+void CommandMailbox::collect()
+{
+	Command * next;
+	while ((next = m_replies.front()))
+	{
+		CommandStatistics::global().record(*next, CommandStatistics::now());
+		RuntimeMetrics::global().command(CommandStatistics::kind(*next));
+
+		//Replies arrive in order, but guard against stale ones
+		if (static_cast<qint32>(next->sequence - m_acknowledged) > 0)
+			m_acknowledged = next->sequence;
+
+		//Only a few commands are awaited at any time
+		for (auto & awaited : m_awaited)
+			if (!awaited.replied && (awaited.sequence == next->sequence))
+			{
+				awaited.reply = std::move(*next);
+				awaited.replied = true;
+				break;
+			}
+
+		m_replies.popFront();
+	}
+}
+
+bool CommandMailbox::takeReply(quint32 sequence, Command & reply)
+{
+	for (auto i = m_awaited.begin(); i != m_awaited.end(); ++i)
+		if (i->sequence == sequence)
+		{
+			if (!i->replied)
+				return false;
+
+			reply = std::move(i->reply);
+			m_awaited.erase(i);
+			return true;
+		}
+
+	return false;
+}
+
+bool CommandMailbox::isAwaited(quint32 sequence) const
+{
+	return std::any_of(
+				m_awaited.cbegin(), m_awaited.cend(),
+				[sequence](const Awaited & awaited) { return awaited.sequence == sequence; });
+}
+
+void CommandMailbox::block(uint32_t seen)
+{
+	const qint64 start = CommandStatistics::now();
+	m_replyBell.wait(seen);
+	RuntimeMetrics::global().blocked(CommandStatistics::now() - start);
+}
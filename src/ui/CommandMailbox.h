@@ -0,0 +1,204 @@
+#ifndef COMMANDMAILBOX_H
+#define COMMANDMAILBOX_H
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include <QMutex>
+
+#include "Command.h"
+#include "CommandStatistics.h"
+#include "SpscRing.h"
+
+namespace Turtle
+{
+	//The command channel between a brain thread and the UI thread
+	//Commands and replies travel through two preallocated lock-free rings,
+	// so a round trip costs no heap allocations and no nested event loops.
+	//The brain (producer) blocks on a doorbell while waiting for a reply,
+	// and the UI (consumer) is woken only when it is not already scheduled.
+	class CommandMailbox
+	{
+	public:
+		static constexpr size_t capacity = 256;
+
+		using Ring = SpscRing<Command, capacity>;
+		using Notifier = std::function<void()>;
+
+
+		//Brain side
+		//----------
+
+		//Post a command and return its sequence number
+		//When awaited is set the reply is kept until it is taken by wait() or forget(),
+		// otherwise it is discarded.
+		//Returns 0 if the command could not be posted since keepWaiting() turned false
+		// while waiting for space
+		template <typename Predicate> quint32 post(Command command, Predicate keepWaiting, bool awaited = true);
+
+		//Return true if the reply to an awaited sequence number is available
+		//Does not block
+		bool poll(quint32 sequence);
+
+		//Wait for the reply to an awaited sequence number
+		//Returns false if keepWaiting() turned false before the reply arrived,
+		// in which case the sequence is no longer awaited, or at once if it was not awaited
+		template <typename Predicate> bool wait(quint32 sequence, Command & reply, Predicate keepWaiting);
+
+		//Stop awaiting a sequence number, discarding its reply
+		void forget(quint32 sequence);
+
+		//Wait until all the posted commands are acknowledged
+		//Returns false if keepWaiting() turned false before that
+		template <typename Predicate> bool flush(Predicate keepWaiting);
+
+		//Wake the brain so it can reevaluate its wait predicate
+		void interrupt();
+
+		//Number of commands posted and not yet acknowledged
+		quint32 pending() const { return m_sent - m_acknowledged; }
+
+		//Return true if all the posted commands were acknowledged
+		//Does not block
+		bool idle() { collect(); return !pending(); }
+
+		//Additionally ring a bell shared between several mailboxes on every reply
+		//This allows a single thread to wait for replies from all of them.
+		//The mailbox itself still waits on its own bell.
+		void shareReplyBell(Doorbell * bell);
+
+
+		//UI side
+		//-------
+
+		//Set the function used to schedule the consumer
+		//It is called from the brain thread, and should only schedule a call to take()
+		void setNotifier(Notifier notifier);
+
+		//Must be called by the consumer before it starts taking commands
+		void acknowledgeNotification() { m_scheduled.exchange(false, std::memory_order_acq_rel); }
+
+		//Take the next command, returns false if none is available
+		bool take(Command & command);
+
+		//Send back a reply
+		void reply(Command reply);
+
+	private:
+		struct Awaited
+		{
+			quint32 sequence;
+			bool replied;
+			Command reply;
+		};
+
+		void notify();
+
+		//Drain all available replies, keeping the awaited ones
+		void collect();
+
+		//Move out an awaited reply if it's available
+		bool takeReply(quint32 sequence, Command & reply);
+
+		bool isAwaited(quint32 sequence) const;
+
+		//Wait for a reply after seen, counting the time the brain is blocked
+		void block(uint32_t seen);
+
+		Ring m_commands;
+		Ring m_replies;
+
+		//Woken on every reply
+		Doorbell m_replyBell;
+		std::atomic<Doorbell*> m_sharedBell {nullptr};
+
+		//Set while the consumer has a pending notification
+		std::atomic<bool> m_scheduled {false};
+
+		QMutex m_notifierLock;
+		Notifier m_notifier;
+
+		//Brain side bookkeeping
+		quint32 m_sent = 0;
+		quint32 m_acknowledged = 0;
+		std::vector<Awaited> m_awaited;
+	};
+
+	template <typename Predicate>
+	quint32 CommandMailbox::post(Command command, Predicate keepWaiting, bool awaited)
+	{
+		//Keep the number of commands in flight bounded, so neither ring can overflow
+		while (pending() >= capacity - 1)
+		{
+			const uint32_t seen = m_replyBell.value();
+			collect();
+			if (pending() < capacity - 1)
+				break;
+
+			if (!keepWaiting())
+				return 0;
+
+			block(seen);
+		}
+
+		//Skip 0 since it is reserved as "no sequence"
+		if (!++m_sent)
+			++m_sent;
+
+		if (awaited)
+			m_awaited.push_back({m_sent, false, {}});
+
+		command.sequence = m_sent;
+		command.timing = {};
+		command.timing.posted = CommandStatistics::now();
+		m_commands.push(std::move(command));
+		notify();
+
+		return m_sent;
+	}
+
+	template <typename Predicate>
+	bool CommandMailbox::wait(quint32 sequence, Command & reply, Predicate keepWaiting)
+	{
+		//The reply of anything else is discarded, so it would be waited for forever
+		Q_ASSERT(isAwaited(sequence));
+		if (!isAwaited(sequence))
+			return false;
+
+		for (;;)
+		{
+			const uint32_t seen = m_replyBell.value();
+			collect();
+			if (takeReply(sequence, reply))
+				return true;
+
+			if (!keepWaiting())
+			{
+				forget(sequence);
+				return false;
+			}
+
+			block(seen);
+		}
+	}
+
+	template <typename Predicate>
+	bool CommandMailbox::flush(Predicate keepWaiting)
+	{
+		for (;;)
+		{
+			const uint32_t seen = m_replyBell.value();
+			collect();
+			if (!pending())
+				return true;
+
+			if (!keepWaiting())
+				return false;
+
+			block(seen);
+		}
+	}
+}
+
+#endif // COMMANDMAILBOX_H
@@ -0,0 +1,169 @@
+#include "CommandStatistics.h"
+
+#include <chrono>
+
+using namespace Turtle;
+
+CommandStatistics::CommandStatistics() :
+	m_start{now()}
+{
+}
+
+CommandStatistics & CommandStatistics::global()
+{
+	static CommandStatistics statistics;
+	return statistics;
+}
+
+qint64 CommandStatistics::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+CommandStatistics::Kind CommandStatistics::kind(const Command & command)
+{
+	switch (command.destination)
+	{
+		case Command::Destination::UI:
+			return (command.data.ui().command == Command::UI::Command::Log) ? Kind::Log : Kind::Input;
+
+		case Command::Destination::Turtle:
+			switch (command.data.turtle.command)
+			{
+				case Command::Turtle::Command::Get:
+					return Kind::TurtleGet;
+
+				case Command::Turtle::Command::Transaction:
+					return Kind::TurtleTransaction;
+
+				case Command::Turtle::Command::Set:
+					switch (command.data.turtle.target)
+					{
+						case Command::Turtle::Target::Current:
+							return Kind::TurtleSetCurrent;
+						case Command::Turtle::Target::Target:
+							return Kind::TurtleSetTarget;
+						case Command::Turtle::Target::Tile:
+							return Kind::TurtleSetTile;
+					}
+			}
+			break;
+
+		case Command::Destination::Swarm:
+			switch (command.data.swarm().command)
+			{
+				case Command::Swarm::Command::Add:
+					return Kind::SwarmAdd;
+				case Command::Swarm::Command::Get:
+					return Kind::SwarmGet;
+				case Command::Swarm::Command::Set:
+					return Kind::SwarmSet;
+				case Command::Swarm::Command::Clear:
+					return Kind::SwarmClear;
+			}
+			break;
+	}
+
+	return Kind::Log;
+}
+
+QString CommandStatistics::name(Kind kind)
+{
+	switch (kind)
+	{
+		case Kind::Log: return "UI log";
+		case Kind::Input: return "UI input";
+		case Kind::TurtleGet: return "Turtle get";
+		case Kind::TurtleSetCurrent: return "Turtle set current";
+		case Kind::TurtleSetTarget: return "Turtle set target";
+		case Kind::TurtleSetTile: return "Turtle set tile";
+		case Kind::TurtleTransaction: return "Turtle transaction";
+		case Kind::SwarmAdd: return "Swarm add";
+		case Kind::SwarmGet: return "Swarm get";
+		case Kind::SwarmSet: return "Swarm set";
+		case Kind::SwarmClear: return "Swarm clear";
+		case Kind::Count: break;
+	}
+
+	return {};
+}
+
+void CommandStatistics::record(const Command & reply, qint64 received)
+{
+	const Command::Timing & timing = reply.timing;
+
+	//Replies not made from a command, e.g. after a reset, are not timed
+	if (!timing.posted || !timing.taken || !timing.replied)
+		return;
+
+	auto & histograms = m_histograms[static_cast<size_t>(kind(reply))];
+
+	auto duration = [](qint64 from, qint64 to) { return static_cast<std::uint64_t>(std::max<qint64>(0, to - from)); };
+
+	histograms[static_cast<size_t>(Stage::Queue)].record(duration(timing.posted, timing.taken));
+	histograms[static_cast<size_t>(Stage::Simulation)].record(duration(timing.taken, timing.replied));
+	histograms[static_cast<size_t>(Stage::Reply)].record(duration(timing.replied, received));
+	m_roundTrips.record(duration(timing.posted, received));
+}
+
+void CommandStatistics::reset()
+{
+	for (auto & histograms : m_histograms)
+		for (auto & histogram : histograms)
+			histogram.reset();
+
+	m_roundTrips.reset();
+	m_start.store(now(), std::memory_order_relaxed);
+}
+
+bool CommandStatistics::isEmpty() const
+{
+	for (size_t i = 0; i < kinds; ++i)
+		if (count(static_cast<Kind>(i)))
+			return false;
+
+	return true;
+}
+
+double CommandStatistics::throughput(Kind kind) const
+{
+	const qint64 elapsed = now() - m_start.load(std::memory_order_relaxed);
+	return (elapsed > 0) ? count(kind) * 1e9 / elapsed : 0;
+}
+
+QString CommandStatistics::report() const
+{
+	auto microseconds = [](double nanoseconds) { return QString::number(nanoseconds * 1e-3, 'f', 1).rightJustified(11); };
+
+	QString text = QString("Kind").leftJustified(20) + QString("Count").rightJustified(10) + QString("Per sec").rightJustified(10);
+
+	for (const char * stage : {"Queue", "Sim", "Reply"})
+		for (const char * column : {"p50", "p99", "max"})
+			text += (QString(stage) + " " + column).rightJustified(11);
+
+	text += "\n";
+
+	for (size_t i = 0; i < kinds; ++i)
+	{
+		const Kind kind = static_cast<Kind>(i);
+		if (!count(kind))
+			continue;
+
+		text +=
+				name(kind).leftJustified(20) +
+				QString::number(count(kind)).rightJustified(10) +
+				QString::number(throughput(kind), 'f', 1).rightJustified(10);
+
+		for (const LatencyHistogram & histogram : m_histograms[i])
+			text +=
+					microseconds(histogram.percentile(0.5)) +
+					microseconds(histogram.percentile(0.99)) +
+					microseconds(histogram.max());
+
+		text += "\n";
+	}
+
+	text += "Times in microseconds\n";
+	return text;
+}
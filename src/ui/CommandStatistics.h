@@ -0,0 +1,94 @@
+#ifndef COMMANDSTATISTICS_H
+#define COMMANDSTATISTICS_H
+
+#include <QString>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "Command.h"
+#include "LatencyHistogram.h"
+
+namespace Turtle
+{
+	//Where the time of commands goes, by command kind, for all the brains
+	//The command channel stamps each command when it's posted, taken and replied to,
+	// and the brain records the stamps once it receives the reply.
+	//Recording is lock-free, so any brain thread may record at any time.
+	class CommandStatistics
+	{
+	public:
+		enum class Kind
+		{
+			Log,
+			Input,
+			TurtleGet,
+			TurtleSetCurrent,
+			TurtleSetTarget,
+			TurtleSetTile,
+			TurtleTransaction,
+			SwarmAdd,
+			SwarmGet,
+			SwarmSet,
+			SwarmClear,
+			Count
+		};
+
+		enum class Stage
+		{
+			//From being posted by the brain until taken by the controller
+			Queue,
+
+			//From being taken until replied to, including any simulation steps
+			Simulation,
+
+			//From being replied to until received by the brain
+			Reply,
+			Count
+		};
+
+		CommandStatistics();
+
+		//The statistics of all the brains in this process
+		static CommandStatistics & global();
+
+		//The clock of the stamps, in nanoseconds
+		static qint64 now();
+
+		static Kind kind(const Command & command);
+		static QString name(Kind kind);
+
+		//Record a reply with all its stamps, received now
+		void record(const Command & reply, qint64 received);
+
+		void reset();
+
+		const LatencyHistogram & histogram(Kind kind, Stage stage) const
+		{ return m_histograms[static_cast<size_t>(kind)][static_cast<size_t>(stage)]; }
+
+		std::uint64_t count(Kind kind) const { return histogram(kind, Stage::Simulation).count(); }
+
+		//From being posted until received, for all the kinds
+		const LatencyHistogram & roundTrips() const { return m_roundTrips; }
+
+		//Nothing was recorded since the statistics were reset
+		bool isEmpty() const;
+
+		//Commands per second since the statistics were reset
+		double throughput(Kind kind) const;
+
+		//A plain text table of all the kinds that were recorded, in microseconds
+		QString report() const;
+
+	private:
+		static constexpr size_t kinds = static_cast<size_t>(Kind::Count);
+		static constexpr size_t stages = static_cast<size_t>(Stage::Count);
+
+		std::array<std::array<LatencyHistogram, stages>, kinds> m_histograms;
+		LatencyHistogram m_roundTrips;
+		std::atomic<qint64> m_start;
+	};
+
+}
+#endif // COMMANDSTATISTICS_H
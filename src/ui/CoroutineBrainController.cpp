@@ -0,0 +1,95 @@
+#include "CoroutineBrainController.h"
+
+#include "main.h"
+#include "RuntimeMetrics.h"
+
+#include <exception>
+
+CoroutineBrainController::CoroutineBrainController(
+		TurtleActorController * controller,
+		Turtle::CoroutineScheduler & scheduler,
+		QObject *parent) :
+	QObject{parent},
+	scheduler{scheduler},
+	controller{controller},
+	brain{mailbox},
+	running{std::make_shared<std::atomic<bool>>(false)}
+{
+	qRegisterMetaType<Turtle::Command>("Turtle::Command");
+
+	brain.setSnapshot(&controller->snapshot());
+	brain.setFloorMirror(&floorMirror);
+	controller->addFloorMirror(&floorMirror);
+	controller->attach(&mailbox);
+}
+
+CoroutineBrainController::~CoroutineBrainController()
+{
+	stop();
+	running->wait(true);
+
+	if (controller)
+	{
+		controller->attach(nullptr);
+		controller->removeFloorMirror(&floorMirror);
+	}
+}
+
+void CoroutineBrainController::start()
+{
+	if (running->exchange(true))
+		return;
+
+	brain.setActive(true);
+	Turtle::RuntimeMetrics::global().brainStarted();
+	emit started();
+
+	Turtle::Task task = supervise(program ? program(brain) : MainAsync(brain));
+
+	//Called on the worker, which emits the signal queued to us
+	scheduler.spawn(brain, std::move(task), {}, [this, running = running](const QString &, const QString &)
+	{
+		Turtle::RuntimeMetrics::global().brainStopped();
+		brain.setActive(false);
+		emit stopped();
+
+		running->store(false);
+		running->notify_all();
+	});
+}
+
+Turtle::Task CoroutineBrainController::supervise(Turtle::Task task)
+{
+	QString error;
+
+	try
+	{
+		co_await task;
+	}
+	catch(const std::exception & e)
+	{
+		error = e.what();
+	}
+	catch(...)
+	{
+		error = "Unknown exception";
+	}
+
+	//Not allowed within the handlers
+	if (!error.isEmpty())
+		co_await brain.logAsync("<font color = \"red\">Exception: " + error + "</font>");
+
+	//Let any queued commands complete before reporting the stop
+	co_await brain.syncAsync();
+}
+
+void CoroutineBrainController::stop()
+{
+	brain.stop();
+}
+
+void CoroutineBrainController::setWriteBehind(bool enable)
+{
+	//The mode is atomic, so it can be set from any thread
+	brain.setWriteBehind(enable);
+}
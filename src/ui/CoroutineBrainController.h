@@ -0,0 +1,65 @@
+#ifndef COROUTINEBRAINCONTROLLER_H
+#define COROUTINEBRAINCONTROLLER_H
+
+#include <QPointer>
+#include <QObject>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "TurtleActorController.h"
+#include "ThreadedBrain.h"
+#include "CommandMailbox.h"
+#include "CoroutineScheduler.h"
+
+//Runs a brain as a task on a shared coroutine scheduler, instead of a thread of its own
+//The program co_awaits the brain's asynchronous calls, so a worker runs other brains meanwhile.
+//Otherwise this is interchangeable with ThreadedBrainController.
+class CoroutineBrainController : public QObject
+{
+	Q_OBJECT
+public:
+	//The program run by the brain, MainAsync() by default
+	using Program = std::function<Turtle::Task(ThreadedBrain&)>;
+
+	explicit CoroutineBrainController(
+			TurtleActorController * controller,
+			Turtle::CoroutineScheduler & scheduler,
+			QObject *parent = nullptr);
+
+	//Stops the brain and waits for its task to finish
+	~CoroutineBrainController();
+
+	//Must not be changed while running
+	void setProgram(Program value) { program = value; }
+
+	bool isRunning() const { return running->load(); }
+
+signals:
+	void started();
+	void stopped();
+
+public slots:
+	void start();
+	void stop();
+
+	//Enable the brain's write-behind mode
+	void setWriteBehind(bool enable);
+
+private:
+	//Run the program, then report any error and wait for its commands, all without blocking the worker
+	Turtle::Task supervise(Turtle::Task task);
+
+	Turtle::CoroutineScheduler & scheduler;
+	Turtle::CommandMailbox mailbox;
+	Turtle::FloorMirror floorMirror;
+	QPointer<TurtleActorController> controller;
+	ThreadedBrain brain;
+	Program program;
+
+	//Shared with the task's completion, which may still touch it after we're destroyed
+	std::shared_ptr<std::atomic<bool>> running;
+};
+
+#endif // COROUTINEBRAINCONTROLLER_H
@@ -0,0 +1,226 @@
+#include "CoroutineRunner.h"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+#include "ThreadedBrain.h"
+
+using namespace Turtle;
+
+namespace
+{
+	thread_local CoroutineRunner * currentRunner = nullptr;
+}
+
+CoroutineRunner::~CoroutineRunner()
+{
+	//The suspended coroutines are destroyed with their tasks
+	m_waiters.clear();
+	m_tasks.clear();
+	m_posted.clear();
+
+	for (ThreadedBrain * brain : m_brains)
+		brain->shareReplyBell(nullptr);
+}
+
+void CoroutineRunner::add(ThreadedBrain & brain, Task task, QString name, Completion completion)
+{
+	adopt({&brain, std::move(task), name, std::move(completion), false});
+
+	//Wake the runner in case it's waiting
+	m_bell.ring();
+}
+
+void CoroutineRunner::post(ThreadedBrain & brain, Task task, QString name, Completion completion)
+{
+	{
+		std::lock_guard<std::mutex> locker(m_postLock);
+		m_posted.push_back({&brain, std::move(task), name, std::move(completion), false});
+	}
+
+	m_bell.ring();
+}
+
+bool CoroutineRunner::run(const std::function<bool()> & keepRunning)
+{
+	return loop(keepRunning, true);
+}
+
+void CoroutineRunner::serve(const std::function<bool()> & keepServing)
+{
+	loop(keepServing, false);
+}
+
+bool CoroutineRunner::loop(const std::function<bool()> & keepRunning, bool untilDone)
+{
+	CoroutineRunner * previous = std::exchange(currentRunner, this);
+
+	for (;;)
+	{
+		//Read the bell before looking at the replies, so none is missed
+		const uint32_t seen = m_bell.value();
+
+		bool progress = takePosted();
+		if ((untilDone && m_tasks.empty()) || !keepRunning())
+			break;
+
+		progress = startNew() || progress;
+		progress = resumeReady() || progress;
+		reap();
+
+		if (!progress && !(untilDone && m_tasks.empty()))
+			m_bell.wait(seen);
+	}
+
+	currentRunner = previous;
+	return m_tasks.empty();
+}
+
+void CoroutineRunner::adopt(Entry entry)
+{
+	if (std::find(m_brains.begin(), m_brains.end(), entry.brain) == m_brains.end())
+	{
+		entry.brain->shareReplyBell(&m_bell);
+		m_brains.push_back(entry.brain);
+	}
+
+	m_tasks.push_back(std::move(entry));
+}
+
+bool CoroutineRunner::takePosted()
+{
+	std::vector<Entry> posted;
+	{
+		std::lock_guard<std::mutex> locker(m_postLock);
+		posted.swap(m_posted);
+	}
+
+	for (Entry & entry : posted)
+		adopt(std::move(entry));
+
+	return !posted.empty();
+}
+
+CoroutineRunner * CoroutineRunner::current()
+{
+	return currentRunner;
+}
+
+void CoroutineRunner::suspend(ThreadedBrain & brain, quint32 sequence, std::coroutine_handle<> handle)
+{
+	m_waiters.push_back({&brain, sequence, handle});
+}
+
+bool CoroutineRunner::resumeReady()
+{
+	bool progress = false;
+
+	//Resuming may add waiters, so iterate by index
+	for (size_t i = 0; i < m_waiters.size();)
+	{
+		const Waiter waiter = m_waiters[i];
+
+		//A stopped brain never replies, the task gets an invalid reply instead
+		if (!waiter.brain->isReplied(waiter.sequence) && *waiter.brain)
+		{
+			++i;
+			continue;
+		}
+
+		m_waiters.erase(m_waiters.begin() + i);
+		waiter.handle.resume();
+		progress = true;
+	}
+
+	return progress;
+}
+
+bool CoroutineRunner::startNew()
+{
+	bool progress = false;
+
+	//Starting may add tasks, so iterate by index
+	for (size_t i = 0; i < m_tasks.size(); ++i)
+	{
+		if (m_tasks[i].started)
+			continue;
+
+		m_tasks[i].started = true;
+		m_tasks[i].task.handle().resume();
+		progress = true;
+	}
+
+	return progress;
+}
+
+void CoroutineRunner::reap()
+{
+	struct Completed
+	{
+		QString name;
+		QString error;
+		Completion completion;
+	};
+
+	//Report after removing, since a completion may add new tasks
+	std::vector<Completed> completed;
+
+	for (auto i = m_tasks.begin(); i != m_tasks.end();)
+	{
+		if (!i->started || !i->task.done())
+		{
+			++i;
+			continue;
+		}
+
+		QString error;
+		if (auto exception = i->task.exception())
+		{
+			try
+			{
+				std::rethrow_exception(exception);
+			}
+			catch(const std::exception & e)
+			{
+				error = e.what();
+			}
+			catch(...)
+			{
+				error = "Unknown exception";
+			}
+		}
+
+		completed.push_back({i->name, error, std::move(i->completion)});
+		i = m_tasks.erase(i);
+	}
+
+	if (completed.empty())
+		return;
+
+	//Brains may be destroyed once their tasks complete, so stop sharing the bell with those left idle
+	for (auto brain = m_brains.begin(); brain != m_brains.end();)
+	{
+		const bool busy = std::any_of(
+					m_tasks.cbegin(), m_tasks.cend(),
+					[brain](const Entry & entry) { return entry.brain == *brain; });
+
+		if (busy)
+		{
+			++brain;
+			continue;
+		}
+
+		(*brain)->shareReplyBell(nullptr);
+		brain = m_brains.erase(brain);
+	}
+
+	for (const Completed & task : completed)
+	{
+		if (task.completion)
+			task.completion(task.name, task.error);
+
+		if (m_completion)
+			m_completion(task.name, task.error);
+	}
+}
@@ -0,0 +1,108 @@
+#ifndef COROUTINERUNNER_H
+#define COROUTINERUNNER_H
+
+#include <coroutine>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <QString>
+
+#include "BrainTask.h"
+#include "SpscRing.h"
+
+class ThreadedBrain;
+
+namespace Turtle
+{
+	//Runs many brain tasks on a single thread
+	//A task waiting for a reply is suspended, and the thread runs other tasks meanwhile.
+	//All the replies ring a single shared doorbell, so the thread sleeps only when no task can run.
+	//A brain given to a runner must only be used from the thread calling run() or serve(),
+	// while tasks may be posted to it from any thread, see CoroutineScheduler.
+	class CoroutineRunner
+	{
+	public:
+		//Called when a task completes, the error is empty on success
+		using Completion = std::function<void(const QString & name, const QString & error)>;
+
+		CoroutineRunner() = default;
+		CoroutineRunner(const CoroutineRunner &) = delete;
+		CoroutineRunner & operator=(const CoroutineRunner &) = delete;
+		~CoroutineRunner();
+
+		//Add a task whose commands are sent through the given brain
+		//May be called while running, from within a task.
+		//The task's own completion, if any, is called before the runner's.
+		void add(ThreadedBrain & brain, Task task, QString name = {}, Completion completion = {});
+
+		//Like add(), from any thread
+		void post(ThreadedBrain & brain, Task task, QString name = {}, Completion completion = {});
+
+		void setCompletion(Completion completion) { m_completion = completion; }
+
+		//Number of tasks not yet completed
+		size_t size() const { return m_tasks.size(); }
+
+		//Run until all the tasks complete or keepRunning() turns false
+		//Returns true if all the tasks completed
+		bool run(const std::function<bool()> & keepRunning);
+
+		//Run the tasks as they are posted, until keepServing() turns false
+		//Call wake() after keepServing() changes, so an idle runner sees it.
+		void serve(const std::function<bool()> & keepServing);
+
+		void wake() { m_bell.ring(); }
+
+		//The runner currently running on this thread, or nullptr
+		static CoroutineRunner * current();
+
+		//Suspend a coroutine until the reply for a sequence is available
+		void suspend(ThreadedBrain & brain, quint32 sequence, std::coroutine_handle<> handle);
+
+	private:
+		struct Entry
+		{
+			ThreadedBrain * brain;
+			Task task;
+			QString name;
+			Completion completion;
+			bool started;
+		};
+
+		struct Waiter
+		{
+			ThreadedBrain * brain;
+			quint32 sequence;
+			std::coroutine_handle<> handle;
+		};
+
+		//Run until keepRunning() turns false, or until no task is left if untilDone is set
+		bool loop(const std::function<bool()> & keepRunning, bool untilDone);
+
+		void adopt(Entry entry);
+
+		//Adopt the tasks posted from other threads
+		bool takePosted();
+
+		//Resume all the waiters whose reply is available
+		bool resumeReady();
+
+		//Start the tasks added since the last call
+		bool startNew();
+
+		//Remove the completed tasks and report them
+		void reap();
+
+		Doorbell m_bell;
+		std::vector<ThreadedBrain*> m_brains;
+		std::vector<Entry> m_tasks;
+		std::vector<Waiter> m_waiters;
+		Completion m_completion;
+
+		std::mutex m_postLock;
+		std::vector<Entry> m_posted;
+	};
+}
+
+#endif // COROUTINERUNNER_H
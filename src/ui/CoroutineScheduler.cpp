@@ -0,0 +1,70 @@
+#include "CoroutineScheduler.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace Turtle;
+
+CoroutineScheduler::CoroutineScheduler(unsigned int workers)
+{
+	if (!workers)
+		workers = std::max(1u, std::thread::hardware_concurrency());
+
+	//All the workers exist before any starts serving
+	m_workers.reserve(workers);
+	for (unsigned int i = 0; i < workers; ++i)
+		m_workers.push_back(std::make_unique<Worker>());
+
+	for (auto & worker : m_workers)
+		worker->thread = std::thread(&CoroutineScheduler::work, this, std::ref(*worker));
+}
+
+CoroutineScheduler::~CoroutineScheduler()
+{
+	wait();
+
+	m_stopping.store(true);
+	for (auto & worker : m_workers)
+		worker->runner.wake();
+
+	for (auto & worker : m_workers)
+		worker->thread.join();
+}
+
+void CoroutineScheduler::spawn(ThreadedBrain & brain, Task task, QString name, Completion completion)
+{
+	Worker & worker = **std::min_element(
+				m_workers.begin(), m_workers.end(),
+				[](const auto & a, const auto & b) { return a->tasks.load() < b->tasks.load(); });
+
+	++m_tasks;
+	++worker.tasks;
+
+	worker.runner.post(
+				brain, std::move(task), name,
+				[this, &worker, completion = std::move(completion)](const QString & name, const QString & error)
+	{
+		if (completion)
+			completion(name, error);
+
+		--worker.tasks;
+
+		std::lock_guard<std::mutex> locker(m_lock);
+		if (!--m_tasks)
+			m_finished.notify_all();
+	});
+}
+
+void CoroutineScheduler::wait()
+{
+	std::unique_lock<std::mutex> locker(m_lock);
+	m_finished.wait(locker, [this]{ return !m_tasks.load(); });
+}
+
+void CoroutineScheduler::work(Worker & worker)
+{
+	Trace::nameThread("Coroutine worker");
+
+	worker.runner.serve([this]{ return !m_stopping.load(); });
+}
@@ -0,0 +1,70 @@
+#ifndef COROUTINESCHEDULER_H
+#define COROUTINESCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BrainTask.h"
+#include "CoroutineRunner.h"
+
+class ThreadedBrain;
+
+namespace Turtle
+{
+	//Runs brain tasks on a small pool of threads, each with a CoroutineRunner of its own
+	//A task stays on the worker it was given to, which runs the tasks of many brains
+	// and switches between them whenever one waits for a reply.
+	class CoroutineScheduler
+	{
+	public:
+		using Completion = CoroutineRunner::Completion;
+
+		//Use 0 workers for one per hardware thread
+		explicit CoroutineScheduler(unsigned int workers = 0);
+		CoroutineScheduler(const CoroutineScheduler &) = delete;
+		CoroutineScheduler & operator=(const CoroutineScheduler &) = delete;
+
+		//Waits for all the tasks to finish
+		~CoroutineScheduler();
+
+		//Run a task on the least loaded worker, calling completion on that worker when done
+		//The brain must not be used by any other thread until the task completes.
+		void spawn(ThreadedBrain & brain, Task task, QString name = {}, Completion completion = {});
+
+		//Number of tasks not yet finished
+		size_t size() const { return m_tasks.load(); }
+
+		unsigned int workers() const { return static_cast<unsigned int>(m_workers.size()); }
+
+		//Block until all the tasks finished
+		void wait();
+
+	private:
+		struct Worker
+		{
+			CoroutineRunner runner;
+			std::thread thread;
+
+			//Tasks given to this worker and not yet finished
+			std::atomic<size_t> tasks {0};
+		};
+
+		//Worker thread main loop
+		void work(Worker & worker);
+
+		std::vector<std::unique_ptr<Worker>> m_workers;
+
+		std::mutex m_lock;
+		std::atomic<size_t> m_tasks {0};
+		std::condition_variable m_finished;
+
+		std::atomic<bool> m_stopping {false};
+	};
+}
+
+#endif // COROUTINESCHEDULER_H
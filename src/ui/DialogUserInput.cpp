@@ -0,0 +1,53 @@
+#include "DialogUserInput.h"
+
+#include <QInputDialog>
+
+using namespace Turtle;
+
+bool DialogUserInput::getInteger(
+		const QString & title,
+		const QString & label,
+		int & value,
+		int min, int max, int step)
+{
+	bool ok;
+	const int result = QInputDialog::getInt(m_parent, title, label, value, min, max, step, &ok);
+
+	if (ok)
+		value = result;
+
+	return ok;
+}
+
+bool DialogUserInput::getDouble(
+		const QString & title,
+		const QString & label,
+		double & value,
+		double min, double max, double step)
+{
+	bool ok;
+	const double result =
+			QInputDialog::getDouble(
+				m_parent, title, label, value, min, max,
+				static_cast<int>(step),
+				&ok);
+
+	if (ok)
+		value = result;
+
+	return ok;
+}
+
+bool DialogUserInput::getString(
+		const QString & title,
+		const QString & label,
+		QString & value)
+{
+	bool ok;
+	const QString result = QInputDialog::getText(m_parent, title, label, QLineEdit::Normal, value, &ok);
+
+	if (ok)
+		value = result;
+
+	return ok;
+}
@@ -0,0 +1,39 @@
+#ifndef DIALOGUSERINPUT_H
+#define DIALOGUSERINPUT_H
+
+#include "UserInput.h"
+
+#include <QPointer>
+#include <QWidget>
+
+namespace Turtle
+{
+	//Answers input requests by asking the user with modal dialogs
+	class DialogUserInput : public UserInput
+	{
+	public:
+		explicit DialogUserInput(QWidget * parent = nullptr) : m_parent{parent} {}
+
+		bool getInteger(
+				const QString & title,
+				const QString & label,
+				int & value,
+				int min, int max, int step) override;
+
+		bool getDouble(
+				const QString & title,
+				const QString & label,
+				double & value,
+				double min, double max, double step) override;
+
+		bool getString(
+				const QString & title,
+				const QString & label,
+				QString & value) override;
+
+	private:
+		QPointer<QWidget> m_parent;
+	};
+}
+
+#endif // DIALOGUSERINPUT_H
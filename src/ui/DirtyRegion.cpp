@@ -0,0 +1,56 @@
+#include "DirtyRegion.h"
+
+#include <limits>
+
+using namespace Turtle;
+
+namespace
+{
+	qint64 area(const QRect & rect)
+	{
+		return static_cast<qint64>(rect.width()) * rect.height();
+	}
+}
+
+void DirtyRegion::add(int x, int y)
+{
+	const QRect pixel(x, y, 1, 1);
+
+	//The rectangle that grows the least by taking the pixel
+	auto best = m_rects.end();
+	qint64 growth = std::numeric_limits<qint64>::max();
+
+	for (auto rect = m_rects.begin(); rect != m_rects.end(); ++rect)
+	{
+		if (rect->contains(x, y))
+			return;
+
+		const qint64 added = ::area(rect->united(pixel)) - ::area(*rect);
+		if (added < growth)
+		{
+			growth = added;
+			best = rect;
+		}
+	}
+
+	const bool near = (best != m_rects.end()) && best->adjusted(-gap, -gap, gap, gap).contains(x, y);
+
+	if (near || (m_rects.size() == maxRects))
+		*best = best->united(pixel);
+	else
+		m_rects.push_back(pixel);
+}
+
+void DirtyRegion::addAll(int width, int height)
+{
+	m_rects.assign(1, QRect(0, 0, width, height));
+}
+
+qint64 DirtyRegion::area() const
+{
+	qint64 total = 0;
+	for (const QRect & rect : m_rects)
+		total += ::area(rect);
+
+	return total;
+}
@@ -0,0 +1,39 @@
+#ifndef DIRTYREGION_H
+#define DIRTYREGION_H
+
+#include <QRect>
+
+#include <vector>
+
+namespace Turtle
+{
+	//The pixels of an image changed since it was last taken, as a few rectangles
+	//Nearby pixels grow the same rectangle, so a trail costs a rectangle or two,
+	// while pixels far apart get rectangles of their own, up to maxRects.
+	class DirtyRegion
+	{
+	public:
+		static constexpr size_t maxRects = 8;
+
+		//Pixels closer than this to a rectangle are added to it
+		static constexpr int gap = 16;
+
+		void add(int x, int y);
+
+		//All of an image of this size
+		void addAll(int width, int height);
+
+		void clear() { m_rects.clear(); }
+
+		bool isEmpty() const { return m_rects.empty(); }
+		const std::vector<QRect> & rects() const { return m_rects; }
+
+		//Of all the rectangles, in pixels
+		qint64 area() const;
+
+	private:
+		std::vector<QRect> m_rects;
+	};
+
+}
+#endif // DIRTYREGION_H
@@ -0,0 +1,137 @@
+#include "Fiber.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+#ifdef TURTLE_WIN_FIBERS
+#	include <windows.h>
+#else
+#	include <sys/mman.h>
+#	include <unistd.h>
+#endif
+
+using namespace Turtle;
+
+namespace
+{
+	thread_local Fiber * currentFiber = nullptr;
+}
+
+#ifdef TURTLE_WIN_FIBERS
+
+Fiber::Fiber(Function function, size_t stackSize) :
+	m_function(std::move(function))
+{
+	m_fiber = CreateFiber(stackSize, &Fiber::entry, this);
+	if (!m_fiber)
+		throw std::runtime_error("Unable to create a fiber");
+}
+
+Fiber::~Fiber()
+{
+	DeleteFiber(m_fiber);
+}
+
+void Fiber::resume()
+{
+	//Only a fiber can switch to another fiber
+	if (!IsThreadAFiber())
+		ConvertThreadToFiber(nullptr);
+
+	Fiber * previous = std::exchange(currentFiber, this);
+	m_caller = GetCurrentFiber();
+	SwitchToFiber(m_fiber);
+	currentFiber = previous;
+}
+
+void Fiber::yield()
+{
+	SwitchToFiber(m_caller);
+}
+
+void __stdcall Fiber::entry(void * parameter)
+{
+	static_cast<Fiber*>(parameter)->main();
+}
+
+#else
+
+Fiber::Fiber(Function function, size_t stackSize) :
+	m_function(std::move(function))
+{
+	const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	stackSize = (stackSize + page - 1) / page * page;
+
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_STACK
+	flags |= MAP_STACK;
+#endif
+
+	void * mapping = mmap(nullptr, stackSize + page, PROT_READ | PROT_WRITE, flags, -1, 0);
+	if (mapping == MAP_FAILED)
+		throw std::runtime_error("Unable to allocate a fiber stack");
+
+	m_mapping = static_cast<char *>(mapping);
+	m_mappingSize = stackSize + page;
+
+	//The stack grows down, towards the guard page
+	if (mprotect(m_mapping, page, PROT_NONE) || getcontext(&m_context))
+	{
+		munmap(m_mapping, m_mappingSize);
+		throw std::runtime_error("Unable to create a fiber");
+	}
+
+	m_context.uc_stack.ss_sp = m_mapping + page;
+	m_context.uc_stack.ss_size = stackSize;
+	m_context.uc_link = nullptr;
+
+	//makecontext only passes int arguments, so split the pointer
+	const auto self = reinterpret_cast<std::uintptr_t>(this);
+	makecontext(
+				&m_context,
+				reinterpret_cast<void(*)()>(&Fiber::entry),
+				2,
+				static_cast<unsigned int>(static_cast<std::uint64_t>(self) >> 32),
+				static_cast<unsigned int>(self & 0xFFFFFFFFu));
+}
+
+Fiber::~Fiber()
+{
+	munmap(m_mapping, m_mappingSize);
+}
+
+void Fiber::resume()
+{
+	Fiber * previous = std::exchange(currentFiber, this);
+	swapcontext(&m_caller, &m_context);
+	currentFiber = previous;
+}
+
+void Fiber::yield()
+{
+	swapcontext(&m_context, &m_caller);
+}
+
+void Fiber::entry(unsigned int high, unsigned int low)
+{
+	const auto self = static_cast<std::uintptr_t>((static_cast<std::uint64_t>(high) << 32) | low);
+	reinterpret_cast<Fiber*>(self)->main();
+}
+
+#endif
+
+Fiber * Fiber::current()
+{
+	return currentFiber;
+}
+
+void Fiber::main()
+{
+	m_function();
+	m_finished = true;
+
+	//A finished fiber is never resumed again
+	for (;;)
+		yield();
+}
@@ -0,0 +1,69 @@
+#ifndef FIBER_H
+#define FIBER_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+#ifdef _WIN32
+#	define TURTLE_WIN_FIBERS
+#else
+#	include <ucontext.h>
+#endif
+
+namespace Turtle
+{
+	//A stackful coroutine
+	//The function runs on its own stack, and can give up the thread at any depth by calling yield().
+	//A fiber may be resumed on a different thread each time, but never on two at once.
+	//Outside of Windows the stack is mapped with a guard page below it, so an overflow faults
+	// instead of writing over another fiber. Switches use swapcontext(), which also saves and
+	// restores the signal mask, a system call on each switch.
+	class Fiber
+	{
+	public:
+		using Function = std::function<void()>;
+
+		//The function must not throw
+		Fiber(Function function, size_t stackSize);
+		Fiber(const Fiber &) = delete;
+		Fiber & operator=(const Fiber &) = delete;
+		~Fiber();
+
+		//Run the fiber until it yields or finishes
+		void resume();
+
+		//Return to whoever resumed the fiber
+		//Must be called from within the fiber.
+		void yield();
+
+		bool finished() const { return m_finished; }
+
+		//The fiber running on the calling thread, or nullptr
+		static Fiber * current();
+
+	private:
+		void main();
+
+#ifdef TURTLE_WIN_FIBERS
+		static void __stdcall entry(void * parameter);
+
+		void * m_fiber = nullptr;
+		void * m_caller = nullptr;
+#else
+		static void entry(unsigned int high, unsigned int low);
+
+		//The mapping, starting with the guard page
+		char * m_mapping = nullptr;
+		size_t m_mappingSize = 0;
+
+		ucontext_t m_context;
+		ucontext_t m_caller;
+#endif
+
+		Function m_function;
+		bool m_finished = false;
+	};
+}
+
+#endif // FIBER_H
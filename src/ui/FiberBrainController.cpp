@@ -0,0 +1,64 @@
+#include "FiberBrainController.h"
+
+FiberBrainController::FiberBrainController(
+		TurtleActorController * controller,
+		Turtle::FiberScheduler & scheduler,
+		QObject *parent) :
+	QObject{parent},
+	scheduler{scheduler},
+	controller{controller},
+	brain{mailbox},
+	running{std::make_shared<std::atomic<bool>>(false)}
+{
+	qRegisterMetaType<Turtle::Command>("Turtle::Command");
+
+	//The brain emits from the worker threads, so these are queued
+	connect(&brain, &ThreadedBrain::started, this, &FiberBrainController::started);
+	connect(&brain, &ThreadedBrain::stopped, this, &FiberBrainController::stopped);
+
+	//Parked fibers are woken through the scheduler's bell
+	mailbox.shareReplyBell(&scheduler.bell());
+
+	brain.setSnapshot(&controller->snapshot());
+	brain.setFloorMirror(&floorMirror);
+	controller->addFloorMirror(&floorMirror);
+	controller->attach(&mailbox);
+}
+
+FiberBrainController::~FiberBrainController()
+{
+	stop();
+	running->wait(true);
+
+	if (controller)
+	{
+		controller->attach(nullptr);
+		controller->removeFloorMirror(&floorMirror);
+	}
+}
+
+void FiberBrainController::start()
+{
+	if (running->exchange(true))
+		return;
+
+	brain.setActive(true);
+	scheduler.spawn([this, running = running]
+	{
+		brain.execute();
+
+		running->store(false);
+		running->notify_all();
+	});
+}
+
+void FiberBrainController::stop()
+{
+	brain.stop();
+}
+
+void FiberBrainController::setWriteBehind(bool enable)
+{
+	//The mode is atomic, so it can be set from any thread
+	brain.setWriteBehind(enable);
+}
@@ -0,0 +1,57 @@
+#ifndef FIBERBRAINCONTROLLER_H
+#define FIBERBRAINCONTROLLER_H
+
+#include <QPointer>
+#include <QObject>
+
+#include <atomic>
+#include <memory>
+
+#include "TurtleActorController.h"
+#include "ThreadedBrain.h"
+#include "CommandMailbox.h"
+#include "FiberScheduler.h"
+
+//Runs a brain on a fiber of a shared scheduler, instead of a thread of its own
+//The brain's blocking calls switch to another fiber, so many brains can share a few threads.
+//Otherwise this is interchangeable with ThreadedBrainController.
+class FiberBrainController : public QObject
+{
+	Q_OBJECT
+public:
+	explicit FiberBrainController(
+			TurtleActorController * controller,
+			Turtle::FiberScheduler & scheduler,
+			QObject *parent = nullptr);
+
+	//Stops the brain and waits for its fiber to finish
+	~FiberBrainController();
+
+	//Set the program to run, see ThreadedBrain::setProgram()
+	void setProgram(ThreadedBrain::Program program) { brain.setProgram(program); }
+
+	bool isRunning() const { return running->load(); }
+
+signals:
+	void started();
+	void stopped();
+
+public slots:
+	void start();
+	void stop();
+
+	//Enable the brain's write-behind mode
+	void setWriteBehind(bool enable);
+
+private:
+	Turtle::FiberScheduler & scheduler;
+	Turtle::CommandMailbox mailbox;
+	Turtle::FloorMirror floorMirror;
+	QPointer<TurtleActorController> controller;
+	ThreadedBrain brain;
+
+	//Shared with the fiber, which may still touch it after we're destroyed
+	std::shared_ptr<std::atomic<bool>> running;
+};
+
+#endif // FIBERBRAINCONTROLLER_H
@@ -0,0 +1,169 @@
+#include "FiberScheduler.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace Turtle;
+
+namespace
+{
+	//The entry of the fiber currently running on a worker
+	//Only read before the fiber yields, since the fiber may be resumed on another worker.
+	thread_local void * runningEntry = nullptr;
+}
+
+FiberScheduler::FiberScheduler(unsigned int workers, size_t stackSize) :
+	m_stackSize(stackSize)
+{
+	if (!workers)
+		workers = std::max(1u, std::thread::hardware_concurrency());
+
+	m_workers.reserve(workers);
+	for (unsigned int i = 0; i < workers; ++i)
+		m_workers.emplace_back(&FiberScheduler::work, this);
+}
+
+FiberScheduler::~FiberScheduler()
+{
+	wait();
+
+	m_stopping.store(true);
+	m_bell.ring();
+
+	for (auto & worker : m_workers)
+		worker.join();
+}
+
+void FiberScheduler::spawn(Fiber::Function function)
+{
+	auto entry = std::make_unique<Entry>();
+	entry->fiber = std::make_unique<Fiber>(std::move(function), m_stackSize);
+
+	++m_fibers;
+	{
+		std::lock_guard<std::mutex> locker(m_lock);
+		m_ready.push_back(std::move(entry));
+	}
+
+	m_bell.ring();
+}
+
+void FiberScheduler::wait()
+{
+	std::unique_lock<std::mutex> locker(m_lock);
+	m_finished.wait(locker, [this]{ return !m_fibers.load(); });
+}
+
+void FiberScheduler::work()
+{
+	Trace::nameThread("Fiber worker");
+	Doorbell::waitHook() = &FiberScheduler::block;
+
+	while (!m_stopping.load())
+	{
+		//Read the bell before looking for work, so no ring is missed
+		const uint32_t seen = m_bell.value();
+
+		Clock::time_point wake = Clock::time_point::max();
+		std::unique_ptr<Entry> entry = next(wake);
+		if (!entry)
+		{
+			if (wake == Clock::time_point::max())
+				m_bell.wait(seen);
+			else
+				std::this_thread::sleep_until(std::min(wake, Clock::now() + sleepSlice));
+
+			continue;
+		}
+
+		runningEntry = entry.get();
+		entry->fiber->resume();
+		runningEntry = nullptr;
+
+		park(std::move(entry));
+	}
+}
+
+std::unique_ptr<FiberScheduler::Entry> FiberScheduler::next(Clock::time_point & wake)
+{
+	std::lock_guard<std::mutex> locker(m_lock);
+	const Clock::time_point now = Clock::now();
+
+	//Wake the fibers whose bell rang, or whose sleep is over
+	for (auto i = m_blocked.begin(); i != m_blocked.end();)
+	{
+		if ((*i)->sleeping ? ((*i)->wake > now) : ((*i)->bell->value() == (*i)->seen))
+		{
+			if ((*i)->sleeping)
+				wake = std::min(wake, (*i)->wake);
+
+			++i;
+			continue;
+		}
+
+		(*i)->bell = nullptr;
+		(*i)->sleeping = false;
+		m_ready.push_back(std::move(*i));
+		i = m_blocked.erase(i);
+	}
+
+	if (m_ready.empty())
+		return {};
+
+	std::unique_ptr<Entry> entry = std::move(m_ready.front());
+	m_ready.pop_front();
+	return entry;
+}
+
+void FiberScheduler::park(std::unique_ptr<Entry> entry)
+{
+	std::unique_lock<std::mutex> locker(m_lock);
+
+	if (entry->fiber->finished())
+	{
+		entry.reset();
+		if (!--m_fibers)
+			m_finished.notify_all();
+	}
+	else if (entry->bell || entry->sleeping)
+		m_blocked.push_back(std::move(entry));
+	else
+	{
+		//Yielded without blocking, so let an idle worker pick it up
+		m_ready.push_back(std::move(entry));
+		locker.unlock();
+		m_bell.ring();
+	}
+}
+
+bool FiberScheduler::block(const Doorbell & bell, uint32_t seen)
+{
+	//Block the worker itself while it's not running a fiber
+	Fiber * fiber = Fiber::current();
+	if (!fiber)
+		return false;
+
+	auto entry = static_cast<Entry*>(runningEntry);
+	entry->bell = &bell;
+	entry->seen = seen;
+
+	//Parked by the worker, which rechecks the bell before sleeping
+	fiber->yield();
+	return true;
+}
+
+bool FiberScheduler::sleepUntil(Clock::time_point time)
+{
+	Fiber * fiber = Fiber::current();
+	if (!fiber || !runningEntry)
+		return false;
+
+	auto entry = static_cast<Entry*>(runningEntry);
+	entry->sleeping = true;
+	entry->wake = time;
+
+	//Parked by the worker, which wakes it once due
+	fiber->yield();
+	return true;
+}
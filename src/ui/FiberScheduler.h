@@ -0,0 +1,103 @@
+#ifndef FIBERSCHEDULER_H
+#define FIBERSCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Fiber.h"
+#include "SpscRing.h"
+
+namespace Turtle
+{
+	//Runs many fibers on a small pool of worker threads
+	//A fiber blocking on a Doorbell (e.g. a brain waiting for a reply) is parked,
+	// and its worker runs another fiber until the bell rings.
+	//Bells waited on by fibers should forward their rings to bell(),
+	// which is what wakes an idle worker.
+	class FiberScheduler
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		static constexpr size_t defaultStackSize = 256 * 1024;
+
+		//How long an idle worker naps at a time while a fiber sleeps, as nothing rings when it's due
+		static constexpr Clock::duration sleepSlice = std::chrono::microseconds(200);
+
+		//Use 0 workers for one per hardware thread
+		explicit FiberScheduler(unsigned int workers = 0, size_t stackSize = defaultStackSize);
+		FiberScheduler(const FiberScheduler &) = delete;
+		FiberScheduler & operator=(const FiberScheduler &) = delete;
+
+		//Waits for all the fibers to finish
+		~FiberScheduler();
+
+		//Run a function on a new fiber
+		void spawn(Fiber::Function function);
+
+		//The bell that wakes the idle workers
+		Doorbell & bell() { return m_bell; }
+
+		//Number of fibers not yet finished
+		size_t size() const { return m_fibers.load(); }
+
+		unsigned int workers() const { return static_cast<unsigned int>(m_workers.size()); }
+
+		//Block until all the fibers finished
+		void wait();
+
+		//Park the calling fiber until the time given, leaving its worker to the others
+		//Returns false when not called from a fiber, in which case the caller should sleep itself.
+		static bool sleepUntil(Clock::time_point time);
+
+	private:
+		struct Entry
+		{
+			std::unique_ptr<Fiber> fiber;
+
+			//The bell the fiber is parked on, if any
+			const Doorbell * bell = nullptr;
+			uint32_t seen = 0;
+
+			//Set while the fiber sleeps, until the time given
+			bool sleeping = false;
+			Clock::time_point wake;
+		};
+
+		//Worker thread main loop
+		void work();
+
+		//Take the next runnable fiber, or nullptr
+		//Otherwise, the earliest time a sleeping fiber is due is set in wake.
+		std::unique_ptr<Entry> next(Clock::time_point & wake);
+
+		//Put a fiber back after it yielded or finished
+		void park(std::unique_ptr<Entry> entry);
+
+		//Installed as the Doorbell wait hook of the workers
+		static bool block(const Doorbell & bell, uint32_t seen);
+
+		const size_t m_stackSize;
+
+		std::mutex m_lock;
+		std::deque<std::unique_ptr<Entry>> m_ready;
+		std::vector<std::unique_ptr<Entry>> m_blocked;
+
+		std::atomic<size_t> m_fibers {0};
+		std::condition_variable m_finished;
+
+		std::atomic<bool> m_stopping {false};
+		Doorbell m_bell;
+
+		std::vector<std::thread> m_workers;
+	};
+}
+
+#endif // FIBERSCHEDULER_H
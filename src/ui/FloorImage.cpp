@@ -0,0 +1,64 @@
+#include "FloorImage.h"
+#include "TiledFloor.h"
+
+#include <algorithm>
+
+using namespace Turtle;
+
+FloorImage::FloorImage(TiledFloor & floor) :
+	m_floor{floor}
+{
+	//This reports the whole floor right away
+	m_floor.addObserver(this);
+}
+
+FloorImage::~FloorImage()
+{
+	m_floor.removeObserver(this);
+}
+
+void FloorImage::floorChanged(const TiledFloor & floor)
+{
+	const TilePosition2D halfSize = floor.halfIndexSize();
+	const qint64 width = 2 * static_cast<qint64>(halfSize.x()) + 1;
+	const qint64 height = 2 * static_cast<qint64>(halfSize.y()) + 1;
+
+	m_step = static_cast<int>((std::max(width, height) + maxSize - 1) / maxSize);
+	m_image = QImage(
+				static_cast<int>((width + m_step - 1) / m_step),
+				static_cast<int>((height + m_step - 1) / m_step),
+				TiledFloor::format);
+
+	if (m_step == 1)
+	{
+		//The rows of the format need no padding
+		floor.read(m_image.rect(), m_image.bits());
+		return;
+	}
+
+	for (int row = 0; row < m_image.height(); ++row)
+	{
+		uchar * line = m_image.scanLine(row);
+		for (int column = 0; column < m_image.width(); ++column)
+			floor.read(QRect(column * m_step, row * m_step, 1, 1), line + 4 * column);
+	}
+}
+
+void FloorImage::tileChanged(const TiledFloor & floor, const TilePosition2D & tile, QRgb color)
+{
+	//Only the size of an unbounded floor is shown
+	const TilePosition2D halfSize = floor.halfIndexSize();
+	if (!((tile >= -halfSize) && (tile <= halfSize)))
+		return;
+
+	//Note that the Y axis is inverted
+	const int column = tile.x() + halfSize.x();
+	const int row = halfSize.y() - tile.y();
+
+	//Not one of the sampled tiles
+	if ((column % m_step) || (row % m_step))
+		return;
+
+	uchar * line = m_image.scanLine(row / m_step);
+	TiledFloor::fromRgb(line + 4 * (column / m_step), color);
+}
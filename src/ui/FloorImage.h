@@ -0,0 +1,38 @@
+#ifndef FLOORIMAGE_H
+#define FLOORIMAGE_H
+
+#include "Types.h"
+#include "FloorObserver.h"
+
+#include <QImage>
+
+namespace Turtle
+{
+	//The tiles within the size of a TiledFloor, as an image kept up to date
+	//For views that draw the whole floor every frame, see TiledFloor::image()
+	//A floor larger than maxSize is sampled every few tiles, the same along both axes,
+	// so the image stays about the size it's shown at rather than that of the floor.
+	class FloorImage : public FloorObserver
+	{
+	public:
+		static constexpr int maxSize = 1024;
+
+		explicit FloorImage(TiledFloor & floor);
+		~FloorImage() override;
+
+		//In the layout of TiledFloor::image(), and at the same address for as long as we live
+		const QImage & image() const { return m_image; }
+
+		void floorChanged(const TiledFloor & floor) override;
+		void tileChanged(const TiledFloor & floor, const TilePosition2D & tile, QRgb color) override;
+
+	private:
+		TiledFloor & m_floor;
+		QImage m_image;
+
+		//Tiles along each axis for each pixel
+		int m_step = 1;
+	};
+}
+
+#endif // FLOORIMAGE_H
@@ -0,0 +1,170 @@
+#include "FloorMirror.h"
+
+#include <QMutexLocker>
+
+using namespace Turtle;
+
+void FloorMirror::floorChanged(const TiledFloor &)
+{
+	invalidate();
+}
+
+void FloorMirror::tileChanged(const TiledFloor &, const TilePosition2D & tile, QRgb color)
+{
+	{
+		QMutexLocker locker(&m_lock);
+
+		//Dropped until the reader asks for a sync
+		if (m_stale)
+			return;
+
+		if (m_changes.size() >= maxChanges)
+		{
+			locker.unlock();
+			invalidate();
+			return;
+		}
+
+		m_changes.push_back({tile, color});
+	}
+
+	m_dirty.store(true, std::memory_order_release);
+}
+
+void FloorMirror::setSyncRequest(SyncRequest request)
+{
+	QMutexLocker locker(&m_lock);
+	m_syncRequest = std::move(request);
+}
+
+void FloorMirror::sync(const TiledFloor & floor)
+{
+	//Taken outside the lock, as it may be long
+	Snapshot snapshot {floor.chunks(), floor.clearChunk(), floor.halfIndexSize(), floor.isUnbounded()};
+
+	{
+		QMutexLocker locker(&m_lock);
+
+		//Earlier changes are already part of the snapshot
+		m_changes.clear();
+		m_stale = false;
+		m_syncRequested = false;
+		m_synced = true;
+		std::swap(m_sync, snapshot);
+	}
+
+	m_dirty.store(true, std::memory_order_release);
+}
+
+void FloorMirror::invalidate()
+{
+	//Released outside the lock
+	Snapshot previous;
+	std::vector<Change> changes;
+
+	{
+		QMutexLocker locker(&m_lock);
+
+		m_stale = true;
+		m_synced = false;
+		std::swap(m_sync, previous);
+		m_changes.swap(changes);
+	}
+
+	m_dirty.store(true, std::memory_order_release);
+}
+
+bool FloorMirror::getColor(const TilePosition2D & position, QColor & color)
+{
+	if (!update())
+		return false;
+
+	//Make sure the position is not out of bounds
+	const TilePosition2D bounded =
+			m_base.unbounded ? position : position.min(m_base.halfSize).max(-m_base.halfSize);
+
+	color = QColor::fromRgba(pixel(bounded));
+	return true;
+}
+
+bool FloorMirror::update()
+{
+	//Cleared before taking the changes, so later ones set it again
+	if (!m_dirty.exchange(false, std::memory_order_acquire))
+		return m_current || requestSync();
+
+	//Released outside the lock
+	Snapshot previous;
+
+	{
+		QMutexLocker locker(&m_lock);
+
+		if (m_synced)
+		{
+			m_synced = false;
+			previous = std::move(m_base);
+			m_base = std::move(m_sync);
+			m_sync = {};
+			m_chunks.clear();
+		}
+
+		m_current = !m_stale;
+		m_applying.swap(m_changes);
+	}
+
+	for (const Change & change : m_applying)
+		TiledFloor::fromRgb(chunk(change.tile).data() + TiledFloor::chunkOffset(change.tile), change.color);
+
+	m_applying.clear();
+
+	return m_current || requestSync();
+}
+
+bool FloorMirror::requestSync()
+{
+	SyncRequest request;
+
+	{
+		QMutexLocker locker(&m_lock);
+
+		if (m_syncRequested || !m_syncRequest)
+			return false;
+
+		m_syncRequested = true;
+		request = m_syncRequest;
+	}
+
+	request();
+	return false;
+}
+
+QRgb FloorMirror::pixel(const TilePosition2D & tile) const
+{
+	const quint64 key = TiledFloor::chunkKey(tile);
+	const size_t offset = TiledFloor::chunkOffset(tile);
+
+	const auto copy = m_chunks.find(key);
+	if (copy != m_chunks.cend())
+		return TiledFloor::toRgb(copy->second->data() + offset);
+
+	//The floor never changes the chunks of a snapshot
+	const auto shared = m_base.chunks.find(key);
+	if (shared != m_base.chunks.cend())
+		return TiledFloor::toRgb(shared->second->data() + offset);
+
+	return TiledFloor::toRgb(m_base.clearChunk->data() + offset);
+}
+
+TiledFloor::Chunk & FloorMirror::chunk(const TilePosition2D & tile)
+{
+	auto & copy = m_chunks[TiledFloor::chunkKey(tile)];
+
+	if (!copy)
+	{
+		//Copy on first change
+		const auto shared = m_base.chunks.find(TiledFloor::chunkKey(tile));
+		copy = std::make_unique<TiledFloor::Chunk>((shared != m_base.chunks.cend()) ? *shared->second : *m_base.clearChunk);
+	}
+
+	return *copy;
+}
@@ -0,0 +1,103 @@
+#ifndef FLOORMIRROR_H
+#define FLOORMIRROR_H
+
+#include "Types.h"
+#include "FloorObserver.h"
+#include "TiledFloor.h"
+
+#include <QMutex>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Turtle
+{
+	//A read-only copy of a TiledFloor, for reading tiles from another thread
+	//The floor streams every tile change to the mirror, and the reader applies them
+	// just before reading.
+	//Replacing the whole floor, or buffering too many changes, makes the mirror stale instead.
+	// The reader then asks for a new snapshot of the chunks, and falls back to the floor until it arrives,
+	// so the floor never pays for a snapshot nobody reads.
+	//The mirror shares the chunks it was last synced to, and copies only those
+	// that were changed since, so it scales to large floors.
+	class FloorMirror : public FloorObserver
+	{
+	public:
+		using SyncRequest = std::function<void()>;
+
+		//Changes buffered beyond this make the mirror stale
+		static constexpr size_t maxChanges = 1 << 16;
+
+		//Floor side
+		//----------
+
+		void floorChanged(const TiledFloor & floor) override;
+		void tileChanged(const TiledFloor & floor, const TilePosition2D & tile, QRgb color) override;
+
+		//Called on the reader's thread when the mirror is stale, at most once until it is synced
+		//The owner of the floor should then call sync() on its own thread.
+		void setSyncRequest(SyncRequest request);
+
+		//Replace the whole floor
+		void sync(const TiledFloor & floor);
+
+
+		//Reader side
+		//-----------
+
+		//Read the color of a tile, clamped to the floor like TiledFloor::getColor
+		//Returns false if the mirror is stale, in which case the tile should be read from the floor.
+		bool getColor(const TilePosition2D & position, QColor & color);
+
+	private:
+		struct Change
+		{
+			TilePosition2D tile;
+			QRgb color;
+		};
+
+		//All that is needed to read the floor
+		struct Snapshot
+		{
+			TiledFloor::Chunks chunks;
+			std::shared_ptr<const TiledFloor::Chunk> clearChunk;
+			TilePosition2D halfSize;
+			bool unbounded = false;
+		};
+
+		//Drop the buffered changes until the next sync
+		void invalidate();
+
+		//Apply the changes streamed since the last call
+		//Returns false if the mirror is stale.
+		bool update();
+
+		//Ask the floor for a sync, unless already asked
+		//Always returns false, for use by update().
+		bool requestSync();
+
+		QRgb pixel(const TilePosition2D & tile) const;
+		TiledFloor::Chunk & chunk(const TilePosition2D & tile);
+
+		//Shared between the floor and the reader
+		QMutex m_lock;
+		std::atomic<bool> m_dirty {false};
+		bool m_synced = false;
+		bool m_stale = true;
+		bool m_syncRequested = false;
+		Snapshot m_sync;
+		std::vector<Change> m_changes;
+		SyncRequest m_syncRequest;
+
+		//Owned by the reader
+		bool m_current = false;
+		std::vector<Change> m_applying;
+		Snapshot m_base;
+		std::unordered_map<quint64, std::unique_ptr<TiledFloor::Chunk>> m_chunks;
+	};
+}
+
+#endif // FLOORMIRROR_H
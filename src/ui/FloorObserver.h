@@ -0,0 +1,29 @@
+#ifndef FLOOROBSERVER_H
+#define FLOOROBSERVER_H
+
+#include "Types.h"
+
+#include <QColor>
+
+namespace Turtle
+{
+	class TiledFloor;
+
+	//Receives the changes made to a TiledFloor
+	//Called on the thread that changes the floor.
+	class FloorObserver
+	{
+	public:
+		virtual ~FloorObserver() = default;
+
+		//The whole floor was replaced, resized or cleared
+		//Also called when the observer is added.
+		virtual void floorChanged(const TiledFloor & floor) = 0;
+
+		//A single tile was changed
+		//The tile is center based, and may be beyond the size of an unbounded floor.
+		virtual void tileChanged(const TiledFloor & floor, const TilePosition2D & tile, QRgb color) = 0;
+	};
+}
+
+#endif // FLOOROBSERVER_H
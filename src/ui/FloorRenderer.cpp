@@ -0,0 +1,334 @@
+#include "FloorRenderer.h"
+#include "DirtyRegion.h"
+#include "Trace.h"
+#include "RuntimeMetrics.h"
+
+#include <osg/Geometry>
+#include <osg/GLExtensions>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+using namespace Turtle;
+
+//Uploads the floor's pixels as they are, the whole of them only when the texture
+// is created, and afterwards only the dirty rectangles
+//The rectangles are copied into one of two pixel buffer objects, used in turns, and
+// uploaded from there. The copy itself is a plain synchronous one, on the drawing thread;
+// orphaning the buffer first only spares it waiting for the driver to be done
+// reading the previous upload.
+class FloorRenderer::Subload : public osg::Texture2D::SubloadCallback
+{
+public:
+	explicit Subload(const TiledFloor & floor) : m_floor{&floor} {}
+
+	//The renderer is gone, so there is nothing to upload
+	void detach() { m_floor = nullptr; }
+
+	DirtyRegion & region() { return m_region; }
+
+	bool textureObjectValid(const osg::Texture2D & texture, osg::State & state) const override
+	{
+		Q_UNUSED(texture)
+
+		//A resized floor needs a texture of its new size
+		const Context & context = this->context(state.getContextID());
+		return !m_floor || (QSize(context.width, context.height) == size());
+	}
+
+	void load(const osg::Texture2D & texture, osg::State & state) const override
+	{
+		Q_UNUSED(texture)
+		TURTLE_TRACE("FloorRenderer::load");
+
+		if (!m_floor)
+			return;
+
+		const QSize size = this->size();
+		Context & context = this->context(state.getContextID());
+
+		//Only held for the call, as the whole floor is loaded just when the texture is made
+		std::vector<uchar> pixels(static_cast<size_t>(size.width()) * static_cast<size_t>(size.height()) * 4);
+		m_floor->read(QRect({0, 0}, size), pixels.data());
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glTexImage2D(
+					GL_TEXTURE_2D, 0, GL_RGBA,
+					size.width(), size.height(), 0,
+					GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+		context.width = size.width();
+		context.height = size.height();
+
+		m_region.clear();
+		RuntimeMetrics::global().uploaded(pixels.size());
+	}
+
+	void subload(const osg::Texture2D & texture, osg::State & state) const override
+	{
+		if (!m_floor || m_region.isEmpty())
+			return;
+
+		//For OpenSceneGraph versions that don't check textureObjectValid()
+		if (!textureObjectValid(texture, state))
+		{
+			load(texture, state);
+			return;
+		}
+
+		TURTLE_TRACE("FloorRenderer::subload");
+
+		const osg::GLExtensions * extensions = osg::GLExtensions::Get(state.getContextID(), true);
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		if (!extensions || !extensions->isPBOSupported || !stream(*extensions, context(state.getContextID())))
+		{
+			//Straight from client memory
+			m_staging.resize(static_cast<size_t>(m_region.area()) * 4);
+			pack(m_staging.data());
+			upload(reinterpret_cast<std::uintptr_t>(m_staging.data()));
+		}
+
+		RuntimeMetrics::global().uploaded(static_cast<std::uint64_t>(m_region.area()) * 4);
+		m_region.clear();
+	}
+
+	//Delete the pixel buffer objects of the state's context, which should be current,
+	// or forget those of all the contexts, as they're deleted with their contexts
+	void release(osg::State * state) const
+	{
+		if (!state)
+		{
+			m_contexts.clear();
+			return;
+		}
+
+		const unsigned int id = state->getContextID();
+		if (id >= m_contexts.size())
+			return;
+
+		Context & context = m_contexts[id];
+		const osg::GLExtensions * extensions = osg::GLExtensions::Get(id, false);
+		if (extensions && context.buffers[0])
+			extensions->glDeleteBuffers(static_cast<GLsizei>(context.buffers.size()), context.buffers.data());
+
+		context = {};
+	}
+
+private:
+	//What was created in each graphics context
+	//The dirty region is not, as it's taken by the first context uploading it.
+	//So the floor must be drawn by a single view, on the thread that changes it,
+	// which is also why the region is not locked.
+	struct Context
+	{
+		std::array<GLuint, 2> buffers {};
+		size_t next = 0;
+
+		//Of the texture
+		int width = 0;
+		int height = 0;
+	};
+
+	Context & context(unsigned int id) const
+	{
+		if (id >= m_contexts.size())
+			m_contexts.resize(id + 1);
+
+		return m_contexts[id];
+	}
+
+	//Of the floor's image, and so of the texture
+	QSize size() const
+	{
+		const TilePosition2D size = m_floor->halfIndexSize() * 2 + 1;
+		return {size.x(), size.y()};
+	}
+
+	//Copy the pixels of the rectangles, one after another
+	void pack(uchar * target) const
+	{
+		for (const QRect & rect : m_region.rects())
+		{
+			m_floor->read(rect, target);
+			target += static_cast<size_t>(rect.width()) * static_cast<size_t>(rect.height()) * 4;
+		}
+	}
+
+	//The rectangles packed from this address, or from this offset into the bound pixel buffer object
+	void upload(std::uintptr_t address) const
+	{
+		for (const QRect & rect : m_region.rects())
+		{
+			glTexSubImage2D(
+						GL_TEXTURE_2D, 0,
+						rect.x(), rect.y(), rect.width(), rect.height(),
+						GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<const void *>(address));
+
+			address += static_cast<std::uintptr_t>(rect.width()) * static_cast<std::uintptr_t>(rect.height()) * 4;
+		}
+	}
+
+	//Through the next pixel buffer object
+	bool stream(const osg::GLExtensions & extensions, Context & context) const
+	{
+		if (!context.buffers[0])
+			extensions.glGenBuffers(static_cast<GLsizei>(context.buffers.size()), context.buffers.data());
+
+		const GLuint buffer = context.buffers[context.next];
+		context.next = (context.next + 1) % context.buffers.size();
+
+		extensions.glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, buffer);
+
+		//Orphan the storage of the previous upload, which may still be in flight
+		extensions.glBufferData(GL_PIXEL_UNPACK_BUFFER_ARB, static_cast<GLsizeiptr>(m_region.area() * 4), nullptr, GL_STREAM_DRAW_ARB);
+
+		uchar * mapped = static_cast<uchar *>(extensions.glMapBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB));
+		if (!mapped)
+		{
+			extensions.glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+			return false;
+		}
+
+		pack(mapped);
+
+		//The data was lost if the buffer was corrupted meanwhile, so it's uploaded again from client memory
+		const bool unmapped = extensions.glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER_ARB);
+		if (unmapped)
+			upload(0);
+
+		extensions.glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+		return unmapped;
+	}
+
+	const TiledFloor * m_floor;
+
+	//Taken by the next upload
+	mutable DirtyRegion m_region;
+
+	//The pixels of subloads from client memory, which are only of the changed parts
+	mutable std::vector<uchar> m_staging;
+
+	mutable std::vector<Context> m_contexts;
+};
+
+class FloorRenderer::Texture : public osg::Texture2D
+{
+public:
+	explicit Texture(Subload * subload) : m_subload{subload}
+	{
+		setSubloadCallback(subload);
+	}
+
+	void releaseGLObjects(osg::State * state = nullptr) const override
+	{
+		osg::Texture2D::releaseGLObjects(state);
+		m_subload->release(state);
+	}
+
+private:
+	osg::ref_ptr<Subload> m_subload;
+};
+
+FloorRenderer::FloorRenderer(TiledFloor & floor) :
+	m_tiledFloor{floor},
+	m_subload{new Subload{floor}},
+	m_texture{new Texture{m_subload.get()}},
+	m_floor{new osg::Geode},
+	m_root{new osg::Group}
+{
+	//There are no mipmaps, as they would be made again for every change
+	m_texture->setDataVariance(osg::Object::DYNAMIC);
+	m_texture->setInternalFormat(GL_RGBA);
+	m_texture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR);
+	m_texture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
+
+	m_root->addChild(m_floor);
+
+	//This reports the whole floor right away
+	m_tiledFloor.addObserver(this);
+}
+
+FloorRenderer::~FloorRenderer()
+{
+	m_tiledFloor.removeObserver(this);
+
+	//The texture may outlive us in the scene graph
+	m_subload->detach();
+}
+
+void FloorRenderer::floorChanged(const TiledFloor & floor)
+{
+	TURTLE_TRACE("FloorRenderer::floorChanged");
+
+	const TilePosition2D size = floor.halfIndexSize() * 2 + 1;
+	m_texture->setTextureSize(size.x(), size.y());
+	m_subload->region().addAll(size.x(), size.y());
+
+	if (floor.halfSize() != m_halfSize)
+	{
+		m_halfSize = floor.halfSize();
+
+		//Replace the old floor
+		m_root->removeChild(m_floor);
+		createQuad(m_halfSize);
+		m_root->addChild(m_floor);
+	}
+}
+
+void FloorRenderer::tileChanged(const TiledFloor & floor, const TilePosition2D & tile, QRgb color)
+{
+	Q_UNUSED(color)
+	TURTLE_TRACE("FloorRenderer::tileChanged");
+
+	//Only the size of an unbounded floor is shown
+	const TilePosition2D halfSize = floor.halfIndexSize();
+	if (!((tile >= -halfSize) && (tile <= halfSize)))
+		return;
+
+	//Note that the Y axis is inverted, as in the image
+	m_subload->region().add(tile.x() + halfSize.x(), halfSize.y() - tile.y());
+}
+
+void FloorRenderer::createQuad(const Position2D & halfSize)
+{
+	auto toVec3 = [](Position2D pos) -> osg::Vec3
+	{
+		return osg::Vec3
+		{
+			static_cast<osg::Vec3::value_type>(pos.x()),
+			static_cast<osg::Vec3::value_type>(pos.y()),
+			0
+		};
+	};
+
+	osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+	vertices->push_back( toVec3(halfSize * Position2D{-1,-1}) );
+	vertices->push_back( toVec3(halfSize * Position2D{1,-1}) );
+	vertices->push_back( toVec3(halfSize * Position2D{1,1}) );
+	vertices->push_back( toVec3(halfSize * Position2D{-1,1}) );
+
+	osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array;
+	normals->push_back( osg::Vec3(0.0f,0.0f, 1.0f) );
+
+	//The first row of the floor's image is its top
+	osg::ref_ptr<osg::Vec2Array> texcoords = new osg::Vec2Array;
+	texcoords->push_back( osg::Vec2(0.0f, 1.0f) );
+	texcoords->push_back( osg::Vec2(1.0f, 1.0f) );
+	texcoords->push_back( osg::Vec2(1.0f, 0.0f) );
+	texcoords->push_back( osg::Vec2(0.0f, 0.0f) );
+
+	osg::ref_ptr<osg::Geometry> quad = new osg::Geometry;
+	quad->setVertexArray( vertices );
+	quad->setNormalArray( normals );
+	quad->setNormalBinding( osg::Geometry::BIND_OVERALL );
+	quad->setTexCoordArray( 0, texcoords );
+
+	quad->addPrimitiveSet( new osg::DrawArrays(osg::DrawArrays::QUADS, 0, 4) );
+
+	m_floor = new osg::Geode;
+	m_floor->addDrawable( quad );
+	m_floor->getOrCreateStateSet()->setTextureAttributeAndModes(0, m_texture );
+}
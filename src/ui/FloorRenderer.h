@@ -0,0 +1,56 @@
+#ifndef FLOORRENDERER_H
+#define FLOORRENDERER_H
+
+#include "Types.h"
+#include "FloorObserver.h"
+#include "TiledFloor.h"
+
+#include <osg/Node>
+#include <osg/Group>
+#include <osg/Geode>
+#include <osg/Texture2D>
+
+namespace Turtle
+{
+	//The graphical representation of a TiledFloor
+	//A textured quad, kept up to date by observing the floor.
+	//Only the parts of the texture that changed since the previous frame are uploaded.
+	//The floor is drawn by a single view, see FloorRenderer::Subload.
+	class FloorRenderer : public FloorObserver
+	{
+	public:
+		explicit FloorRenderer(TiledFloor & floor);
+		~FloorRenderer() override;
+
+		//Access functors
+		osg::ref_ptr<osg::Node> root() {return m_root;}
+
+		void floorChanged(const TiledFloor & floor) override;
+		void tileChanged(const TiledFloor & floor, const TilePosition2D & tile, QRgb color) override;
+
+	private:
+		void createQuad(const Position2D & halfSize);
+
+		//Uploads the changed parts of the floor when the texture is applied
+		class Subload;
+
+		//Releases the pixel buffer objects of the subload with its own objects
+		class Texture;
+
+		TiledFloor & m_tiledFloor;
+
+		//The size the quad was created for
+		Position2D m_halfSize;
+
+		osg::ref_ptr<Subload> m_subload;
+		osg::ref_ptr<osg::Texture2D> m_texture;
+
+		//The textured floor geometry
+		osg::ref_ptr<osg::Geode> m_floor;
+
+		//The floor root
+		osg::ref_ptr<osg::Group> m_root;
+	};
+
+}
+#endif // FLOORRENDERER_H
@@ -0,0 +1,46 @@
+#include "FrameStatistics.h"
+#include "CommandStatistics.h"
+
+using namespace Turtle;
+
+FrameStatistics & FrameStatistics::global()
+{
+	static FrameStatistics statistics;
+	return statistics;
+}
+
+void FrameStatistics::frame(qint64 period)
+{
+	const qint64 now = CommandStatistics::now();
+	const qint64 last = m_last.exchange(now, std::memory_order_relaxed);
+
+	m_frames.fetch_add(1, std::memory_order_relaxed);
+
+	//The first frame has nothing to be late for
+	if (!last || (period <= 0))
+		return;
+
+	const qint64 interval = now - last;
+	m_intervals.record(static_cast<std::uint64_t>(interval));
+
+	if (interval > period + period / 2)
+	{
+		m_late.fetch_add(1, std::memory_order_relaxed);
+		m_dropped.fetch_add(static_cast<std::uint64_t>((interval + period / 2) / period - 1), std::memory_order_relaxed);
+	}
+}
+
+void FrameStatistics::painted(qint64 duration)
+{
+	m_paints.record(static_cast<std::uint64_t>(std::max<qint64>(0, duration)));
+}
+
+void FrameStatistics::reset()
+{
+	m_last.store(0, std::memory_order_relaxed);
+	m_frames.store(0, std::memory_order_relaxed);
+	m_late.store(0, std::memory_order_relaxed);
+	m_dropped.store(0, std::memory_order_relaxed);
+	m_intervals.reset();
+	m_paints.reset();
+}
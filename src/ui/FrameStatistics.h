@@ -0,0 +1,54 @@
+#ifndef FRAMESTATISTICS_H
+#define FRAMESTATISTICS_H
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <cstdint>
+
+#include "LatencyHistogram.h"
+
+namespace Turtle
+{
+	//How well the frames of the user interface keep to their schedule
+	//The frame timer records each tick and the views the time they took to paint,
+	// while any other thread may read the totals, e.g. a load generating brain.
+	class FrameStatistics
+	{
+	public:
+		//The statistics of the user interface of this process
+		static FrameStatistics & global();
+
+		//A frame starts now, one period after the previous one was due
+		//A frame more than half a period late is counted as late, and each whole
+		// period skipped is counted as a dropped frame.
+		//Called only by the thread running the frames.
+		void frame(qint64 period);
+
+		//A view painted, taking this long, in nanoseconds
+		void painted(qint64 duration);
+
+		void reset();
+
+		std::uint64_t frames() const { return m_frames.load(std::memory_order_relaxed); }
+		std::uint64_t late() const { return m_late.load(std::memory_order_relaxed); }
+		std::uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+		//Between the starts of consecutive frames
+		const LatencyHistogram & intervals() const { return m_intervals; }
+		const LatencyHistogram & paints() const { return m_paints; }
+
+	private:
+		//The start of the previous frame, or 0 before the first one
+		std::atomic<qint64> m_last {0};
+
+		std::atomic<std::uint64_t> m_frames {0};
+		std::atomic<std::uint64_t> m_late {0};
+		std::atomic<std::uint64_t> m_dropped {0};
+
+		LatencyHistogram m_intervals;
+		LatencyHistogram m_paints;
+	};
+
+}
+#endif // FRAMESTATISTICS_H
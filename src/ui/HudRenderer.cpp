@@ -0,0 +1,223 @@
+#include "HudRenderer.h"
+#include "CommandStatistics.h"
+#include "FrameStatistics.h"
+#include "RuntimeMetrics.h"
+
+#include <QString>
+
+#include <osg/BlendFunc>
+#include <osg/Geode>
+
+#include <algorithm>
+
+using namespace Turtle;
+
+namespace
+{
+	//The panel, in pixels from the top left of the view
+	constexpr float margin = 10;
+	constexpr float padding = 8;
+	constexpr float panelWidth = 300;
+	constexpr float textHeight = 100;
+	constexpr float sparklineHeight = 40;
+	constexpr float panelHeight = padding + textHeight + sparklineHeight + padding;
+
+	//What was counted between two samples, or since a reset in between
+	std::uint64_t delta(std::uint64_t from, std::uint64_t to)
+	{
+		return (to >= from) ? to - from : to;
+	}
+
+	osg::ref_ptr<osg::Geometry> createGeometry(GLenum mode, const osg::Vec4 & color, int bin)
+	{
+		osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+		geometry->setDataVariance(osg::Object::DYNAMIC);
+		geometry->setUseDisplayList(false);
+		geometry->setUseVertexBufferObjects(true);
+		geometry->setVertexArray(new osg::Vec3Array);
+
+		osg::ref_ptr<osg::Vec4Array> colors = new osg::Vec4Array;
+		colors->push_back(color);
+		geometry->setColorArray(colors, osg::Array::BIND_OVERALL);
+
+		geometry->addPrimitiveSet(new osg::DrawArrays(mode, 0, 0));
+
+		//Drawn in order, over each other
+		geometry->getOrCreateStateSet()->setRenderBinDetails(bin, "RenderBin");
+
+		return geometry;
+	}
+}
+
+HudRenderer::HudRenderer() :
+	m_camera{new osg::Camera},
+	m_panel{createGeometry(GL_QUADS, {0, 0, 0, 0.6f}, 0)},
+	m_sparkline{createGeometry(GL_LINE_STRIP, {0.4f, 1, 0.4f, 1}, 1)},
+	m_text{new osgText::Text}
+{
+	//Drawn in window coordinates after the scene, and never picked
+	m_camera->setReferenceFrame(osg::Transform::ABSOLUTE_RF);
+	m_camera->setViewMatrix(osg::Matrix::identity());
+	m_camera->setRenderOrder(osg::Camera::POST_RENDER);
+	m_camera->setClearMask(0);
+	m_camera->setAllowEventFocus(false);
+	m_camera->setNodeMask(0);
+
+	osg::StateSet * state = m_camera->getOrCreateStateSet();
+	state->setMode(GL_LIGHTING, osg::StateAttribute::OFF | osg::StateAttribute::PROTECTED);
+	state->setMode(GL_DEPTH_TEST, osg::StateAttribute::OFF | osg::StateAttribute::PROTECTED);
+	state->setMode(GL_BLEND, osg::StateAttribute::ON);
+	state->setAttribute(new osg::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+
+	m_text->setDataVariance(osg::Object::DYNAMIC);
+	m_text->setCharacterSize(14);
+	m_text->setAlignment(osgText::Text::LEFT_TOP);
+	m_text->setColor({1, 1, 1, 1});
+	m_text->getOrCreateStateSet()->setRenderBinDetails(2, "RenderBin");
+
+	osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+	geode->addDrawable(m_panel);
+	geode->addDrawable(m_sparkline);
+	geode->addDrawable(m_text);
+	m_camera->addChild(geode);
+}
+
+void HudRenderer::setVisible(bool visible)
+{
+	m_visible = visible;
+	m_camera->setNodeMask(visible ? ~0u : 0u);
+
+	//Start over, as nothing was followed while hidden
+	m_last.time = 0;
+	m_steps.clear();
+	m_text->setText("");
+	drawSparkline();
+}
+
+void HudRenderer::update()
+{
+	if (!m_visible)
+		return;
+
+	if (m_view.valid() && m_view->getViewport())
+	{
+		const int width = static_cast<int>(m_view->getViewport()->width());
+		const int height = static_cast<int>(m_view->getViewport()->height());
+
+		if ((width != m_width) || (height != m_height))
+			layout(width, height);
+	}
+
+	const qint64 now = CommandStatistics::now();
+	if (!m_last.time)
+		take(m_last, now);
+	else if (now - m_last.time >= static_cast<qint64>(refreshPeriod * 1e9))
+		refresh(now);
+}
+
+void HudRenderer::take(Sample & sample, qint64 time)
+{
+	const RuntimeMetrics & metrics = RuntimeMetrics::global();
+	const FrameStatistics & frames = FrameStatistics::global();
+
+	sample.time = time;
+	sample.steps = metrics.count(RuntimeMetrics::Counter::Steps);
+	sample.frames = frames.paints().count();
+	sample.paintTime = frames.paints().sum();
+	sample.uploadBytes = metrics.count(RuntimeMetrics::Counter::UploadBytes);
+	sample.blockedTime = metrics.count(RuntimeMetrics::Counter::BlockedTime);
+	CommandStatistics::global().roundTrips().counts(sample.roundTrips);
+}
+
+void HudRenderer::refresh(qint64 time)
+{
+	Sample sample;
+	take(sample, time);
+
+	const double seconds = static_cast<double>(sample.time - m_last.time) * 1e-9;
+	const std::uint64_t frames = delta(m_last.frames, sample.frames);
+
+	const double steps = static_cast<double>(delta(m_last.steps, sample.steps)) / seconds;
+	const double fps = static_cast<double>(frames) / seconds;
+	const double frameTime = frames ? static_cast<double>(delta(m_last.paintTime, sample.paintTime)) / static_cast<double>(frames) * 1e-6 : 0;
+	const double upload = frames ? static_cast<double>(delta(m_last.uploadBytes, sample.uploadBytes)) / static_cast<double>(frames) : 0;
+
+	const double p50 = static_cast<double>(LatencyHistogram::percentile(m_last.roundTrips, sample.roundTrips, 0.5)) * 1e-3;
+	const double p99 = static_cast<double>(LatencyHistogram::percentile(m_last.roundTrips, sample.roundTrips, 0.99)) * 1e-3;
+
+	//The part of the running brains' time not spent waiting for us
+	const int brains = RuntimeMetrics::global().brains();
+	const double blocked = static_cast<double>(delta(m_last.blockedTime, sample.blockedTime)) * 1e-9 / seconds;
+	const double utilization = (brains > 0) ? std::clamp(1 - blocked / brains, 0.0, 1.0) : 0;
+
+	m_last = sample;
+
+	const QString text =
+			QString("Steps/s: %1\n").arg(steps, 0, 'f', 0) +
+			QString("Frames/s: %1, %2 ms each\n").arg(fps, 0, 'f', 1).arg(frameTime, 0, 'f', 2) +
+			QString("Round trip: p50 %1 µs, p99 %2 µs\n").arg(p50, 0, 'f', 1).arg(p99, 0, 'f', 1) +
+			QString("Brains: %1 running, %2% busy\n").arg(brains).arg(utilization * 100, 0, 'f', 0) +
+			QString("Upload: %1 KB/frame").arg(upload / 1024, 0, 'f', 1);
+
+	m_text->setText(text.toStdString(), osgText::String::ENCODING_UTF8);
+
+	m_steps.push_back(steps);
+	if (m_steps.size() > history)
+		m_steps.pop_front();
+
+	drawSparkline();
+}
+
+void HudRenderer::layout(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+
+	m_camera->setProjectionMatrixAsOrtho2D(0, width, 0, height);
+
+	//The top left corner of the panel
+	const float left = margin;
+	const float top = static_cast<float>(height) - margin;
+
+	osg::Vec3Array * corners = static_cast<osg::Vec3Array *>(m_panel->getVertexArray());
+	corners->clear();
+	corners->push_back({left, top - panelHeight, 0});
+	corners->push_back({left + panelWidth, top - panelHeight, 0});
+	corners->push_back({left + panelWidth, top, 0});
+	corners->push_back({left, top, 0});
+	corners->dirty();
+
+	static_cast<osg::DrawArrays *>(m_panel->getPrimitiveSet(0))->setCount(4);
+	m_panel->dirtyBound();
+
+	m_text->setPosition({left + padding, top - padding, 0});
+
+	drawSparkline();
+}
+
+void HudRenderer::drawSparkline()
+{
+	osg::Vec3Array * points = static_cast<osg::Vec3Array *>(m_sparkline->getVertexArray());
+	points->clear();
+
+	const double highest = m_steps.empty() ? 0 : *std::max_element(m_steps.cbegin(), m_steps.cend());
+
+	//Along the bottom of the panel, the latest at the right
+	const float left = margin + padding;
+	const float bottom = static_cast<float>(m_height) - margin - panelHeight + padding;
+	const float step = (panelWidth - 2 * padding) / (history - 1);
+	const float start = left + step * static_cast<float>(history - m_steps.size());
+
+	for (size_t i = 0; i < m_steps.size(); ++i)
+		points->push_back(
+		{
+			start + step * static_cast<float>(i),
+			bottom + ((highest > 0) ? static_cast<float>(m_steps[i] / highest) * (sparklineHeight - padding) : 0),
+			0
+		});
+
+	points->dirty();
+
+	static_cast<osg::DrawArrays *>(m_sparkline->getPrimitiveSet(0))->setCount(static_cast<GLsizei>(points->size()));
+	m_sparkline->dirtyBound();
+}
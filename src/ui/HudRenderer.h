@@ -0,0 +1,82 @@
+#ifndef HUDRENDERER_H
+#define HUDRENDERER_H
+
+#include "LatencyHistogram.h"
+
+#include <QtGlobal>
+
+#include <osg/Camera>
+#include <osg/Geometry>
+#include <osg/observer_ptr>
+#include <osgText/Text>
+
+#include <cstdint>
+#include <deque>
+
+namespace Turtle
+{
+	//A heads-up display of the performance, drawn over a view
+	//The numbers are taken from the counters the simulation keeps anyway, and
+	// refreshed only a few times a second, so drawing it costs next to nothing.
+	//The steps per second of the last half minute are drawn as a sparkline.
+	class HudRenderer
+	{
+	public:
+		HudRenderer();
+
+		//Refresh the numbers, if it's time to, while shown
+		void update();
+
+		//Lay out in the viewport of this camera
+		void setCamera(osg::Camera * camera) { m_view = camera; }
+
+		//Hidden at first, and costs nothing then
+		void setVisible(bool visible);
+		bool isVisible() const { return m_visible; }
+
+		//Access functors
+		osg::ref_ptr<osg::Node> root() const { return m_camera; }
+
+	private:
+		//Seconds between refreshes
+		static constexpr double refreshPeriod = 0.25;
+
+		//Refreshes drawn by the sparkline
+		static constexpr size_t history = 120;
+
+		//The counters at a refresh
+		struct Sample
+		{
+			qint64 time = 0;
+			std::uint64_t steps = 0;
+			std::uint64_t frames = 0;
+			std::uint64_t paintTime = 0;
+			std::uint64_t uploadBytes = 0;
+			std::uint64_t blockedTime = 0;
+			LatencyHistogram::Counts roundTrips {};
+		};
+
+		static void take(Sample & sample, qint64 time);
+
+		void refresh(qint64 time);
+		void layout(int width, int height);
+		void drawSparkline();
+
+		osg::ref_ptr<osg::Camera> m_camera;
+		osg::ref_ptr<osg::Geometry> m_panel;
+		osg::ref_ptr<osg::Geometry> m_sparkline;
+		osg::ref_ptr<osgText::Text> m_text;
+		osg::observer_ptr<osg::Camera> m_view;
+
+		//The viewport laid out for
+		int m_width = 0;
+		int m_height = 0;
+
+		bool m_visible = false;
+
+		Sample m_last;
+		std::deque<double> m_steps;
+	};
+
+}
+#endif // HUDRENDERER_H
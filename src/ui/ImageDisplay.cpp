@@ -1,4 +1,5 @@
 #include "ImageDisplay.h"
+#include "Trace.h"
 
 #include <QPainter>
 
@@ -19,6 +20,8 @@ QSize ImageDisplay::sizeHint() const
 
 void ImageDisplay::paintEvent(QPaintEvent*)
 {
+	TURTLE_TRACE("ImageDisplay::paintEvent");
+
 	if (!image)
 		return;
 
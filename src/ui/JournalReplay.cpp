@@ -0,0 +1,60 @@
+#include "JournalReplay.h"
+
+using namespace Turtle;
+
+JournalReplay::JournalReplay(World & world) :
+	m_world{world}
+{
+}
+
+bool JournalReplay::open(const QString & path)
+{
+	CommandJournal::Header header;
+	if (!m_reader.open(path, header) || header.turtles.empty())
+		return false;
+
+	m_world.setUnbounded(header.unbounded);
+	m_world.floor().setClearColor(QColor::fromRgba(header.clearColor));
+	m_world.setFloor(
+				{static_cast<Index2D::value_type>(header.halfSize.x()), static_cast<Index2D::value_type>(header.halfSize.y())},
+				header.chunks);
+
+	while (m_world.turtleCount() < header.turtles.size())
+		m_world.addTurtle();
+
+	m_controllers.clear();
+	for (size_t i = 0; i < header.turtles.size(); ++i)
+	{
+		m_controllers.push_back(std::make_unique<TurtleActorController>(m_world.turtle(i)));
+		m_controllers.back()->setLinearSpeed(header.turtles[i].linearSpeed);
+		m_controllers.back()->setRotationSpeed(header.turtles[i].rotationSpeed);
+		m_controllers.back()->setInstant(header.turtles[i].instant);
+	}
+
+	m_commands = 0;
+	return true;
+}
+
+bool JournalReplay::run()
+{
+	//Steps are counted from the start of the recording
+	const quint64 firstStep = m_world.stepCount();
+
+	CommandJournal::Entry entry;
+	while (m_reader.read(entry))
+	{
+		while ((m_world.stepCount() - firstStep) < entry.step)
+			m_world();
+
+		if (entry.kind == CommandJournal::Entry::Kind::End)
+			return true;
+
+		if ((entry.kind != CommandJournal::Entry::Kind::Command) || (entry.turtle >= m_controllers.size()))
+			continue;
+
+		m_controllers[entry.turtle]->command(entry.command);
+		++m_commands;
+	}
+
+	return false;
+}
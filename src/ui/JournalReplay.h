@@ -0,0 +1,46 @@
+#ifndef JOURNALREPLAY_H
+#define JOURNALREPLAY_H
+
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+#include "World.h"
+#include "CommandJournal.h"
+#include "TurtleActorController.h"
+
+namespace Turtle
+{
+	//Replays a CommandJournal into a world, without any brain
+	//Each command is applied at the step it was recorded at, through a controller of its
+	// own turtle, just as it was when recorded. Replies are not compared, since the brains
+	// that read them are not run.
+	//Commands recorded in the middle of a step are applied once it completes, which only
+	// matters when they jump turtles in instant mode onto tiles another turtle draws at that step.
+	class JournalReplay
+	{
+	public:
+		explicit JournalReplay(World & world);
+
+		//Set up the world as it was when recording started
+		//The world should be a fresh one.
+		bool open(const QString & path);
+
+		//Apply all the commands, stepping the world up to the end of the recording
+		//Returns false if the journal ended early, after applying all it could.
+		bool run();
+
+		quint64 commands() const { return m_commands; }
+
+	private:
+		World & m_world;
+		CommandJournal::Reader m_reader;
+
+		std::vector<std::unique_ptr<TurtleActorController>> m_controllers;
+
+		quint64 m_commands = 0;
+	};
+
+}
+#endif // JOURNALREPLAY_H
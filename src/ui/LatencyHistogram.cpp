@@ -0,0 +1,116 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Turtle;
+
+int LatencyHistogram::bucket(std::uint64_t value)
+{
+	//Small values are counted exactly
+	if (value < subBuckets)
+		return static_cast<int>(value);
+
+	int top = 63;
+	while (!(value >> top))
+		--top;
+
+	//The leading bits select the linear bucket inside the power of two
+	const int shift = top - subBucketBits;
+	const int mantissa = static_cast<int>(value >> shift) - subBuckets;
+
+	return (shift + 1) * subBuckets + mantissa;
+}
+
+std::uint64_t LatencyHistogram::bucketEnd(int bucket)
+{
+	if (bucket < subBuckets)
+		return static_cast<std::uint64_t>(bucket) + 1;
+
+	const int shift = bucket / subBuckets - 1;
+	const std::uint64_t mantissa = static_cast<std::uint64_t>(bucket % subBuckets + subBuckets);
+
+	//The very last bucket ends beyond the range, so it's saturated
+	const std::uint64_t end = (mantissa + 1) << shift;
+	return end ? end : ~std::uint64_t{0};
+}
+
+void LatencyHistogram::record(std::uint64_t value)
+{
+	m_buckets[static_cast<size_t>(bucket(value))].fetch_add(1, std::memory_order_relaxed);
+	m_count.fetch_add(1, std::memory_order_relaxed);
+	m_sum.fetch_add(value, std::memory_order_relaxed);
+
+	std::uint64_t max = m_max.load(std::memory_order_relaxed);
+	while ((value > max) && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) ;
+}
+
+void LatencyHistogram::reset()
+{
+	for (auto & bucket : m_buckets)
+		bucket.store(0, std::memory_order_relaxed);
+
+	m_count.store(0, std::memory_order_relaxed);
+	m_sum.store(0, std::memory_order_relaxed);
+	m_max.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const
+{
+	const std::uint64_t samples = count();
+	return samples ? static_cast<double>(m_sum.load(std::memory_order_relaxed)) / static_cast<double>(samples) : 0;
+}
+
+std::uint64_t LatencyHistogram::percentile(double fraction) const
+{
+	//The buckets are read while being written, so their total is what's used
+	std::uint64_t total = 0;
+	for (const auto & bucket : m_buckets)
+		total += bucket.load(std::memory_order_relaxed);
+
+	if (!total)
+		return 0;
+
+	const std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(total))));
+
+	std::uint64_t seen = 0;
+	for (int i = 0; i < buckets; ++i)
+	{
+		seen += m_buckets[static_cast<size_t>(i)].load(std::memory_order_relaxed);
+		if (seen >= rank)
+			return std::min(bucketEnd(i) - 1, max());
+	}
+
+	return max();
+}
+
+void LatencyHistogram::counts(Counts & counts) const
+{
+	for (size_t i = 0; i < counts.size(); ++i)
+		counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyHistogram::percentile(const Counts & from, const Counts & to, double fraction)
+{
+	//A reset in between loses the values recorded before it
+	auto recorded = [&from, &to](size_t i) { return (to[i] >= from[i]) ? to[i] - from[i] : to[i]; };
+
+	std::uint64_t total = 0;
+	for (size_t i = 0; i < to.size(); ++i)
+		total += recorded(i);
+
+	if (!total)
+		return 0;
+
+	const std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(total))));
+
+	std::uint64_t seen = 0;
+	for (int i = 0; i < buckets; ++i)
+	{
+		seen += recorded(static_cast<size_t>(i));
+		if (seen >= rank)
+			return bucketEnd(i) - 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,54 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace Turtle
+{
+	//A histogram of durations, in nanoseconds, that any thread may record to without locking
+	//The buckets are log-linear, as in HDR histograms: each power of two is split to
+	// subBuckets linear buckets, so any value is kept within about 6% of its size.
+	class LatencyHistogram
+	{
+	public:
+		static constexpr int subBucketBits = 4;
+		static constexpr int subBuckets = 1 << subBucketBits;
+		static constexpr int buckets = (64 - subBucketBits + 1) * subBuckets;
+
+		//The values counted by each bucket
+		using Counts = std::array<std::uint64_t, buckets>;
+
+		void record(std::uint64_t value);
+		void reset();
+
+		std::uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+		std::uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+		std::uint64_t sum() const { return m_sum.load(std::memory_order_relaxed); }
+		double mean() const;
+
+		//The value below which a fraction of the recorded values are, in [0,1]
+		//Reported as the upper end of the bucket it falls in.
+		std::uint64_t percentile(double fraction) const;
+
+		//Copy the counts of the buckets, to take percentiles of the values recorded since
+		void counts(Counts & counts) const;
+
+		//The percentile of the values recorded between two copies of the counts
+		static std::uint64_t percentile(const Counts & from, const Counts & to, double fraction);
+
+		static int bucket(std::uint64_t value);
+
+		//The smallest value that falls beyond a bucket
+		static std::uint64_t bucketEnd(int bucket);
+
+	private:
+		std::array<std::atomic<std::uint64_t>, buckets> m_buckets {};
+		std::atomic<std::uint64_t> m_count {0};
+		std::atomic<std::uint64_t> m_sum {0};
+		std::atomic<std::uint64_t> m_max {0};
+	};
+
+}
+#endif // LATENCYHISTOGRAM_H
@@ -1,5 +1,11 @@
 #include <QApplication>
+#include <QCommandLineParser>
 #include "MainWindow.h"
+#include "CommandStatistics.h"
+#include "MetricsFile.h"
+
+#include <cstdio>
+#include <memory>
 
 int main(int argc, char** argv)
 {
@@ -13,11 +19,36 @@ int main(int argc, char** argv)
 
 	QApplication qapp(argc, argv);
 
+	QCommandLineParser parser;
+	parser.addHelpOption();
+
+	const QCommandLineOption metricsOption(
+				"metrics",
+				"Write the runtime metrics to a file, in the Prometheus text format.",
+				"file");
+	const QCommandLineOption metricsIntervalOption(
+				"metrics-interval",
+				"Seconds between writes of the metrics file.",
+				"seconds", "10");
+
+	parser.addOptions({metricsOption, metricsIntervalOption});
+	parser.process(qapp);
+
+	std::unique_ptr<MetricsFile> metrics;
+	if (parser.isSet(metricsOption))
+		metrics = std::make_unique<MetricsFile>(parser.value(metricsOption), parser.value(metricsIntervalOption).toInt());
+
 	MainWindow w;
 	w.showMaximized();
 
 	//Run the Qt application.
 	//By default the rendered OSG view will only be updated when the
 	// camera manipulator processes a mouse event or when the widget is resized
-	return qapp.exec();
+	const int result = qapp.exec();
+
+	//Dump the command statistics of the whole session
+	if (!Turtle::CommandStatistics::global().isEmpty())
+		fputs(qPrintable(Turtle::CommandStatistics::global().report()), stderr);
+
+	return result;
 }
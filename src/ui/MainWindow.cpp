@@ -14,6 +14,9 @@
 
 #include "QtOSGWidget.h"
 #include "QtOSGMouseHandler.h"
+#include "FrameStatistics.h"
+#include "Trace.h"
+#include "main.h"
 
 MainWindow::MainWindow(QWidget *parent) :
 	QMainWindow(parent),
@@ -21,10 +24,15 @@ MainWindow::MainWindow(QWidget *parent) :
 	stepTimer(new QTimer(this)),
 	frameTimer(new QTimer(this)),
 	world{},
-	actor{new TurtleActorController(world.mainActor(), this)},
-	brain{new ThreadedBrainController(actor, this)}
+	renderer{world},
+	floorImage{world.floor()},
+	userInput{this}
 {
 	ui->setupUi(this);
+
+	addAgent(world.mainActor());
+	actor = agents.front()->controller();
+
 	QTimer::singleShot(0,[this]()
 	{
 		QList<int> sizes = ui->splitterMiddle->sizes();
@@ -52,14 +60,8 @@ MainWindow::MainWindow(QWidget *parent) :
 		ui->blue->setValue(color.blueF());
 	});
 
-	connect(ui->singleStep, &QCheckBox::toggled, actor, &TurtleActorController::setSingleStep);
-	connect(ui->Continue, &QPushButton::clicked, actor, &TurtleActorController::continueSingleStep);
-
-
-
 	//Robot to UI signals
 	//-------------------
-	connect(actor, &TurtleActorController::log, ui->log, &QTextBrowser::append);
 	connect(actor, &TurtleActorController::newCurrentState, this, &MainWindow::newCurrentState);
 	connect(actor, &TurtleActorController::newRunState,
 			[this](bool active) {ui->Continue->setEnabled(!active);});
@@ -67,23 +69,16 @@ MainWindow::MainWindow(QWidget *parent) :
 
 	//UI to brain signals
 	//-------------------
-	connect(ui->start, &QPushButton::clicked, this, &MainWindow::run);
+	connect(ui->start, &QPushButton::clicked, this, &MainWindow::start);
 	connect(ui->stop, &QPushButton::clicked, this, &MainWindow::stop);
 
-	connect(this, &MainWindow::run, brain, &ThreadedBrainController::start);
-	connect(this, &MainWindow::stop, brain, &ThreadedBrainController::stop);
-
-	//Brain to UI signals
-	//-------------------
-	connect(brain, &ThreadedBrainController::started, this, &MainWindow::started);
-	connect(brain, &ThreadedBrainController::stopped, this, &MainWindow::stopped);
-
 
 	//Initialization
 	//--------------
+	world.setStepThreads(0);
 	resize();
 
-	setupViews(world.scene().root());
+	setupViews(renderer.root());
 
 	connect(frameTimer, &QTimer::timeout, this, &MainWindow::frame);
 	frameTimer->start(static_cast<int>(1000.0 / frameRate));
@@ -94,11 +89,20 @@ MainWindow::MainWindow(QWidget *parent) :
 
 MainWindow::~MainWindow()
 {
+	//The agents control the world's turtles, so they go first
+	for (auto agent = agents.rbegin(); agent != agents.rend(); ++agent)
+		delete *agent;
+
 	delete ui;
 }
 
 void MainWindow::frame()
 {
+	Turtle::FrameStatistics::global().frame(static_cast<qint64>(1e9 / frameRate));
+
+	renderer.update(1.0 / frameRate);
+	hud.update();
+
 	ui->followView->update();
 	ui->image->update();
 	ui->tileSensor->update();
@@ -113,7 +117,7 @@ void MainWindow::setupFollowView(osg::ref_ptr<osg::Node> node)
 {
 	osg::ref_ptr<osgGA::NodeTrackerManipulator> manipulator = new osgGA::NodeTrackerManipulator;
 	manipulator->setRotationMode(osgGA::NodeTrackerManipulator::ELEVATION_AZIM);
-	manipulator->setTrackNode(world.mainActor().robotRoot());
+	manipulator->setTrackNode(renderer.mainActor().robotRoot());
 
 	ui->followView->getViewer()->setCameraManipulator(manipulator);
 	new QtOSGMouseHandler(ui->followView);
@@ -127,8 +131,105 @@ void MainWindow::setupFollowView(osg::ref_ptr<osg::Node> node)
 	aspectRatio2 /= ui->followView->height();
 	ui->followView->getCamera()->setProjectionMatrixAsPerspective( 45, aspectRatio2, 0.1, 1000 );
 
+	//Large swarms are shown only where the camera looks
+	renderer.setCamera(ui->followView->getCamera());
+
+	//The performance overlay is drawn over the scene, in the view's coordinates
+	hud.setCamera(ui->followView->getCamera());
+
+	osg::ref_ptr<osg::Group> root = new osg::Group;
+	root->addChild(node);
+	root->addChild(hud.root());
+
 	//This should be after all the camera setup
-	ui->followView->setSceneData(node);
+	ui->followView->setSceneData(root);
+}
+
+void MainWindow::addAgent(TurtleActor & turtle)
+{
+	TurtleAgent * agent = new TurtleAgent(turtle, nullptr, this);
+	TurtleActorController * controller = agent->controller();
+	const bool main = agents.empty();
+
+	agents.push_back(agent);
+
+	//Set up like the main turtle
+	controller->setUserInput(&userInput);
+	controller->setSingleStep(ui->singleStep->isChecked());
+	controller->setInstant(ui->actionInstant->isChecked());
+	agent->setWriteBehind(ui->actionWrite_behind->isChecked());
+
+	if (!main)
+	{
+		controller->setLinearSpeed(actor->linearSpeed());
+		controller->setRotationSpeed(actor->rotationSpeed());
+	}
+
+	connect(ui->singleStep, &QCheckBox::toggled, controller, &TurtleActorController::setSingleStep);
+	connect(ui->Continue, &QPushButton::clicked, controller, &TurtleActorController::continueSingleStep);
+
+	//Robot to UI signals
+	//-------------------
+	if (main)
+		connect(controller, &TurtleActorController::log, ui->log, &QTextBrowser::append);
+	else
+		connect(controller, &TurtleActorController::log,
+				[this, name = turtle.name()](QString text) {ui->log->append("<i>" + name + "</i>: " + text);});
+
+	//UI to brain signals
+	//-------------------
+	connect(this, &MainWindow::run, agent, &TurtleAgent::start);
+	connect(this, &MainWindow::stop, agent, &TurtleAgent::stop);
+
+	//Brain to UI signals
+	//-------------------
+	//Started with the first brain, and stopped with the last
+	connect(agent, &TurtleAgent::started, [this, agent]
+	{
+		if (runningAgents.empty())
+			started();
+
+		runningAgents.insert(agent);
+	});
+
+	connect(agent, &TurtleAgent::stopped, [this, agent]
+	{
+		if (runningAgents.erase(agent) && runningAgents.empty())
+			stopped();
+	});
+}
+
+void MainWindow::setTurtleCount(size_t count)
+{
+	//Remove from the end, the main turtle always stays
+	while ((agents.size() > count) && (agents.size() > 1))
+	{
+		TurtleAgent * agent = agents.back();
+		TurtleActor & turtle = agent->actor();
+		agents.pop_back();
+
+		//Its stopped signal is never received
+		if (runningAgents.erase(agent) && runningAgents.empty())
+			stopped();
+
+		delete agent;
+		world.removeTurtle(turtle);
+	}
+
+	while (agents.size() < count)
+		addAgent(world.addTurtle());
+}
+
+void MainWindow::start()
+{
+	//A dialog per brain would stop the world while each is open
+	if (!userInput.getInteger("Select an algorithm", algorithmList(), algorithm, 0, algorithmCount() - 1, 1))
+		return;
+
+	for (TurtleAgent * agent : agents)
+		agent->setProgram([algorithm = algorithm](ThreadedBrain & brain){Main(brain, algorithm);});
+
+	emit run();
 }
 
 void MainWindow::resize()
@@ -145,7 +246,7 @@ void MainWindow::resize()
 
 	ui->relativeDistance->setRange(-2*size*sqrt(2), 2*size*sqrt(2));
 
-	ui->image->setImage(&world.floor().image());
+	ui->image->setImage(&floorImage.image());
 	ui->tileSensor->setImage(&world.mainActor().tileSensorImage());
 }
 
@@ -179,12 +280,14 @@ void MainWindow::newCurrentState(const Command & data)
 	if (data.data.turtle.command != Command::Turtle::Command::Get)
 		return;
 	if (data.data.turtle.target != Command::Turtle::Target::Current)
-		return
+		return;
+
+	const QColor color = data.data.turtle.color;
 
 	ui->penDown->setChecked(data.data.turtle.penDown);
-	ui->red->setValue(data.data.turtle.color.redF());
-	ui->green->setValue(data.data.turtle.color.greenF());
-	ui->blue->setValue(data.data.turtle.color.blueF());
+	ui->red->setValue(color.redF());
+	ui->green->setValue(color.greenF());
+	ui->blue->setValue(color.blueF());
 
 	ui->currentX->setValue(data.data.turtle.position.x());
 	ui->currentY->setValue(data.data.turtle.position.y());
@@ -217,7 +320,7 @@ void MainWindow::on_actionLoad_triggered()
 		return;
 
 	world.setImage(QImage{file.fileName()});
-	ui->image->setImage(&world.floor().image());
+	ui->image->setImage(&floorImage.image());
 }
 
 void MainWindow::on_actionSave_as_triggered()
@@ -245,7 +348,9 @@ void MainWindow::on_actionSave_as_triggered()
 	if (file.fileName().isEmpty())
 		return;
 
-	if (!world.floor().image().save(file.fileName()))
+	if (!world.floor().fitsImage())
+		QMessageBox::critical(this,tr("Error saving file"),tr("The floor is too large to save as an image."));
+	else if (!world.floor().image().save(file.fileName()))
 		QMessageBox::critical(this,tr("Error opening file"),tr("The file could not be opened for writing."));
 }
 
@@ -256,7 +361,7 @@ void MainWindow::on_actionClear_log_triggered()
 
 void MainWindow::on_actionExit_triggered()
 {
-	brain->stop();
+	emit stop();
 	close();
 }
 
@@ -265,6 +370,7 @@ void MainWindow::on_actionResize_triggered()
 	bool ok;
 	int newSize = static_cast<int>(fieldSize);
 
+	//The floor is drawn as a single texture of its size, so only turtle-run goes beyond this
 	newSize =
 			QInputDialog::getInt(
 					this,
@@ -280,6 +386,23 @@ void MainWindow::on_actionResize_triggered()
 	resize();
 }
 
+void MainWindow::on_actionTurtles_triggered()
+{
+	bool ok;
+	const int count =
+			QInputDialog::getInt(
+					this,
+					"Turtles",
+					"Number of turtles, each with a brain of its own",
+					static_cast<int>(agents.size()),
+					1, 1000, 1, &ok);
+
+	if (!ok)
+		return;
+
+	setTurtleCount(static_cast<size_t>(count));
+}
+
 void MainWindow::on_actionReset_triggered()
 {
 	ui->penDown->setChecked(false);
@@ -296,24 +419,30 @@ void MainWindow::on_actionReset_triggered()
 
 void MainWindow::on_actionLinear_speed_triggered()
 {
-	actor->setLinearSpeed(
-				QInputDialog::getDouble(
-					this,
-					"Linear speed",
-					"The speed, in units per second",
-					actor->linearSpeed(),
-					0, 1e6, 3));
+	const double speed =
+			QInputDialog::getDouble(
+				this,
+				"Linear speed",
+				"The speed, in units per second",
+				actor->linearSpeed(),
+				0, 1e6, 3);
+
+	for (TurtleAgent * agent : agents)
+		agent->controller()->setLinearSpeed(speed);
 }
 
 void MainWindow::on_actionRotation_speed_triggered()
 {
-	actor->setRotationSpeed(
-				QInputDialog::getDouble(
-					this,
-					"Rotation speed",
-					"The speed, in circles per second",
-					actor->rotationSpeed(),
-					0, 100, 3));
+	const double speed =
+			QInputDialog::getDouble(
+				this,
+				"Rotation speed",
+				"The speed, in circles per second",
+				actor->rotationSpeed(),
+				0, 100, 3);
+
+	for (TurtleAgent * agent : agents)
+		agent->controller()->setRotationSpeed(speed);
 }
 
 bool MainWindow::logrobot()
@@ -325,3 +454,54 @@ void MainWindow::on_actionClear_field_triggered()
 {
 	world.reset();
 }
+
+void MainWindow::on_actionWrite_behind_toggled(bool enable)
+{
+	for (TurtleAgent * agent : agents)
+		agent->setWriteBehind(enable);
+}
+
+void MainWindow::on_actionInstant_toggled(bool enable)
+{
+	for (TurtleAgent * agent : agents)
+		agent->controller()->setInstant(enable);
+}
+
+void MainWindow::on_actionStatistics_triggered()
+{
+	if (!statistics)
+		statistics = new StatisticsDialog(this);
+
+	statistics->show();
+	statistics->raise();
+	statistics->activateWindow();
+}
+
+void MainWindow::on_actionTrace_toggled(bool enable)
+{
+	if (enable)
+	{
+		Turtle::Trace::start();
+		return;
+	}
+
+	Turtle::Trace::stop();
+
+	const QString fileName =
+			QFileDialog::getSaveFileName(
+				this,
+				tr("Save trace"),
+				QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation),
+				"Trace (*.json)");
+
+	if (fileName.isEmpty())
+		return;
+
+	if (!Turtle::Trace::save(fileName))
+		QMessageBox::critical(this,tr("Error opening file"),tr("The file could not be opened for writing."));
+}
+
+void MainWindow::on_actionHud_toggled(bool enable)
+{
+	hud.setVisible(enable);
+}
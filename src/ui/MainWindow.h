@@ -7,9 +7,17 @@
 #include <QColor>
 #include <QGraphicsScene>
 
+#include <set>
+#include <vector>
+
 #include "World.h"
+#include "WorldRenderer.h"
+#include "FloorImage.h"
+#include "HudRenderer.h"
+#include "DialogUserInput.h"
 #include "TurtleActorController.h"
-#include "ThreadedBrainController.h"
+#include "TurtleAgent.h"
+#include "StatisticsDialog.h"
 
 namespace Ui {
 	class MainWindow;
@@ -31,6 +39,15 @@ protected:
 	void setupViews(osg::ref_ptr<osg::Node> node);
 	void setupFollowView(osg::ref_ptr<osg::Node> node);
 
+	//Add a turtle agent, set up like the rest
+	void addAgent(TurtleActor & turtle);
+
+	//Add or remove turtles, keeping the main one
+	void setTurtleCount(size_t count);
+
+	//Ask once for the algorithm, and run it on all the brains
+	void start();
+
 signals:
 	void run();
 	void stop();
@@ -49,10 +66,16 @@ private slots:
 	void on_actionClear_log_triggered();
 	void on_actionExit_triggered();
 	void on_actionResize_triggered();
+	void on_actionTurtles_triggered();
 	void on_actionReset_triggered();
 	void on_actionLinear_speed_triggered();
 	void on_actionRotation_speed_triggered();
 	void on_actionClear_field_triggered();
+	void on_actionWrite_behind_toggled(bool enable);
+	void on_actionInstant_toggled(bool enable);
+	void on_actionStatistics_triggered();
+	void on_actionTrace_toggled(bool enable);
+	void on_actionHud_toggled(bool enable);
 
 private:
 	bool logrobot();
@@ -62,8 +85,24 @@ private:
 	QTimer * frameTimer;
 
 	Turtle::World world;
+	Turtle::WorldRenderer renderer;
+	Turtle::FloorImage floorImage;
+	Turtle::HudRenderer hud;
+	Turtle::DialogUserInput userInput;
+	//The main turtle's controller
 	QPointer<TurtleActorController> actor;
-	QPointer<ThreadedBrainController> brain;
+
+	//An agent for each turtle, the first is the main one
+	std::vector<TurtleAgent*> agents;
+
+	//The agents whose brain is running
+	std::set<const TurtleAgent*> runningAgents;
+
+	//Created on first use
+	QPointer<StatisticsDialog> statistics;
+
+	//The algorithm selected for the last run
+	int algorithm = 0;
 };
 
 #endif // MAINWINDOW_H
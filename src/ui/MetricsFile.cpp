@@ -0,0 +1,54 @@
+#include "MetricsFile.h"
+#include "RuntimeMetrics.h"
+
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cstdio>
+
+MetricsFile::MetricsFile(const QString & path, int interval, QObject *parent) :
+	QObject(parent),
+	path{path},
+	interval{std::max(1, interval)},
+	ticks{0},
+	failed{false}
+{
+	//The first sample only sets the start of the rates
+	Turtle::RuntimeMetrics::global().sample();
+
+	timer.setInterval(1000);
+	connect(&timer, &QTimer::timeout, this, &MetricsFile::tick);
+	timer.start();
+}
+
+MetricsFile::~MetricsFile()
+{
+	Turtle::RuntimeMetrics::global().sample();
+	write();
+}
+
+bool MetricsFile::write()
+{
+	const QByteArray text = Turtle::RuntimeMetrics::global().exposition().toUtf8();
+
+	QSaveFile file(path);
+	const bool ok =
+			file.open(QIODevice::WriteOnly) &&
+			(file.write(text) == text.size()) &&
+			file.commit();
+
+	//Complain once, not every few seconds for hours
+	if (!ok && !failed)
+		fprintf(stderr, "Could not write the metrics to %s\n", qPrintable(path));
+
+	failed = !ok;
+	return ok;
+}
+
+void MetricsFile::tick()
+{
+	Turtle::RuntimeMetrics::global().sample();
+
+	if (++ticks % interval == 0)
+		write();
+}
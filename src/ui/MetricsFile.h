@@ -0,0 +1,34 @@
+#ifndef METRICSFILE_H
+#define METRICSFILE_H
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+//Writes the runtime metrics of the process to a file, see Turtle::RuntimeMetrics
+//The metrics are sampled every second and written every few seconds, replacing
+// the file as a whole, so it can be read at any time, e.g. by the textfile
+// collector of the Prometheus node exporter.
+class MetricsFile : public QObject
+{
+	Q_OBJECT
+public:
+	//Write every interval seconds
+	explicit MetricsFile(const QString & path, int interval, QObject *parent = nullptr);
+
+	//Writes the final sample
+	~MetricsFile() override;
+
+	bool write();
+
+private:
+	void tick();
+
+	QString path;
+	int interval;
+	int ticks;
+	bool failed;
+	QTimer timer;
+};
+
+#endif // METRICSFILE_H
@@ -0,0 +1,36 @@
+#ifndef OSGTYPES_H
+#define OSGTYPES_H
+
+//Types used for the graphical representation
+
+#include "Types.h"
+
+#include <QColor>
+
+#include <osg/Vec2>
+#include <osg/Vec3>
+#include <osg/Vec4>
+
+namespace Turtle
+{
+	using OsgColor = osg::Vec4;
+
+	//Count number of elements in osg vectors
+	template <> struct CountVector<osg::Vec2> { static constexpr int Count() {return 2;}};
+	template <> struct CountVector<osg::Vec3> { static constexpr int Count() {return 3;}};
+	template <> struct CountVector<osg::Vec4> { static constexpr int Count() {return 4;}};
+
+	template <typename T = void>
+	OsgColor fromQColor(const QColor & color)
+	{
+		return OsgColor
+		{
+			static_cast<OsgColor::value_type>(color.redF()),
+			static_cast<OsgColor::value_type>(color.greenF()),
+			static_cast<OsgColor::value_type>(color.blueF()),
+			static_cast<OsgColor::value_type>(color.alphaF())
+		};
+	}
+}
+
+#endif // OSGTYPES_H
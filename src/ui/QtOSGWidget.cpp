@@ -3,6 +3,10 @@
 
 #include <osgGA/TrackballManipulator>
 
+#include "CommandStatistics.h"
+#include "FrameStatistics.h"
+#include "Trace.h"
+
 QtOSGWidget::QtOSGWidget(
 		osgViewer::Viewer * viewer,
 		osg::Camera * camera,
@@ -45,5 +49,10 @@ void QtOSGWidget::resizeGL(int w, int h)
 
 void QtOSGWidget::paintGL()
 {
+	TURTLE_TRACE("QtOSGWidget::paintGL");
+	const qint64 start = Turtle::CommandStatistics::now();
+
 	viewer->frame();
+
+	Turtle::FrameStatistics::global().painted(Turtle::CommandStatistics::now() - start);
 }
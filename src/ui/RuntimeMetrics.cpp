@@ -0,0 +1,122 @@
+#include "RuntimeMetrics.h"
+#include "FrameStatistics.h"
+
+#include <QTextStream>
+
+using namespace Turtle;
+
+RuntimeMetrics & RuntimeMetrics::global()
+{
+	static RuntimeMetrics metrics;
+	return metrics;
+}
+
+void RuntimeMetrics::sample()
+{
+	const qint64 now = CommandStatistics::now();
+	const double seconds = m_sampled ? static_cast<double>(now - m_sampled) * 1e-9 : 0;
+	m_sampled = now;
+
+	//There is no rate before the first sample
+	auto rate = [seconds](std::uint64_t delta) { return (seconds > 0) ? static_cast<double>(delta) / seconds : 0; };
+
+	for (size_t i = 0; i < counters; ++i)
+	{
+		const std::uint64_t total = m_counters[i].load(std::memory_order_relaxed);
+		m_rates[i] = rate(total - m_totals[i]);
+		m_totals[i] = total;
+	}
+
+	for (size_t i = 0; i < kinds; ++i)
+	{
+		const std::uint64_t total = m_commands[i].load(std::memory_order_relaxed);
+		m_commandRates[i] = rate(total - m_commandTotals[i]);
+		m_commandTotals[i] = total;
+	}
+
+	const FrameStatistics & frames = FrameStatistics::global();
+	const std::array<std::uint64_t, frameCounters> seen {frames.paints().count(), frames.dropped()};
+
+	for (size_t i = 0; i < frameCounters; ++i)
+	{
+		//After a reset all that was counted is new, and the totals keep growing
+		const std::uint64_t delta = (seen[i] >= m_frameSeen[i]) ? seen[i] - m_frameSeen[i] : seen[i];
+		m_frameSeen[i] = seen[i];
+		m_frameTotals[i] += delta;
+		m_frameRates[i] = rate(delta);
+	}
+
+	//Seconds blocked per second, shared by the brains running now
+	m_running = m_brains.load(std::memory_order_relaxed);
+	const double blocked = m_rates[static_cast<size_t>(Counter::BlockedTime)] * 1e-9;
+	m_blockedRatio = (m_running > 0) ? std::min(1.0, blocked / m_running) : 0;
+}
+
+QString RuntimeMetrics::exposition() const
+{
+	QString text;
+	QTextStream out(&text);
+
+	auto header = [&out](const char * name, const char * type, const char * help)
+	{
+		out
+				<< "# HELP " << name << " " << help << "\n"
+				<< "# TYPE " << name << " " << type << "\n";
+	};
+
+	auto metric = [&out, &header](const char * name, const char * type, const char * help, auto value)
+	{
+		header(name, type, help);
+		out << name << " " << value << "\n";
+	};
+
+	auto total = [this](Counter counter) { return m_totals[static_cast<size_t>(counter)]; };
+	auto rate = [this](Counter counter) { return m_rates[static_cast<size_t>(counter)]; };
+	auto frame = [this](Frame frame) { return static_cast<size_t>(frame); };
+
+	metric("turtle_world_steps_total", "counter", "World steps.", total(Counter::Steps));
+	metric("turtle_world_steps_per_second", "gauge", "World steps per second, over the last sample.", rate(Counter::Steps));
+
+	header("turtle_commands_total", "counter", "Brain commands replied to, by kind.");
+	for (size_t i = 0; i < kinds; ++i)
+		out << "turtle_commands_total{kind=\"" << CommandStatistics::name(static_cast<CommandStatistics::Kind>(i)) << "\"} " << m_commandTotals[i] << "\n";
+
+	header("turtle_commands_per_second", "gauge", "Brain commands replied to per second, by kind, over the last sample.");
+	for (size_t i = 0; i < kinds; ++i)
+		out << "turtle_commands_per_second{kind=\"" << CommandStatistics::name(static_cast<CommandStatistics::Kind>(i)) << "\"} " << m_commandRates[i] << "\n";
+
+	metric("turtle_brains_running", "gauge", "Brains running their program.", m_running);
+	metric(
+				"turtle_brain_blocked_seconds_total", "counter", "Time the brains spent waiting for the user interface.",
+				static_cast<double>(total(Counter::BlockedTime)) * 1e-9);
+	metric(
+				"turtle_brain_blocked_ratio", "gauge", "Part of the running brains' time spent waiting, over the last sample.",
+				m_blockedRatio);
+
+	metric("turtle_floor_tiles_written_total", "counter", "Floor tiles written.", total(Counter::Tiles));
+	metric(
+				"turtle_floor_tiles_written_per_second", "gauge", "Floor tiles written per second, over the last sample.",
+				rate(Counter::Tiles));
+
+	metric("turtle_texture_upload_bytes_total", "counter", "Floor texture bytes uploaded.", total(Counter::UploadBytes));
+	metric(
+				"turtle_texture_upload_bytes_per_second", "gauge", "Floor texture bytes uploaded per second, over the last sample.",
+				rate(Counter::UploadBytes));
+
+	metric("turtle_frames_rendered_total", "counter", "Frames rendered by the views.", m_frameTotals[frame(Frame::Rendered)]);
+	metric(
+				"turtle_frames_rendered_per_second", "gauge", "Frames rendered per second, over the last sample.",
+				m_frameRates[frame(Frame::Rendered)]);
+	metric("turtle_frames_skipped_total", "counter", "Frames skipped by a late frame timer.", m_frameTotals[frame(Frame::Skipped)]);
+	metric(
+				"turtle_frames_skipped_per_second", "gauge", "Frames skipped per second, over the last sample.",
+				m_frameRates[frame(Frame::Skipped)]);
+
+	metric("turtle_log_lines_total", "counter", "Lines logged by the brains.", total(Counter::LogLines));
+	metric(
+				"turtle_log_lines_per_second", "gauge", "Lines logged per second, over the last sample.",
+				rate(Counter::LogLines));
+
+	out.flush();
+	return text;
+}
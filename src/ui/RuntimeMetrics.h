@@ -0,0 +1,104 @@
+#ifndef RUNTIMEMETRICS_H
+#define RUNTIMEMETRICS_H
+
+#include <QString>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "CommandStatistics.h"
+
+namespace Turtle
+{
+	//Always-on counters of the whole process, to watch the throughput of long runs
+	//The simulation, the brains and the views count with relaxed atomic increments
+	// from any thread, while sample() aggregates the counters about once a second
+	// into totals and rates, which exposition() formats for Prometheus.
+	class RuntimeMetrics
+	{
+	public:
+		enum class Counter
+		{
+			Steps,
+			Tiles,
+			UploadBytes,
+			LogLines,
+
+			//In nanoseconds
+			BlockedTime,
+			Count
+		};
+
+		//The metrics of this process
+		static RuntimeMetrics & global();
+
+		void stepped() { add(Counter::Steps, 1); }
+		void tileWritten() { add(Counter::Tiles, 1); }
+		void uploaded(std::uint64_t bytes) { add(Counter::UploadBytes, bytes); }
+		void logged() { add(Counter::LogLines, 1); }
+
+		void command(CommandStatistics::Kind kind)
+		{ m_commands[static_cast<size_t>(kind)].fetch_add(1, std::memory_order_relaxed); }
+
+		//A brain waited this long for the user interface, in nanoseconds
+		void blocked(qint64 duration) { add(Counter::BlockedTime, static_cast<std::uint64_t>(std::max<qint64>(0, duration))); }
+
+		//A brain's program starts or ends
+		void brainStarted() { m_brains.fetch_add(1, std::memory_order_relaxed); }
+		void brainStopped() { m_brains.fetch_sub(1, std::memory_order_relaxed); }
+
+		//The counts so far, for readers taking rates of their own
+		std::uint64_t count(Counter counter) const { return m_counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed); }
+		int brains() const { return m_brains.load(std::memory_order_relaxed); }
+
+		//Aggregate all that was counted since the previous sample
+		//sample() and exposition() are called only by a single thread, e.g. by a MetricsFile.
+		void sample();
+
+		//The totals and the rates of the latest sample, in the Prometheus text exposition format
+		QString exposition() const;
+
+	private:
+		//The counters of FrameStatistics, which may be reset by others
+		enum class Frame
+		{
+			Rendered,
+			Skipped,
+			Count
+		};
+
+		static constexpr size_t counters = static_cast<size_t>(Counter::Count);
+		static constexpr size_t frameCounters = static_cast<size_t>(Frame::Count);
+		static constexpr size_t kinds = static_cast<size_t>(CommandStatistics::Kind::Count);
+
+		void add(Counter counter, std::uint64_t value)
+		{ m_counters[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed); }
+
+		std::array<std::atomic<std::uint64_t>, counters> m_counters {};
+		std::array<std::atomic<std::uint64_t>, kinds> m_commands {};
+		std::atomic<int> m_brains {0};
+
+		//Owned by the sampling thread
+
+		//The time of the latest sample, or 0 before the first one
+		qint64 m_sampled = 0;
+
+		std::array<std::uint64_t, counters> m_totals {};
+		std::array<std::uint64_t, kinds> m_commandTotals {};
+		std::array<std::uint64_t, frameCounters> m_frameTotals {};
+		std::array<std::uint64_t, frameCounters> m_frameSeen {};
+
+		//Per second, over the latest sample
+		std::array<double, counters> m_rates {};
+		std::array<double, kinds> m_commandRates {};
+		std::array<double, frameCounters> m_frameRates {};
+
+		//The part of the running brains' time spent waiting, over the latest sample
+		double m_blockedRatio = 0;
+		int m_running = 0;
+	};
+
+}
+#endif // RUNTIMEMETRICS_H
@@ -12,6 +12,7 @@ namespace Turtle
 		Scene();
 
 		void addChild(const osg::ref_ptr<osg::Node> node) { m_root->addChild(node);}
+		void removeChild(const osg::ref_ptr<osg::Node> node) { m_root->removeChild(node);}
 
 		//Access functors
 		osg::ref_ptr<osg::Group> root() {return m_root;}
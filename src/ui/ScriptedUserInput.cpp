@@ -0,0 +1,86 @@
+#include "ScriptedUserInput.h"
+
+#include <algorithm>
+
+using namespace Turtle;
+
+ScriptedUserInput::ScriptedUserInput(const QStringList & answers, bool acceptDefaults) :
+	m_answers{answers},
+	m_acceptDefaults{acceptDefaults}
+{
+}
+
+bool ScriptedUserInput::getInteger(
+		const QString & title,
+		const QString & label,
+		int & value,
+		int min, int max, int step)
+{
+	Q_UNUSED(title)
+	Q_UNUSED(label)
+	Q_UNUSED(step)
+
+	QString answer;
+	bool exhausted;
+	if (!next(answer, exhausted))
+		return exhausted && m_acceptDefaults;
+
+	bool ok;
+	const int result = answer.toInt(&ok);
+	if (!ok)
+		return false;
+
+	value = std::clamp(result, min, max);
+	return true;
+}
+
+bool ScriptedUserInput::getDouble(
+		const QString & title,
+		const QString & label,
+		double & value,
+		double min, double max, double step)
+{
+	Q_UNUSED(title)
+	Q_UNUSED(label)
+	Q_UNUSED(step)
+
+	QString answer;
+	bool exhausted;
+	if (!next(answer, exhausted))
+		return exhausted && m_acceptDefaults;
+
+	bool ok;
+	const double result = answer.toDouble(&ok);
+	if (!ok)
+		return false;
+
+	value = std::clamp(result, min, max);
+	return true;
+}
+
+bool ScriptedUserInput::getString(
+		const QString & title,
+		const QString & label,
+		QString & value)
+{
+	Q_UNUSED(title)
+	Q_UNUSED(label)
+
+	QString answer;
+	bool exhausted;
+	if (!next(answer, exhausted))
+		return exhausted && m_acceptDefaults;
+
+	value = answer;
+	return true;
+}
+
+bool ScriptedUserInput::next(QString & answer, bool & exhausted)
+{
+	exhausted = m_answers.isEmpty();
+	if (exhausted)
+		return false;
+
+	answer = m_answers.takeFirst();
+	return true;
+}
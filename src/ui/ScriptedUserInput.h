@@ -0,0 +1,45 @@
+#ifndef SCRIPTEDUSERINPUT_H
+#define SCRIPTEDUSERINPUT_H
+
+#include "UserInput.h"
+
+#include <QStringList>
+
+namespace Turtle
+{
+	//Answers input requests from a list prepared in advance, for running without a user
+	//The answers are used in order, each converted to the requested type.
+	//Once they run out, requests are either accepted with their default or refused.
+	class ScriptedUserInput : public UserInput
+	{
+	public:
+		explicit ScriptedUserInput(const QStringList & answers = {}, bool acceptDefaults = false);
+
+		bool getInteger(
+				const QString & title,
+				const QString & label,
+				int & value,
+				int min, int max, int step) override;
+
+		bool getDouble(
+				const QString & title,
+				const QString & label,
+				double & value,
+				double min, double max, double step) override;
+
+		bool getString(
+				const QString & title,
+				const QString & label,
+				QString & value) override;
+
+	private:
+		//Take the next answer
+		//Returns false when there is none, with exhausted set
+		bool next(QString & answer, bool & exhausted);
+
+		QStringList m_answers;
+		bool m_acceptDefaults;
+	};
+}
+
+#endif // SCRIPTEDUSERINPUT_H
@@ -0,0 +1,88 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "SpscRing.h"
+
+namespace Turtle
+{
+	//A single-writer, many-reader sequence lock over a trivially copyable value
+	//The writer never blocks, and readers retry while a write is in progress.
+	//The value is kept as relaxed atomic words, so readers racing the writer are well defined.
+	template <typename T>
+	class SeqLock
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "SeqLock values are copied as plain memory");
+
+	public:
+		SeqLock() { store(T{}); }
+
+		//Writer side
+		void store(const T & value);
+
+		//Reader side
+		T load() const;
+
+		//Even when stable, advances by 2 on every store
+		uint32_t version() const { return m_sequence.load(std::memory_order_acquire); }
+
+	private:
+		using Word = uint64_t;
+		static constexpr size_t wordCount = (sizeof(T) + sizeof(Word) - 1) / sizeof(Word);
+		using Words = std::array<Word, wordCount>;
+
+		std::atomic<uint32_t> m_sequence {0};
+		std::array<std::atomic<Word>, wordCount> m_words {};
+	};
+
+	template <typename T>
+	void SeqLock<T>::store(const T & value)
+	{
+		Words words {};
+		std::memcpy(words.data(), &value, sizeof(T));
+
+		//An odd sequence marks a write in progress
+		const uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+		m_sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		for (size_t i = 0; i < wordCount; ++i)
+			m_words[i].store(words[i], std::memory_order_relaxed);
+
+		m_sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	template <typename T>
+	T SeqLock<T>::load() const
+	{
+		Words words;
+
+		for (;;)
+		{
+			const uint32_t before = m_sequence.load(std::memory_order_acquire);
+			if (before & 1)
+			{
+				cpuRelax();
+				continue;
+			}
+
+			for (size_t i = 0; i < wordCount; ++i)
+				words[i] = m_words[i].load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (m_sequence.load(std::memory_order_relaxed) == before)
+				break;
+		}
+
+		T value;
+		std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+		return value;
+	}
+}
+
+#endif // SEQLOCK_H
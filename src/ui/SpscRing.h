@@ -0,0 +1,188 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace Turtle
+{
+	//Hint the CPU that we're inside a spin-wait loop
+	inline void cpuRelax()
+	{
+#	if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#	elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		_mm_pause();
+#	elif defined(__aarch64__)
+		asm volatile("yield");
+#	else
+		std::this_thread::yield();
+#	endif
+	}
+
+	//A bounded, preallocated, lock-free single-producer/single-consumer ring
+	//A single thread may push while another single thread pops
+	template <typename T, size_t Capacity>
+	class SpscRing
+	{
+		static_assert(Capacity && !(Capacity & (Capacity - 1)), "The capacity must be a power of two");
+
+	public:
+		static constexpr size_t capacity() { return Capacity; }
+
+		//Producer side
+		//Returns false when the ring is full
+		template <typename V> bool push(V && value);
+
+		//Consumer side
+		//Returns false when the ring is empty
+		bool pop(T & value);
+
+		//Consumer side
+		//Returns the next element without removing it, or nullptr when empty
+		T * front();
+
+		//Consumer side
+		//Removes the element returned by front()
+		void popFront();
+
+		//Approximate, since the other side might be running concurrently
+		bool empty() const
+		{ return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+
+		size_t size() const
+		{ return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+
+	private:
+		static constexpr size_t cacheLine = 64;
+		static constexpr size_t mask = Capacity - 1;
+
+		//Consumer owned: next slot to pop
+		alignas(cacheLine) std::atomic<size_t> m_head {0};
+		//Consumer's cached copy of the tail
+		size_t m_tailCache {0};
+
+		//Producer owned: next slot to push
+		alignas(cacheLine) std::atomic<size_t> m_tail {0};
+		//Producer's cached copy of the head
+		size_t m_headCache {0};
+
+		alignas(cacheLine) std::array<T, Capacity> m_slots {};
+	};
+
+	template <typename T, size_t Capacity>
+	template <typename V>
+	inline bool SpscRing<T,Capacity>::push(V && value)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+		if (tail - m_headCache >= Capacity)
+		{
+			//Refresh our view of the consumer
+			m_headCache = m_head.load(std::memory_order_acquire);
+			if (tail - m_headCache >= Capacity)
+				return false;
+		}
+
+		m_slots[tail & mask] = std::forward<V>(value);
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	template <typename T, size_t Capacity>
+	inline bool SpscRing<T,Capacity>::pop(T & value)
+	{
+		T * slot = front();
+		if (!slot)
+			return false;
+
+		value = std::move(*slot);
+		popFront();
+		return true;
+	}
+
+	template <typename T, size_t Capacity>
+	inline T * SpscRing<T,Capacity>::front()
+	{
+		const size_t head = m_head.load(std::memory_order_relaxed);
+
+		if (head == m_tailCache)
+		{
+			//Refresh our view of the producer
+			m_tailCache = m_tail.load(std::memory_order_acquire);
+			if (head == m_tailCache)
+				return nullptr;
+		}
+
+		return &m_slots[head & mask];
+	}
+
+	template <typename T, size_t Capacity>
+	inline void SpscRing<T,Capacity>::popFront()
+	{
+		m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+
+	//A wake-up counter a single thread can block on
+	//Waiting spins for a short while before falling back to a futex
+	// (or the platform equivalent) via std::atomic::wait
+	class Doorbell
+	{
+	public:
+		static constexpr int spinCount = 2000;
+
+		//Replaces blocking on the calling thread, e.g. by switching to another fiber
+		//Returns false to block as usual.
+		using WaitHook = bool (*)(const Doorbell & bell, uint32_t seen);
+
+		//The hook of the calling thread
+		static WaitHook & waitHook()
+		{
+			static thread_local WaitHook hook = nullptr;
+			return hook;
+		}
+
+		//The current value, to be passed to wait()
+		uint32_t value() const { return m_counter.load(std::memory_order_acquire); }
+
+		//Wake up any waiter
+		void ring()
+		{
+			m_counter.fetch_add(1, std::memory_order_acq_rel);
+			m_counter.notify_all();
+		}
+
+		//Block until the value changes from the one given
+		void wait(uint32_t seen) const
+		{
+			if (WaitHook hook = waitHook(); hook && hook(*this, seen))
+				return;
+
+			//Spinning is pointless when the other side can not run concurrently
+			static const int spins = (std::thread::hardware_concurrency() > 1) ? spinCount : 0;
+
+			for (int i = 0; i < spins; ++i)
+			{
+				if (m_counter.load(std::memory_order_acquire) != seen)
+					return;
+				cpuRelax();
+			}
+
+			m_counter.wait(seen, std::memory_order_acquire);
+		}
+
+	private:
+		std::atomic<uint32_t> m_counter {0};
+	};
+}
+
+#endif // SPSCRING_H
@@ -0,0 +1,57 @@
+#include "StatisticsDialog.h"
+
+#include <QDialogButtonBox>
+#include <QFontDatabase>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+#include "CommandStatistics.h"
+
+StatisticsDialog::StatisticsDialog(QWidget *parent) :
+	QDialog(parent),
+	text(new QPlainTextEdit(this)),
+	refreshTimer(new QTimer(this))
+{
+	setWindowTitle("Statistics");
+
+	text->setReadOnly(true);
+	text->setLineWrapMode(QPlainTextEdit::NoWrap);
+	text->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+	auto buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+	connect(buttons->addButton("Refresh", QDialogButtonBox::ActionRole), &QPushButton::clicked, this, &StatisticsDialog::refresh);
+	connect(buttons->addButton(QDialogButtonBox::Reset), &QPushButton::clicked, this, &StatisticsDialog::reset);
+	connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+	auto layout = new QVBoxLayout(this);
+	layout->addWidget(text);
+	layout->addWidget(buttons);
+
+	resize(1000, 320);
+
+	connect(refreshTimer, &QTimer::timeout, this, &StatisticsDialog::refresh);
+}
+
+void StatisticsDialog::refresh()
+{
+	text->setPlainText(Turtle::CommandStatistics::global().report());
+}
+
+void StatisticsDialog::reset()
+{
+	Turtle::CommandStatistics::global().reset();
+	refresh();
+}
+
+void StatisticsDialog::showEvent(QShowEvent * event)
+{
+	refresh();
+	refreshTimer->start(1000);
+	QDialog::showEvent(event);
+}
+
+void StatisticsDialog::hideEvent(QHideEvent * event)
+{
+	refreshTimer->stop();
+	QDialog::hideEvent(event);
+}
@@ -0,0 +1,30 @@
+#ifndef STATISTICSDIALOG_H
+#define STATISTICSDIALOG_H
+
+#include <QDialog>
+#include <QPlainTextEdit>
+#include <QTimer>
+
+//Shows the command statistics of all the brains, see Turtle::CommandStatistics
+//The table is refreshed periodically while the dialog is shown.
+class StatisticsDialog : public QDialog
+{
+	Q_OBJECT
+
+public:
+	explicit StatisticsDialog(QWidget *parent = nullptr);
+
+public slots:
+	void refresh();
+	void reset();
+
+protected:
+	void showEvent(QShowEvent * event) override;
+	void hideEvent(QHideEvent * event) override;
+
+private:
+	QPlainTextEdit * text;
+	QTimer * refreshTimer;
+};
+
+#endif // STATISTICSDIALOG_H
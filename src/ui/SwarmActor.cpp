@@ -0,0 +1,343 @@
+#include "SwarmActor.h"
+#include "World.h"
+#include "TurtleActor.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Turtle;
+
+SwarmActor::SwarmActor(World & world, QString name) :
+	Actor(name),
+	m_world{world}
+{
+}
+
+size_t SwarmActor::add(const Position2D & position, double angle)
+{
+	const size_t index = size();
+	const Position2D home = m_world.clamp(position, {radius, radius});
+	const TilePosition2D tile = m_world.floor().toTileIndex(home);
+
+	m_homeX.push_back(home.x());
+	m_homeY.push_back(home.y());
+	m_homeAngle.push_back(normalizeAngle(angle));
+
+	m_x.push_back(home.x());
+	m_y.push_back(home.y());
+	m_angle.push_back(m_homeAngle.back());
+
+	m_targetX.push_back(home.x());
+	m_targetY.push_back(home.y());
+	m_targetAngle.push_back(m_homeAngle.back());
+
+	m_tileX.push_back(tile.x());
+	m_tileY.push_back(tile.y());
+	m_lastPenX.push_back(tile.x());
+	m_lastPenY.push_back(tile.y());
+
+	m_penColor.push_back(Qt::black);
+	m_penDown.push_back(false);
+	m_penDirty.push_back(true);
+	m_active = true;
+
+	return index;
+}
+
+void SwarmActor::clear()
+{
+	for (auto * array : {&m_x, &m_y, &m_angle, &m_targetX, &m_targetY, &m_targetAngle, &m_homeX, &m_homeY, &m_homeAngle})
+		array->clear();
+
+	for (auto * array : {&m_tileX, &m_tileY, &m_lastPenX, &m_lastPenY})
+		array->clear();
+
+	for (auto * array : {&m_penDown, &m_penDirty})
+		array->clear();
+
+	m_penColor.clear();
+	m_floorChanges.clear();
+}
+
+void SwarmActor::reset()
+{
+	m_x = m_targetX = m_homeX;
+	m_y = m_targetY = m_homeY;
+	m_angle = m_targetAngle = m_homeAngle;
+
+	for (size_t i = 0; i < size(); ++i)
+	{
+		const TilePosition2D tile = m_world.floor().toTileIndex(position(i));
+		m_tileX[i] = m_lastPenX[i] = tile.x();
+		m_tileY[i] = m_lastPenY[i] = tile.y();
+	}
+
+	std::fill(m_penColor.begin(), m_penColor.end(), QColor(Qt::black));
+	std::fill(m_penDown.begin(), m_penDown.end(), false);
+	std::fill(m_penDirty.begin(), m_penDirty.end(), true);
+	m_active = !m_penDirty.empty();
+}
+
+bool SwarmActor::isPending(size_t index) const
+{
+	return
+			(m_x[index] != m_targetX[index]) ||
+			(m_y[index] != m_targetY[index]) ||
+			(m_angle[index] != m_targetAngle[index]);
+}
+
+void SwarmActor::setTarget(size_t index, const Position2D & position)
+{
+	const Position2D target = m_world.edge(this->position(index), position, {radius, radius});
+
+	m_targetX[index] = target.x();
+	m_targetY[index] = target.y();
+	m_active = true;
+}
+
+void SwarmActor::setTargetAngle(size_t index, double angle)
+{
+	m_targetAngle[index] = normalizeAngle(angle);
+	m_active = true;
+}
+
+void SwarmActor::setPen(size_t index, const QColor & color, bool down)
+{
+	m_penColor[index] = color;
+	m_penDown[index] = down;
+	m_penDirty[index] = true;
+	m_active = true;
+}
+
+bool SwarmActor::operator()(int steps)
+{
+	if (!m_active)
+		return false;
+
+	stepPosition(steps);
+	stepAngle(steps);
+	stepPen();
+
+	//A turtle still on its way is never exactly at its target
+	m_active = false;
+	for (size_t i = 0; (i < size()) && !m_active; ++i)
+		m_active = isPending(i);
+
+	return true;
+}
+
+void SwarmActor::command(size_t index, Command::Turtle & data)
+{
+	using Target = Command::Turtle::Target;
+
+	TiledFloor & floor = m_world.floor();
+	const Position2D current = position(index);
+	const double angle = m_angle[index];
+
+	//The same adjustments as TurtleActor::updateCommandPosition()
+	if (data.quantized)
+	{
+		if (!data.absolute)
+			data.tile = tile(index) + TurtleActor::tileToGlobal(data.tile, TurtleActor::toHeading(angle));
+
+		data.tile = floor.clamp(data.tile);
+		data.position = m_world.clamp(floor.toPosition(data.tile), {radius, radius});
+	}
+	else
+	{
+		if (!data.absolute)
+		{
+			static const double pi = acos(-1);
+			const double c = cos(2*pi*angle);
+			const double s = sin(2*pi*angle);
+
+			data.position = current + Position2D
+			{
+				data.position.x() * c + data.position.y() * s,
+				data.position.x() * s + data.position.y() * c
+			};
+
+			data.angle = angle + data.angle;
+		}
+
+		data.position = (data.target == Target::Target)
+				? m_world.edge(current, data.position, {radius, radius})
+				: m_world.clamp(data.position, {radius, radius});
+
+		data.tile = floor.clamp(floor.toTileIndex(data.position));
+		data.angle = normalizeAngle(data.angle);
+	}
+
+	if (data.target == Target::Tile)
+	{
+		setTile(data.tile, data.color);
+		return;
+	}
+
+	if (data.setPosition)
+	{
+		if (data.target == Target::Current)
+		{
+			m_x[index] = data.position.x();
+			m_y[index] = data.position.y();
+		}
+
+		m_targetX[index] = data.position.x();
+		m_targetY[index] = data.position.y();
+	}
+
+	if (data.setHeading)
+	{
+		if (data.target == Target::Current)
+			m_angle[index] = data.angle;
+
+		m_targetAngle[index] = data.angle;
+	}
+
+	if (data.setPenColor)
+	{
+		m_penColor[index] = data.color;
+		m_penDirty[index] = true;
+	}
+
+	if (data.setPenState)
+	{
+		m_penDown[index] = data.penDown;
+		m_penDirty[index] = true;
+	}
+
+	m_active = true;
+}
+
+void SwarmActor::commandGet(size_t index, Command::Turtle & data) const
+{
+	data.position = position(index);
+	data.tile = m_world.floor().toTileIndex(data.position);
+	data.angle = m_angle[index];
+	data.heading = TurtleActor::toHeading(m_angle[index]);
+	data.color = m_penColor[index];
+	data.penDown = m_penDown[index];
+}
+
+void SwarmActor::commit()
+{
+	m_world.floor().apply(m_floorChanges);
+	m_floorChanges.clear();
+
+	//Indexed, as the callbacks might add callbacks
+	for (size_t i = 0; i < m_callbacks.size(); ++i)
+		if (m_callbacks[i])
+			m_callbacks[i]();
+}
+
+double SwarmActor::normalizeAngle(double angle)
+{
+	//The same as TurtleActor::normalizeAngle()
+	//The fraction is exact, just as fmod(), but taken through an int conversion,
+	// which can be vectorized without the SSE4.1 rounding instructions.
+	//The bounds only keep the conversion defined, angles are never that far out.
+	const double limit = 1e9;
+	const double shifted = std::min(std::max(angle + 1.5, -limit), limit);
+	return (shifted - static_cast<double>(static_cast<int>(shifted))) - 0.5;
+}
+
+void SwarmActor::stepPosition(int steps)
+{
+	//The same as TurtleActor::stepPosition(), without branches so it can be vectorized
+	const double speed = m_linearSpeed;
+	const double stepCount = steps;
+	const double limit = speed * steps;
+	const size_t count = size();
+
+	double * x = m_x.data();
+	double * y = m_y.data();
+	const double * targetX = m_targetX.data();
+	const double * targetY = m_targetY.data();
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const float dx = static_cast<float>(targetX[i] - x[i]);
+		const float dy = static_cast<float>(targetY[i] - y[i]);
+		const float length = std::sqrt(dx * dx + dy * dy);
+		const float inverse = 1.0f / length;
+		const bool arrived = static_cast<double>(length) <= limit;
+
+		//Not used when arrived, where it might not be a number
+		const double movedX = x[i] + static_cast<double>(dx * inverse) * speed * stepCount;
+		const double movedY = y[i] + static_cast<double>(dy * inverse) * speed * stepCount;
+
+		x[i] = arrived ? targetX[i] : movedX;
+		y[i] = arrived ? targetY[i] : movedY;
+	}
+}
+
+void SwarmActor::stepAngle(int steps)
+{
+	//The same as TurtleActor::stepAngle(), without branches so it can be vectorized
+	const double speed = m_rotationSpeed;
+	const double stepCount = steps;
+	const double limit = speed * steps;
+	const size_t count = size();
+
+	double * angle = m_angle.data();
+	const double * targetAngle = m_targetAngle.data();
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		//Calculate the shortest path
+		const double distance = normalizeAngle(targetAngle[i] - angle[i]);
+		const double absolute = std::fabs(distance);
+		const double shortest =
+				(absolute >= 1.0) ? 0.0 :
+				(absolute > 0.5) ? -distance :
+				distance;
+
+		const bool arrived = std::fabs(shortest) <= limit;
+
+		//Not used when arrived, where it might not be a number
+		const double turned = normalizeAngle(angle[i] + shortest / std::fabs(shortest) * speed * stepCount);
+
+		angle[i] = arrived ? targetAngle[i] : turned;
+	}
+}
+
+void SwarmActor::stepPen()
+{
+	const double sizeX = m_world.floor().tileSize().x();
+	const double sizeY = m_world.floor().tileSize().y();
+	const size_t count = size();
+
+	const double * x = m_x.data();
+	const double * y = m_y.data();
+	TilePosition * tileX = m_tileX.data();
+	TilePosition * tileY = m_tileY.data();
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		tileX[i] = TiledFloor::toTile(x[i], sizeX);
+		tileY[i] = TiledFloor::toTile(y[i], sizeY);
+	}
+
+	//Drawing is rare enough to be left as is
+	for (size_t i = 0; i < count; ++i)
+	{
+		const bool moved = (tileX[i] != m_lastPenX[i]) || (tileY[i] != m_lastPenY[i]);
+
+		if (m_penDown[i] && (m_penDirty[i] || moved))
+		{
+			m_lastPenX[i] = tileX[i];
+			m_lastPenY[i] = tileY[i];
+			setTile({tileX[i], tileY[i]}, m_penColor[i]);
+		}
+
+		m_penDirty[i] = false;
+	}
+}
+
+void SwarmActor::setTile(const TilePosition2D & tile, const QColor & color)
+{
+	if (m_buffered)
+		m_floorChanges.push_back({m_world.floor().clamp(tile), color});
+	else
+		m_world.floor().setColor(tile, color);
+}
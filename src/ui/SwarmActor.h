@@ -0,0 +1,138 @@
+#ifndef SWARMACTOR_H
+#define SWARMACTOR_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <QColor>
+
+#include "Types.h"
+#include "Actor.h"
+#include "TiledFloor.h"
+#include "Command.h"
+
+namespace Turtle
+{
+	class World;
+
+	//Many simple turtles, stepped together as a single actor
+	//The state is kept as a structure of arrays, so the motion of all the turtles is
+	// stepped by tight loops over contiguous arrays, which the compiler vectorizes.
+	//The turtles move and draw by the same rules as TurtleActor, but have no brain,
+	// no tile sensor and no callbacks of their own.
+	class SwarmActor : public Actor
+	{
+	public:
+		static constexpr double radius = 0.5;
+
+		//Called once the changes of each step are applied
+		using Callback = std::function<void()>;
+		using Callbacks = std::vector<Callback>;
+
+		explicit SwarmActor(World & world, QString name = "Swarm");
+
+		bool operator()(int steps = 1) override;
+
+		bool isParallel() const override { return true; }
+		void setBuffered(bool buffered) override { m_buffered = buffered; }
+		void commit() override;
+
+		//Add a turtle at its home, returning its index
+		size_t add(const Position2D & position, double angle = 0);
+
+		//Remove all the turtles
+		void clear();
+
+		//Send all the turtles home
+		void reset();
+
+		size_t size() const { return m_x.size(); }
+
+
+		//Control functions
+		//-----------------
+
+		//Move toward a position, clamped to the world
+		void setTarget(size_t index, const Position2D & position);
+
+		//Turn toward an angle
+		void setTargetAngle(size_t index, double angle);
+
+		void setPen(size_t index, const QColor & color, bool down);
+
+		//Apply a Set operation to a turtle, the same way TurtleActor does
+		//The operation is updated to the global position it resolved to.
+		void command(size_t index, Command::Turtle & data);
+
+		//Fill in the current location and pen of a turtle, as for a TurtleActor Get
+		void commandGet(size_t index, Command::Turtle & data) const;
+
+		//Speed, in units/step, shared by all the turtles
+		double & linearSpeed(void) { return m_linearSpeed; }
+		double & rotationSpeed(void) { return m_rotationSpeed; }
+
+
+		//Access functors
+		//---------------
+		Position2D position(size_t index) const { return {m_x[index], m_y[index]}; }
+		Position2D target(size_t index) const { return {m_targetX[index], m_targetY[index]}; }
+		double angle(size_t index) const { return m_angle[index]; }
+		TilePosition2D tile(size_t index) const { return {m_tileX[index], m_tileY[index]}; }
+		bool isPending(size_t index) const;
+		Callbacks & callbacks(void) { return m_callbacks; }
+
+	protected:
+		static double normalizeAngle(double angle);
+
+		//The kernels, each running over all the turtles
+		//They only touch arrays of the same width, without branches, so they can be vectorized.
+		void stepPosition(int steps);
+		void stepAngle(int steps);
+		void stepPen();
+
+		//Set a floor tile, or keep the change aside while buffered
+		void setTile(const TilePosition2D & tile, const QColor & color);
+
+		World & m_world;
+
+		double m_linearSpeed = 1.0;
+		double m_rotationSpeed = 0.05;
+
+		//Current location
+		std::vector<double> m_x;
+		std::vector<double> m_y;
+		std::vector<double> m_angle;
+
+		//Target location
+		std::vector<double> m_targetX;
+		std::vector<double> m_targetY;
+		std::vector<double> m_targetAngle;
+
+		//Where to start from after a reset
+		std::vector<double> m_homeX;
+		std::vector<double> m_homeY;
+		std::vector<double> m_homeAngle;
+
+		//The current tile, and the last one the pen drawed at
+		std::vector<TilePosition2D::value_type> m_tileX;
+		std::vector<TilePosition2D::value_type> m_tileY;
+		std::vector<TilePosition2D::value_type> m_lastPenX;
+		std::vector<TilePosition2D::value_type> m_lastPenY;
+
+		std::vector<QColor> m_penColor;
+
+		std::vector<std::uint8_t> m_penDown;
+		std::vector<std::uint8_t> m_penDirty;
+
+		//Some turtle might not be where it's set to be
+		bool m_active = false;
+
+		//While buffered, floor changes wait for commit()
+		bool m_buffered = false;
+		TiledFloor::Changes m_floorChanges;
+
+		Callbacks m_callbacks;
+	};
+
+}
+#endif // SWARMACTOR_H
@@ -0,0 +1,78 @@
+#include "SwarmRenderer.h"
+#include "OsgTypes.h"
+
+#include <osg/Polytope>
+
+#include <cmath>
+
+using namespace Turtle;
+
+const double SwarmRenderer::pi = acos(-1);
+
+SwarmRenderer::SwarmRenderer(const SwarmActor & swarm) :
+	m_swarm{swarm},
+	m_robot{SwarmActor::radius},
+	m_root{new osg::Group}
+{
+	m_robot.setPenState(false);
+	update();
+}
+
+void SwarmRenderer::update()
+{
+	//Match the transforms to the turtles
+	while (m_shown.size() > m_swarm.size())
+	{
+		m_root->removeChild(m_shown.back().transform);
+		m_shown.pop_back();
+	}
+
+	while (m_shown.size() < m_swarm.size())
+	{
+		Shown shown{new osg::MatrixTransform, {}, 0, false};
+		shown.transform->addChild(m_robot.root());
+		shown.transform->setNodeMask(0);
+		m_root->addChild(shown.transform);
+		m_shown.push_back(shown);
+	}
+
+	//The world to clip space transform of the camera
+	osg::Polytope frustum;
+	const bool culled = m_camera.valid();
+	if (culled)
+	{
+		frustum.setToUnitFrustum();
+		frustum.transformProvidingInverse(m_camera->getViewMatrix() * m_camera->getProjectionMatrix());
+	}
+
+	for (size_t i = 0; i < m_shown.size(); ++i)
+	{
+		Shown & shown = m_shown[i];
+
+		const Position2D position = m_swarm.position(i);
+		const double angle = m_swarm.angle(i);
+
+		const osg::Vec3 center = static_cast<osg::Vec3>(position);
+		const bool visible = !culled || frustum.contains(osg::BoundingSphere(center, static_cast<float>(SwarmActor::radius)));
+
+		if (visible != shown.visible)
+		{
+			shown.visible = visible;
+			shown.transform->setNodeMask(visible ? ~0u : 0u);
+
+			//Force an update, as it was not followed while hidden
+			shown.angle = std::nan("");
+		}
+
+		if (!visible || ((shown.position == position) && (shown.angle == angle)))
+			continue;
+
+		shown.position = position;
+		shown.angle = angle;
+
+		shown.transform->setMatrix(
+					osg::Matrix::rotate(2*pi*angle,0,0,1) *
+					osg::Matrix::translate(center)
+					);
+	}
+}
@@ -0,0 +1,57 @@
+#ifndef SWARMRENDERER_H
+#define SWARMRENDERER_H
+
+#include "Types.h"
+#include "SwarmActor.h"
+#include "Robot.h"
+
+#include <osg/Camera>
+#include <osg/Group>
+#include <osg/MatrixTransform>
+#include <osg/observer_ptr>
+
+#include <vector>
+
+namespace Turtle
+{
+	//The graphical representation of a SwarmActor
+	//All the turtles share a single robot model. Only the turtles seen by the camera
+	// are updated, and only when they moved, so a large swarm costs little to show.
+	class SwarmRenderer
+	{
+	public:
+		explicit SwarmRenderer(const SwarmActor & swarm);
+
+		//Update to the swarm's current state
+		//Turtles added to or removed from the swarm are picked up here.
+		void update();
+
+		//Show only what this camera sees, or everything if none is set
+		void setCamera(osg::Camera * camera) { m_camera = camera; }
+
+		//Access functors
+		osg::ref_ptr<osg::Node> root() const { return m_root; }
+
+	private:
+		static const double pi;
+
+		const SwarmActor & m_swarm;
+
+		Robot m_robot;
+		osg::ref_ptr<osg::Group> m_root;
+		osg::observer_ptr<osg::Camera> m_camera;
+
+		//Per turtle, in swarm order
+		struct Shown
+		{
+			osg::ref_ptr<osg::MatrixTransform> transform;
+			Position2D position;
+			double angle;
+			bool visible;
+		};
+
+		std::vector<Shown> m_shown;
+	};
+
+}
+#endif // SWARMRENDERER_H
@@ -1,27 +1,20 @@
 #include "ThreadedBrain.h"
 
-#include <QInputDialog>
-
 #include "main.h"
+#include "CoroutineRunner.h"
+#include "FiberScheduler.h"
+#include "Trace.h"
+#include "RuntimeMetrics.h"
+
+#include <thread>
 
 using namespace Turtle;
 
 int ThreadedBrain::getInteger(QString title, QString label, int input, bool * ok)
 {
-	Command command {};
-	command.valid = true;
-	command.destination = Command::Destination::UI;
-	command.data.ui.command = Command::UI::Command::GetInt;
-	command.data.ui.title = title;
-	command.data.ui.text = label;
-	command.data.ui.integer = input;
-	command.data.ui.min = -2147483647;
-	command.data.ui.max = 2147483647;
-	command.data.ui.step = 1;
-
-	command = sendCommand(command);
+	const Command command = sendCommand(getIntegerCommand(title, label, input));
 	if (ok) *ok = command.valid;
-	return command.data.ui.integer;
+	return command.data.ui().integer;
 }
 
 double ThreadedBrain::getDouble(QString title, QString label, double input, bool * ok)
@@ -29,17 +22,17 @@ double ThreadedBrain::getDouble(QString title, QString label, double input, bool
 	Command command {};
 	command.valid = true;
 	command.destination = Command::Destination::UI;
-	command.data.ui.command = Command::UI::Command::GetDouble;
-	command.data.ui.title = title;
-	command.data.ui.text = label;
-	command.data.ui.real = input;
-	command.data.ui.min = -2147483647;
-	command.data.ui.max = 2147483647;
-	command.data.ui.step = 0.1;
+	command.data.ui().command = Command::UI::Command::GetDouble;
+	command.data.ui().title = title;
+	command.data.ui().text = label;
+	command.data.ui().real = input;
+	command.data.ui().min = -2147483647;
+	command.data.ui().max = 2147483647;
+	command.data.ui().step = 0.1;
 
 	command = sendCommand(command);
 	if (ok) *ok = command.valid;
-	return command.data.ui.real;
+	return command.data.ui().real;
 }
 
 QString ThreadedBrain::getString(QString title, QString label, QString input, bool * ok)
@@ -47,36 +40,36 @@ QString ThreadedBrain::getString(QString title, QString label, QString input, bo
 	Command command {};
 	command.valid = true;
 	command.destination = Command::Destination::UI;
-	command.data.ui.command = Command::UI::Command::GetString;
-	command.data.ui.title = title;
-	command.data.ui.text = label;
-	command.data.ui.string = input;
+	command.data.ui().command = Command::UI::Command::GetString;
+	command.data.ui().title = title;
+	command.data.ui().text = label;
+	command.data.ui().string = input;
 
 	command = sendCommand(command);
 	if (ok) *ok = command.valid;
-	return command.data.ui.string;
+	return command.data.ui().string;
 }
 
 void ThreadedBrain::log(QString text)
 {
-	Command command {};
-	command.valid = true;
-	command.destination = Command::Destination::UI;
-	command.data.ui.command = Command::UI::Command::Log;
-	command.data.ui.text = text;
+	sendCommand(logCommand(text));
+}
 
-	sendCommand(command);
+void ThreadedBrain::sleepFor(std::chrono::nanoseconds duration)
+{
+	const FiberScheduler::Clock::time_point due = FiberScheduler::Clock::now() + duration;
+
+	if (!FiberScheduler::sleepUntil(due))
+		std::this_thread::sleep_until(due);
 }
 
 Position2D ThreadedBrain::getCurrentPosition()
 {
-	Command command {};
-	command.valid = true;
-	command.destination = Command::Destination::Turtle;
-	command.data.turtle.command = Command::Turtle::Command::Get;
-	command.data.turtle.target = Command::Turtle::Target::Current;
+	TurtleActor::Snapshot state;
+	if (readSnapshot(state))
+		return state.current.position;
 
-	return sendCommand(command).data.turtle.position;
+	return sendCommand(currentStateCommand()).data.turtle.position;
 }
 
 void ThreadedBrain::setTargetPosition(Turtle::Position2D target, bool jump)
@@ -116,6 +109,469 @@ void ThreadedBrain::setTargetAngle(double target, bool jump)
 }
 
 void ThreadedBrain::setPenColor(QColor color)
+{
+	sendCommand(penColorCommand(color));
+}
+
+void ThreadedBrain::setPenDown(bool down)
+{
+	sendCommand(penDownCommand(down));
+}
+
+void ThreadedBrain::jump(Position2D distance, bool jump)
+{
+	sendCommand(jumpCommand(distance, jump));
+}
+
+void ThreadedBrain::move(double forward, double sideways)
+{
+	sendCommand(moveCommand(forward, sideways));
+}
+
+void ThreadedBrain::rotate(double angle)
+{
+	sendCommand(rotateCommand(angle));
+}
+
+void ThreadedBrain::setTile(const QColor color, const Turtle::TilePosition2D offset, bool absolute)
+{
+	sendCommand(setTileCommand(color, offset, absolute));
+}
+
+QColor ThreadedBrain::getTile(const Turtle::TilePosition2D offset, bool absolute)
+{
+	QColor color;
+	if (readMirroredTile(offset, absolute, color))
+		return color;
+
+	return sendCommand(getTileCommand(offset, absolute)).data.turtle.color;
+}
+
+Turtle::TileSensor ThreadedBrain::tileSensor()
+{
+	TurtleActor::Snapshot state;
+	if (readSnapshot(state))
+		return state.tileSensor();
+
+	return sendCommand(currentStateCommand()).data.tileSensor();
+}
+
+ThreadedBrain::SwarmGroup ThreadedBrain::swarmAdd(const std::vector<Position2D> & positions, double angle)
+{
+	Command command = swarmCommand(Command::Swarm::Command::Add, {});
+
+	for (const Position2D & position : positions)
+	{
+		Command::Turtle operation {};
+		operation.position = position;
+		operation.angle = angle;
+		command.data.swarm().operations.push_back(operation);
+	}
+
+	const Command reply = sendCommand(command);
+	return reply.valid ? reply.data.swarm().group : SwarmGroup{};
+}
+
+std::vector<Command::Turtle> ThreadedBrain::swarmGet(
+		const SwarmGroup & group,
+		std::vector<TileSensor> * sensors,
+		int sensorSize)
+{
+	Command command = swarmCommand(Command::Swarm::Command::Get, group);
+	command.data.swarm().sensorSize = sensors ? sensorSize : 0;
+
+	const Command reply = sendCommand(command);
+
+	if (!reply.valid)
+	{
+		if (sensors)
+			sensors->clear();
+
+		return {};
+	}
+
+	if (sensors)
+		*sensors = reply.data.swarm().sensors;
+
+	return reply.data.swarm().states;
+}
+
+void ThreadedBrain::swarmSet(const SwarmGroup & group, std::vector<Command::Turtle> operations)
+{
+	if (operations.empty())
+		return;
+
+	Command command = swarmCommand(Command::Swarm::Command::Set, group);
+	command.data.swarm().operations.swap(operations);
+
+	sendCommand(command);
+}
+
+void ThreadedBrain::swarmMove(const SwarmGroup & group, const std::vector<double> & distances)
+{
+	std::vector<Command::Turtle> operations;
+	for (const double distance : distances)
+		operations.push_back(moveCommand(distance, 0).data.turtle);
+
+	swarmSet(group, std::move(operations));
+}
+
+void ThreadedBrain::swarmRotate(const SwarmGroup & group, const std::vector<double> & angles)
+{
+	std::vector<Command::Turtle> operations;
+	for (const double angle : angles)
+		operations.push_back(rotateCommand(angle).data.turtle);
+
+	swarmSet(group, std::move(operations));
+}
+
+void ThreadedBrain::swarmSetPen(const SwarmGroup & group, QColor color, bool down)
+{
+	Command::Turtle operation = penColorCommand(color).data.turtle;
+	operation.setPenState = true;
+	operation.penDown = down;
+
+	swarmSet(group, {operation});
+}
+
+void ThreadedBrain::swarmClear()
+{
+	sendCommand(swarmCommand(Command::Swarm::Command::Clear, {}));
+}
+
+CommandFuture<void> ThreadedBrain::logAsync(QString text)
+{
+	return {this, postCommand(logCommand(text))};
+}
+
+CommandFuture<Position2D> ThreadedBrain::getCurrentPositionAsync()
+{
+	return
+	{
+		this,
+		postCommand(currentStateCommand()),
+		[](const Command & reply) { return reply.data.turtle.position; }
+	};
+}
+
+CommandFuture<void> ThreadedBrain::setPenColorAsync(QColor color)
+{
+	return {this, postCommand(penColorCommand(color))};
+}
+
+CommandFuture<void> ThreadedBrain::setPenDownAsync(bool down)
+{
+	return {this, postCommand(penDownCommand(down))};
+}
+
+CommandFuture<void> ThreadedBrain::jumpAsync(Position2D distance, bool jump)
+{
+	return {this, postCommand(jumpCommand(distance, jump))};
+}
+
+CommandFuture<void> ThreadedBrain::moveAsync(double forward, double sideways)
+{
+	return {this, postCommand(moveCommand(forward, sideways))};
+}
+
+CommandFuture<void> ThreadedBrain::rotateAsync(double angle)
+{
+	return {this, postCommand(rotateCommand(angle))};
+}
+
+CommandFuture<void> ThreadedBrain::setTileAsync(const QColor color, const TilePosition2D offset, bool absolute)
+{
+	return {this, postCommand(setTileCommand(color, offset, absolute))};
+}
+
+CommandFuture<QColor> ThreadedBrain::getTileAsync(const TilePosition2D offset, bool absolute)
+{
+	return
+	{
+		this,
+		postCommand(getTileCommand(offset, absolute)),
+		[](const Command & reply) -> QColor { return reply.data.turtle.color; }
+	};
+}
+
+CommandFuture<TileSensor> ThreadedBrain::tileSensorAsync()
+{
+	return
+	{
+		this,
+		postCommand(currentStateCommand()),
+		[](const Command & reply) { return reply.data.tileSensor(); }
+	};
+}
+
+CommandFuture<std::optional<int>> ThreadedBrain::getIntegerAsync(QString title, QString label, int input)
+{
+	return
+	{
+		this,
+		postCommand(getIntegerCommand(title, label, input)),
+		[](const Command & reply) -> std::optional<int>
+		{
+			if (!reply.valid)
+				return {};
+
+			return reply.data.ui().integer;
+		}
+	};
+}
+
+CommandFuture<void> ThreadedBrain::syncAsync()
+{
+	return {this, postCommand(currentStateCommand())};
+}
+
+bool ThreadedBrain::runTask(Task task)
+{
+	bool success = true;
+
+	CoroutineRunner runner;
+	runner.setCompletion([this, &success](const QString &, const QString & error)
+	{
+		if (error.isEmpty())
+			return;
+
+		success = false;
+		log("<font color = \"red\">Exception: " + error + "</font>");
+	});
+
+	runner.add(*this, std::move(task));
+	return runner.run([this]{ return static_cast<bool>(*this); }) && success;
+}
+
+quint32 ThreadedBrain::postCommand(const Command & command)
+{
+	return mailbox.post(command, [this]{ return static_cast<bool>(*this); });
+}
+
+Command ThreadedBrain::takeReply(quint32 sequence)
+{
+	Command reply {};
+	if (!sequence || !mailbox.wait(sequence, reply, [this]{ return static_cast<bool>(*this); }))
+	{
+		reply = {};
+		reply.reply = true;
+		reply.valid = false;
+		reply.sequence = sequence;
+	}
+
+	return reply;
+}
+
+ThreadedBrain::Transaction & ThreadedBrain::Transaction::setPenColor(QColor color)
+{
+	Command::Turtle & operation = add();
+	operation.target = Command::Turtle::Target::Current;
+	operation.setPenColor = true;
+
+	operation.color = color;
+
+	return *this;
+}
+
+ThreadedBrain::Transaction & ThreadedBrain::Transaction::setPenDown(bool down)
+{
+	Command::Turtle & operation = add();
+	operation.target = Command::Turtle::Target::Current;
+	operation.setPenState = true;
+
+	operation.penDown = down;
+
+	return *this;
+}
+
+ThreadedBrain::Transaction & ThreadedBrain::Transaction::jump(Position2D distance)
+{
+	Command::Turtle & operation = add();
+	operation.target = Command::Turtle::Target::Current;
+	operation.absolute = false;
+	operation.quantized = false;
+	operation.setPosition = true;
+
+	operation.position = distance;
+
+	return *this;
+}
+
+ThreadedBrain::Transaction & ThreadedBrain::Transaction::setPosition(Position2D position)
+{
+	Command::Turtle & operation = add();
+	operation.target = Command::Turtle::Target::Current;
+	operation.absolute = true;
+	operation.quantized = false;
+	operation.setPosition = true;
+
+	operation.position = position;
+
+	return *this;
+}
+
+ThreadedBrain::Transaction & ThreadedBrain::Transaction::rotate(double angle)
+{
+	Command::Turtle & operation = add();
+	operation.target = Command::Turtle::Target::Current;
+	operation.absolute = false;
+	operation.quantized = false;
+	operation.setHeading = true;
+
+	operation.angle = angle;
+
+	return *this;
+}
+
+ThreadedBrain::Transaction & ThreadedBrain::Transaction::setAngle(double angle)
+{
+	Command::Turtle & operation = add();
+	operation.target = Command::Turtle::Target::Current;
+	operation.absolute = true;
+	operation.quantized = false;
+	operation.setHeading = true;
+
+	operation.angle = angle;
+
+	return *this;
+}
+
+ThreadedBrain::Transaction & ThreadedBrain::Transaction::setTile(const QColor color, const TilePosition2D offset, bool absolute)
+{
+	Command::Turtle & operation = add();
+	operation.target = Command::Turtle::Target::Tile;
+	operation.absolute = absolute;
+	operation.quantized = true;
+	operation.tile = offset;
+	operation.color = color;
+
+	return *this;
+}
+
+void ThreadedBrain::Transaction::commit()
+{
+	if (operations.empty())
+		return;
+
+	Command command {};
+	command.valid = true;
+	command.destination = Command::Destination::Turtle;
+	command.data.turtle.command = Command::Turtle::Command::Transaction;
+	command.data.turtle.target = Command::Turtle::Target::Current;
+	command.data.transaction().swap(operations);
+
+	brain.sendCommand(command);
+}
+
+Command::Turtle & ThreadedBrain::Transaction::add()
+{
+	operations.push_back({});
+
+	Command::Turtle & operation = operations.back();
+	operation.command = Command::Turtle::Command::Set;
+
+	return operation;
+}
+
+void ThreadedBrain::start()
+{
+	setActive(true);
+	emit started();
+
+	//Invoke the run slot from the main event loop
+	QMetaObject::invokeMethod(this, &ThreadedBrain::run, Qt::QueuedConnection);
+}
+
+void ThreadedBrain::execute()
+{
+	emit started();
+
+	run();
+}
+
+void ThreadedBrain::stop()
+{
+	setActive(false);
+
+	//Release a pending wait
+	mailbox.interrupt();
+}
+
+Turtle::Command ThreadedBrain::sendCommand(const Turtle::Command & command)
+{
+	TURTLE_TRACE("ThreadedBrain::sendCommand");
+
+	auto isActive = [this]{ return static_cast<bool>(*this); };
+
+	Command reply {};
+	const bool behind = isWriteBehind() && !expectsReply(command);
+	const quint32 sequence = mailbox.post(command, isActive, !behind);
+
+	if (sequence && behind)
+	{
+		//Assume success, the command will be applied before any later query
+		reply = command;
+		reply.reply = true;
+		return reply;
+	}
+
+	bool replied = false;
+	if (sequence)
+	{
+		TURTLE_TRACE("ThreadedBrain::wait");
+		replied = mailbox.wait(sequence, reply, isActive);
+	}
+
+	if (!replied)
+	{
+		//No reply is available, so return the command itself, marked as invalid
+		reply = command;
+		reply.reply = true;
+		reply.valid = false;
+	}
+
+	return reply;
+}
+
+Command ThreadedBrain::logCommand(QString text)
+{
+	Command command {};
+	command.valid = true;
+	command.destination = Command::Destination::UI;
+	command.data.ui().command = Command::UI::Command::Log;
+	command.data.ui().text = text;
+
+	return command;
+}
+
+Command ThreadedBrain::getIntegerCommand(QString title, QString label, int input)
+{
+	Command command {};
+	command.valid = true;
+	command.destination = Command::Destination::UI;
+	command.data.ui().command = Command::UI::Command::GetInt;
+	command.data.ui().title = title;
+	command.data.ui().text = label;
+	command.data.ui().integer = input;
+	command.data.ui().min = -2147483647;
+	command.data.ui().max = 2147483647;
+	command.data.ui().step = 1;
+
+	return command;
+}
+
+Command ThreadedBrain::currentStateCommand()
+{
+	Command command {};
+	command.valid = true;
+	command.destination = Command::Destination::Turtle;
+	command.data.turtle.command = Command::Turtle::Command::Get;
+	command.data.turtle.target = Command::Turtle::Target::Current;
+
+	return command;
+}
+
+Command ThreadedBrain::penColorCommand(QColor color)
 {
 	Command command {};
 	command.valid = true;
@@ -126,10 +582,10 @@ void ThreadedBrain::setPenColor(QColor color)
 
 	command.data.turtle.color = color;
 
-	sendCommand(command);
+	return command;
 }
 
-void ThreadedBrain::setPenDown(bool down)
+Command ThreadedBrain::penDownCommand(bool down)
 {
 	Command command {};
 	command.valid = true;
@@ -140,10 +596,10 @@ void ThreadedBrain::setPenDown(bool down)
 
 	command.data.turtle.penDown = down;
 
-	sendCommand(command);
+	return command;
 }
 
-void ThreadedBrain::jump(Position2D distance, bool jump)
+Command ThreadedBrain::jumpCommand(Position2D distance, bool jump)
 {
 	Command command {};
 	command.valid = true;
@@ -158,10 +614,10 @@ void ThreadedBrain::jump(Position2D distance, bool jump)
 
 	command.data.turtle.position = distance;
 
-	sendCommand(command);
+	return command;
 }
 
-void ThreadedBrain::move(double forward, double sideways)
+Command ThreadedBrain::moveCommand(double forward, double sideways)
 {
 	Command command {};
 	command.valid = true;
@@ -174,10 +630,10 @@ void ThreadedBrain::move(double forward, double sideways)
 
 	command.data.turtle.position = {forward, sideways};
 
-	sendCommand(command);
+	return command;
 }
 
-void ThreadedBrain::rotate(double angle)
+Command ThreadedBrain::rotateCommand(double angle)
 {
 	Command command {};
 	command.valid = true;
@@ -190,10 +646,10 @@ void ThreadedBrain::rotate(double angle)
 
 	command.data.turtle.angle = angle;
 
-	sendCommand(command);
+	return command;
 }
 
-void ThreadedBrain::setTile(const QColor color, const Turtle::TilePosition2D offset, bool absolute)
+Command ThreadedBrain::setTileCommand(const QColor color, const TilePosition2D offset, bool absolute)
 {
 	Command command {};
 	command.valid = true;
@@ -205,10 +661,10 @@ void ThreadedBrain::setTile(const QColor color, const Turtle::TilePosition2D off
 	command.data.turtle.tile = offset;
 	command.data.turtle.color = color;
 
-	sendCommand(command);
+	return command;
 }
 
-QColor ThreadedBrain::getTile(const Turtle::TilePosition2D offset, bool absolute)
+Command ThreadedBrain::getTileCommand(const TilePosition2D offset, bool absolute)
 {
 	Command command {};
 	command.valid = true;
@@ -219,56 +675,92 @@ QColor ThreadedBrain::getTile(const Turtle::TilePosition2D offset, bool absolute
 	command.data.turtle.quantized = true;
 	command.data.turtle.tile = offset;
 
-	command = sendCommand(command);
-	return command.data.turtle.color;
+	return command;
 }
 
-Turtle::TileSensor ThreadedBrain::tileSensor()
+void ThreadedBrain::sync()
 {
-	Command command {};
-	command.valid = true;
-	command.destination = Command::Destination::Turtle;
-	command.data.turtle.command = Command::Turtle::Command::Get;
-	command.data.turtle.target = Command::Turtle::Target::Current;
-
-	command = sendCommand(command);
-	return command.data.turtle.tileSensor;
+	mailbox.flush([this]{ return static_cast<bool>(*this); });
 }
 
-void ThreadedBrain::start()
+bool ThreadedBrain::readSnapshot(TurtleActor::Snapshot & state)
 {
-	setActive(true);
-	emit started();
+	if (!snapshot || !isStateCached())
+		return false;
 
-	//Invoke the run slot from the main event loop
-	QMetaObject::invokeMethod(this, &ThreadedBrain::run, Qt::QueuedConnection);
+	//The snapshot is published before a reply is sent, so once every command
+	// was replied to it reflects all of them
+	if (!mailbox.idle())
+		return false;
+
+	state = snapshot->load();
+	return true;
 }
 
-void ThreadedBrain::stop()
+bool ThreadedBrain::readMirroredTile(const TilePosition2D offset, bool absolute, QColor & color)
 {
-	setActive(false);
-	QMetaObject::invokeMethod(this, &ThreadedBrain::stopWaitingForActive, Qt::QueuedConnection);
+	if (!floorMirror || !isFloorMirrored())
+		return false;
+
+	//As with the snapshot, the changes are streamed before a reply is sent
+	if (!mailbox.idle())
+		return false;
+
+	TilePosition2D tile = offset;
+	if (!absolute)
+	{
+		//Relative reads need the current location, in the same way TurtleActor uses it
+		if (!snapshot)
+			return false;
+
+		const TurtleActor::Location current = snapshot->load().current;
+		tile = current.tile + TurtleActor::tileToGlobal(offset, current.heading);
+	}
+
+	return floorMirror->getColor(tile, color);
 }
 
-Turtle::Command ThreadedBrain::sendCommand(const Turtle::Command & command)
+Command ThreadedBrain::swarmCommand(Command::Swarm::Command type, const SwarmGroup & group)
 {
-	emit signalSendCommand(command);
-	waitForActive();
-	return commandData;
+	Command command {};
+	command.valid = true;
+	command.destination = Command::Destination::Swarm;
+	command.data.swarm().command = type;
+	command.data.swarm().group = group;
+
+	return command;
 }
 
-void ThreadedBrain::commandReply(const Turtle::Command & data)
+bool ThreadedBrain::expectsReply(const Command & command)
 {
-	commandData = data;
-	QMetaObject::invokeMethod(this, [this]{idleEventLoop.quit();}, Qt::QueuedConnection);
+	switch (command.destination)
+	{
+		case Command::Destination::UI:
+			return command.data.ui().command != Command::UI::Command::Log;
+
+		case Command::Destination::Turtle:
+			return command.data.turtle.command == Command::Turtle::Command::Get;
+
+		case Command::Destination::Swarm:
+			return
+					(command.data.swarm().command != Command::Swarm::Command::Set) &&
+					(command.data.swarm().command != Command::Swarm::Command::Clear);
+	}
+
+	return true;
 }
 
 void ThreadedBrain::run()
 {
+	RuntimeMetrics::global().brainStarted();
+
 	//Main execution function
 	try
 	{
-		Main(*this);
+		if (program)
+			program(*this);
+		else
+			Main(*this);
 	}
 	catch(const std::exception & e)
 	{
@@ -279,18 +771,11 @@ void ThreadedBrain::run()
 		log("<font color = \"red\">Exception</font>");
 	}
 
+	//Let any queued commands complete before reporting the stop, even after an exception
+	sync();
+
+	RuntimeMetrics::global().brainStopped();
 
 	setActive(false);
 	emit stopped();
 }
-
-void ThreadedBrain::waitForActive()
-{
-	if (*this)
-		idleEventLoop.exec();
-}
-
-void ThreadedBrain::stopWaitingForActive()
-{
-	idleEventLoop.quit();
-}
@@ -3,14 +3,22 @@
 
 #include <QAtomicInt>
 #include <QObject>
-#include <QEventLoop>
 #include <QString>
 #include <QColor>
 
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <vector>
+
 #include "Types.h"
 #include "Command.h"
+#include "CommandMailbox.h"
+#include "CommandFuture.h"
+#include "BrainTask.h"
 #include "TileSensor.h"
 #include "TurtleActor.h"
+#include "FloorMirror.h"
 
 //This object always lives in a separate thread
 class ThreadedBrain : public QObject
@@ -18,11 +26,88 @@ class ThreadedBrain : public QObject
 	Q_OBJECT
 
 public:
-	explicit ThreadedBrain(QObject * parent = nullptr) : QObject(parent) {}
+	//Collects Set operations and sends them as a single command
+	//All the operations are applied, in order, in a single simulation step.
+	//Since there is no animation inside a step all the motions are jumps.
+	class Transaction
+	{
+	public:
+		explicit Transaction(ThreadedBrain & brain) : brain(brain) {}
+
+		Transaction & setPenColor(QColor color = Qt::black);
+		Transaction & setPenDown(bool down = true);
+
+		//Jump by a given distance on the current heading
+		Transaction & jump(Turtle::Position2D distance = {1,0});
+
+		//Jump to a given position
+		Transaction & setPosition(Turtle::Position2D position);
+
+		//Rotate by some angle
+		Transaction & rotate(double angle = 0.5);
+		Transaction & turnLeft() { return rotate(0.25); }
+		Transaction & turnRight() { return rotate(-0.25); }
+
+		//Set the angle
+		Transaction & setAngle(double angle);
+
+		Transaction & setDirectionalTile(const QColor color, const Turtle::TilePosition2D offset)
+		{ return setTile(color, offset, false); }
+
+		Transaction & setAbsoluteTile(const QColor color, const Turtle::TilePosition2D offset)
+		{ return setTile(color, offset, true); }
+
+		Transaction & setTile(const QColor color, const Turtle::TilePosition2D offset, bool absolute = false);
+
+		//Send all the collected operations and clear the list
+		//This function will block until the command is complete
+		void commit();
+
+		//Number of collected operations
+		size_t size() const { return operations.size(); }
+
+	private:
+		//Add a new, cleared, operation
+		Turtle::Command::Turtle & add();
+
+		ThreadedBrain & brain;
+		std::vector<Turtle::Command::Turtle> operations;
+	};
+
+	explicit ThreadedBrain(Turtle::CommandMailbox & mailbox, QObject * parent = nullptr) :
+		QObject(parent),
+		mailbox(mailbox) {}
 
 	explicit operator bool() const { return active.load() != 0; }
 	void setActive(bool value) { active.store(value ? 1 : 0);}
 
+	//In write-behind mode commands without a reply payload (Set commands and logs)
+	// return as soon as they are queued.
+	//Commands returning data wait until all earlier commands were applied.
+	bool isWriteBehind() const { return writeBehind.load() != 0; }
+	void setWriteBehind(bool value) { writeBehind.store(value ? 1 : 0);}
+
+	//Wait until all the commands sent so far are complete
+	void sync();
+
+	//Set the actor state read by the state cache, or nullptr to disable it
+	//Must not be changed while running.
+	void setSnapshot(const Turtle::SeqLock<Turtle::TurtleActor::Snapshot> * value) { snapshot = value; }
+
+	//Set the floor mirror used for tile reads, or nullptr to disable it
+	//Must not be changed while running.
+	void setFloorMirror(Turtle::FloorMirror * value) { floorMirror = value; }
+
+	//When enabled, tile reads are served from the floor mirror
+	// instead of a round trip, as long as no command is still in flight.
+	bool isFloorMirrored() const { return floorMirrored.load() != 0; }
+	void setFloorMirrored(bool value) { floorMirrored.store(value ? 1 : 0);}
+
+	//When enabled, reads of the current state are served from the actor's published snapshot
+	// instead of a round trip, as long as no command is still in flight.
+	bool isStateCached() const { return stateCached.load() != 0; }
+	void setStateCached(bool value) { stateCached.store(value ? 1 : 0);}
+
 	int getInteger(QString title = {}, QString label = {}, int input = 0, bool * ok = nullptr);
 	double getDouble(QString title = {}, QString label = {}, double input = 0, bool * ok = nullptr);
 	QString getString(QString title = {}, QString label = {}, QString input = {}, bool * ok = nullptr);
@@ -30,6 +115,10 @@ public:
 	//Send a log string to the UI
 	void log(QString text);
 
+	//Wait for the given time without holding up the other brains
+	//A brain on a fiber is parked, leaving its worker to the others.
+	void sleepFor(std::chrono::nanoseconds duration);
+
 	//Return the current position
 	Turtle::Position2D getCurrentPosition();
 
@@ -80,13 +169,103 @@ public:
 	//Get the tile sensor
 	Turtle::TileSensor tileSensor();
 
+	//Start a new transaction
+	Transaction transaction() { return Transaction{*this}; }
+
+
+	//Swarm interface
+	//---------------
+	//Each call is a single command addressing many turtles of the world's swarm, see SwarmActor.
+	//A group lists swarm indices, and an empty group addresses the whole swarm.
+
+	using SwarmGroup = std::vector<quint32>;
+
+	//Add a turtle at each position, returning their group
+	SwarmGroup swarmAdd(const std::vector<Turtle::Position2D> & positions, double angle = 0);
+
+	//Return the current state of each turtle in the group
+	//When given, the sensors are filled with the tiles around each turtle, in the absolute frame.
+	std::vector<Turtle::Command::Turtle> swarmGet(
+			const SwarmGroup & group = {},
+			std::vector<Turtle::TileSensor> * sensors = nullptr,
+			int sensorSize = 3);
+
+	//Apply Set operations to the group, either one for each turtle or a single one for all of them
+	//This function will block until all the turtles completed their motion
+	void swarmSet(const SwarmGroup & group, std::vector<Turtle::Command::Turtle> operations);
+
+	//Move each turtle forward on its own heading, by its own distance
+	void swarmMove(const SwarmGroup & group, const std::vector<double> & distances);
+
+	//Rotate each turtle by its own angle
+	void swarmRotate(const SwarmGroup & group, const std::vector<double> & angles);
+
+	//Set the pen of all the turtles in the group
+	void swarmSetPen(const SwarmGroup & group, QColor color = Qt::black, bool down = true);
+
+	//Remove all the turtles of the swarm, including those added by other brains
+	void swarmClear();
+
+
+	//Asynchronous interface
+	//----------------------
+	//These functions send the command and return without waiting for its reply.
+	//The result is retrieved by get(), which blocks, or by co_await from a Turtle::Task
+	// running on a Turtle::CoroutineRunner, which lets other tasks run meanwhile.
+
+	Turtle::CommandFuture<void> logAsync(QString text);
+	Turtle::CommandFuture<Turtle::Position2D> getCurrentPositionAsync();
+	Turtle::CommandFuture<void> setPenColorAsync(QColor color = Qt::black);
+	Turtle::CommandFuture<void> setPenDownAsync(bool down = true);
+	Turtle::CommandFuture<void> jumpAsync(Turtle::Position2D distance = {1,0}, bool jump = true);
+	Turtle::CommandFuture<void> moveAsync(double forward = 1.0, double sideways = 0);
+	Turtle::CommandFuture<void> rotateAsync(double angle = 0.5);
+	Turtle::CommandFuture<void> setTileAsync(const QColor color, const Turtle::TilePosition2D offset, bool absolute = false);
+	Turtle::CommandFuture<QColor> getTileAsync(const Turtle::TilePosition2D offset, bool absolute = false);
+	Turtle::CommandFuture<Turtle::TileSensor> tileSensorAsync();
+
+	//Results in nothing when the input is not accepted
+	Turtle::CommandFuture<std::optional<int>> getIntegerAsync(QString title = {}, QString label = {}, int input = 0);
+
+	//Complete once all the commands sent so far are, like sync()
+	//The replies come in order, so the reply to a command posted last implies all the others.
+	Turtle::CommandFuture<void> syncAsync();
+
+	//Run a single task on the calling thread until it completes or the brain is stopped
+	//The thread runs no other brain meanwhile, see CoroutineBrainController for sharing it.
+	//Returns false if the task did not complete successfully
+	bool runTask(Turtle::Task task);
+
+	//Post a command without waiting, returns its sequence number or 0 on failure
+	quint32 postCommand(const Turtle::Command & command);
+
+	//Return true if the reply for a posted command can be taken without blocking
+	bool isReplied(quint32 sequence) { return mailbox.poll(sequence); }
+
+	//Wait for the reply for a posted command
+	//Returns an invalid command if the brain was stopped first
+	Turtle::Command takeReply(quint32 sequence);
+
+	//Discard the reply for a posted command
+	void forgetReply(quint32 sequence) { mailbox.forget(sequence); }
+
+	//Additionally ring the given bell on every reply, see CommandMailbox::shareReplyBell()
+	void shareReplyBell(Turtle::Doorbell * bell) { mailbox.shareReplyBell(bell); }
+
+	//The program run by the brain, Main() by default
+	//Must not be changed while running.
+	using Program = std::function<void(ThreadedBrain&)>;
+	void setProgram(Program value) { program = value; }
+
+	//Run the program on the calling thread, returning when it completes
+	//Used by backends that do not give each brain a thread of its own.
+	//The brain should be activated first, so stop() can be called before this runs.
+	void execute();
+
 signals:
 	void started();
 	void stopped();
 
-	//The signal mathing to sendCommand
-	void signalSendCommand(Turtle::Command command);
-
 public slots:
 	void start();
 	void stop();
@@ -95,22 +274,52 @@ public slots:
 	//This function will block until the command is complete
 	Turtle::Command sendCommand(const Turtle::Command & command);
 
-	//Should be called when the current command is done and it's data is ready
-	void commandReply(const Turtle::Command & data);
-
 private slots:
 	void run();
 
 private:
-	void waitForActive();
-	void stopWaitingForActive();
+	//Return true for commands that should always wait for their reply
+	static bool expectsReply(const Turtle::Command & command);
+
+	//Read the published state if it's up to date with all the commands sent
+	bool readSnapshot(Turtle::TurtleActor::Snapshot & state);
+
+	//Read a tile from the floor mirror if it's up to date with all the commands sent
+	bool readMirroredTile(const Turtle::TilePosition2D offset, bool absolute, QColor & color);
 
-	Turtle::Command commandData;
+	//Command builders shared by the blocking and the asynchronous interfaces
+	static Turtle::Command logCommand(QString text);
+	static Turtle::Command getIntegerCommand(QString title, QString label, int input);
+	static Turtle::Command currentStateCommand();
+	static Turtle::Command penColorCommand(QColor color);
+	static Turtle::Command penDownCommand(bool down);
+	static Turtle::Command jumpCommand(Turtle::Position2D distance, bool jump);
+	static Turtle::Command moveCommand(double forward, double sideways);
+	static Turtle::Command rotateCommand(double angle);
+	static Turtle::Command setTileCommand(const QColor color, const Turtle::TilePosition2D offset, bool absolute);
+	static Turtle::Command getTileCommand(const Turtle::TilePosition2D offset, bool absolute);
+	static Turtle::Command swarmCommand(Turtle::Command::Swarm::Command type, const SwarmGroup & group);
 
-	QEventLoop idleEventLoop;
+	//The channel to the controller
+	Turtle::CommandMailbox & mailbox;
+
+	Program program;
 
 	//Set to 0 when the execution should stop
 	QAtomicInt active;
+
+	//Set to 1 in write-behind mode
+	QAtomicInt writeBehind;
+
+	//Set to 1 when the state cache is enabled
+	QAtomicInt stateCached {1};
+
+	const Turtle::SeqLock<Turtle::TurtleActor::Snapshot> * snapshot = nullptr;
+
+	//Set to 1 when tile reads use the floor mirror
+	QAtomicInt floorMirrored {1};
+
+	Turtle::FloorMirror * floorMirror = nullptr;
 };
 
 #endif // THREADEDBRAIN_H
@@ -4,8 +4,10 @@ ThreadedBrainController::ThreadedBrainController(
 		TurtleActorController * controller,
 		QObject *parent) :
 	QObject{parent},
-	brain{new ThreadedBrain{}}
+	controller{controller},
+	brain{new ThreadedBrain{mailbox}}
 {
+	brainThread.setObjectName("Brain");
 	brain->moveToThread(&brainThread);
 	connect(&brainThread, &QThread::finished, brain, &QObject::deleteLater);
 
@@ -14,8 +16,10 @@ ThreadedBrainController::ThreadedBrainController(
 	connect(brain, &ThreadedBrain::started, this, &ThreadedBrainController::started);
 	connect(brain, &ThreadedBrain::stopped, this, &ThreadedBrainController::stopped);
 
-	connect(brain, &ThreadedBrain::signalSendCommand, controller, &TurtleActorController::command);
-	connect(controller, &TurtleActorController::commandReply, brain, &ThreadedBrain::commandReply);
+	brain->setSnapshot(&controller->snapshot());
+	brain->setFloorMirror(&floorMirror);
+	controller->addFloorMirror(&floorMirror);
+	controller->attach(&mailbox);
 
 	brainThread.start();
 }
@@ -25,6 +29,12 @@ ThreadedBrainController::~ThreadedBrainController()
 	stop();
 	brainThread.quit();
 	brainThread.wait();
+
+	if (controller)
+	{
+		controller->attach(nullptr);
+		controller->removeFloorMirror(&floorMirror);
+	}
 }
 
 void ThreadedBrainController::start()
@@ -36,3 +46,9 @@ void ThreadedBrainController::stop()
 {
 	QMetaObject::invokeMethod(brain, &ThreadedBrain::stop, Qt::DirectConnection);
 }
+
+void ThreadedBrainController::setWriteBehind(bool enable)
+{
+	//The mode is atomic, so it can be set from any thread
+	brain->setWriteBehind(enable);
+}
@@ -10,6 +10,7 @@
 
 #include "TurtleActorController.h"
 #include "ThreadedBrain.h"
+#include "CommandMailbox.h"
 
 //Interface between the ThreadedBrain and the rest of the system
 //This class allows to implement blocking calls from within the brain
@@ -24,6 +25,10 @@ public:
 
 	~ThreadedBrainController();
 
+	//Set the program to run, see ThreadedBrain::setProgram()
+	//Must not be called while the brain runs.
+	void setProgram(ThreadedBrain::Program program) { brain->setProgram(program); }
+
 signals:
 	void started();
 	void stopped();
@@ -32,8 +37,14 @@ public slots:
 	void start();
 	void stop();
 
+	//Enable the brain's write-behind mode
+	void setWriteBehind(bool enable);
+
 private:
 	QThread brainThread;
+	Turtle::CommandMailbox mailbox;
+	Turtle::FloorMirror floorMirror;
+	QPointer<TurtleActorController> controller;
 	QPointer<ThreadedBrain> brain;
 };
 
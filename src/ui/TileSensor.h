@@ -32,6 +32,11 @@ namespace Turtle
 		//The size of a dimension
 		int size() const {return length;}
 
+		bool operator==(const TileSensor & rhs) const
+		{ return (length == rhs.length) && (data == rhs.data); }
+		bool operator!=(const TileSensor & rhs) const
+		{ return !(*this == rhs); }
+
 	private:
 		Data::size_type index(int front, int side) const;
 
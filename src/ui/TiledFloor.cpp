@@ -1,6 +1,9 @@
 #include "TiledFloor.h"
+#include "RuntimeMetrics.h"
 
-#include <osg/Geometry>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 using namespace Turtle;
 
@@ -9,92 +12,153 @@ TiledFloor::TiledFloor(
 		const QColor & clearColor,
 		const Position2D & tileSize)
 {
-	m_texture = new osg::Texture2D;
-
-	//Create default members to avoid dereferencing null pointers
-	m_textureImage = new osg::Image;
-	m_floor = new osg::Geode;
-	m_root = new osg::Group;
-
 	setClearColor(clearColor);
 	reset(size, tileSize);
 }
 
 void TiledFloor::setImage(const QImage & image)
 {
-	m_image = image.convertToFormat(QImage::Format_ARGB32, Qt::ColorOnly);
+	const QImage converted = image.convertToFormat(format, Qt::ColorOnly);
+	const int width = std::min(converted.width(), 2 * m_halfIndexSize.x() + 1);
+	const int height = std::min(converted.height(), 2 * m_halfIndexSize.y() + 1);
+
+	m_chunks.clear();
+
+	for (int row = 0; row < height; ++row)
+	{
+		const uchar * line = converted.constScanLine(row);
 
-	//Copy image data to texture
-	for (int s = 0; s < m_image.width(); ++s)
-		for (int t = 0; t < m_image.height(); ++t)
+		//Along the rows of the chunks, skipping those left clear
+		for (int column = 0; column < width;)
 		{
-			QColor color = m_image.pixelColor(s,t);
-			m_textureImage->setColor(
-						fromQColor(color),
-						static_cast<unsigned>(s),
-						static_cast<unsigned>(m_textureImage->t() - 1 - t));
+			//Note that the Y axis is inverted
+			const TilePosition2D tile {column - m_halfIndexSize.x(), m_halfIndexSize.y() - row};
+			const int length = std::min(width - column, chunkSize - static_cast<int>(chunkOffset(tile) / 4) % chunkSize);
+			const size_t bytes = static_cast<size_t>(length) * 4;
+
+			const uchar * source = line + 4 * column;
+			const uchar * current = pixel(tile);
+
+			if (std::memcmp(source, current, bytes))
+				std::memcpy(chunk(tile).data() + chunkOffset(tile), source, bytes);
+
+			column += length;
 		}
+	}
+
+	floorChanged();
 }
 
-void TiledFloor::reset(const Index2D & size, const Position2D & tileSize)
+QImage TiledFloor::image() const
 {
-	m_tileSize = tileSize;
-	m_halfIndexSize = size;
-	m_halfPositionSize = tileSize * size + tileSize / 2;
-	m_Base = -size;
+	if (!fitsImage())
+		return {};
 
-	const TilePosition2D dimentions = size * 2 + 1;
+	QImage image(2 * m_halfIndexSize.x() + 1, 2 * m_halfIndexSize.y() + 1, format);
 
-	//Create the image
-	m_image = QImage(dimentions.x(), dimentions.y(), QImage::Format_ARGB32);
+	//The rows of the format need no padding
+	read(image.rect(), image.bits());
 
-	//Create the texture image
-	m_textureImage->allocateImage(dimentions.x(),dimentions.y(),1, GL_RGB, GL_UNSIGNED_BYTE);
-	m_texture->setImage(m_textureImage);
+	return image;
+}
 
-	clear();
+bool TiledFloor::fitsImage() const
+{
+	//QImage keeps its size in bytes in an int
+	const qint64 width = 2 * static_cast<qint64>(m_halfIndexSize.x()) + 1;
+	const qint64 height = 2 * static_cast<qint64>(m_halfIndexSize.y()) + 1;
+	return (width * height * 4) <= std::numeric_limits<int>::max();
+}
 
-	//Remove the old floor
-	m_root->removeChild(m_floor);
+void TiledFloor::read(const QRect & rect, uchar * target) const
+{
+	for (int row = rect.top(); row <= rect.bottom(); ++row)
+		for (int column = rect.left(); column <= rect.right();)
+		{
+			//Note that the Y axis is inverted
+			const TilePosition2D tile {column - m_halfIndexSize.x(), m_halfIndexSize.y() - row};
+			const int length = std::min(rect.right() + 1 - column, chunkSize - static_cast<int>(chunkOffset(tile) / 4) % chunkSize);
+			const size_t bytes = static_cast<size_t>(length) * 4;
 
-	createQuad();
+			std::memcpy(target, pixel(tile), bytes);
 
-	//Add the new floor
-	m_root->addChild(m_floor);
+			target += bytes;
+			column += length;
+		}
+}
+
+TiledFloor::Chunks TiledFloor::chunks() const
+{
+	Chunks snapshot;
+	snapshot.reserve(m_chunks.size());
+
+	for (const auto & stored : m_chunks)
+	{
+		stored.second.shared = true;
+		snapshot.emplace(stored.first, stored.second.chunk);
+	}
+
+	return snapshot;
+}
+
+void TiledFloor::setChunks(const Chunks & chunks)
+{
+	m_chunks.clear();
+	m_chunks.reserve(chunks.size());
+
+	//Marked shared, so they are copied before being written, as after chunks()
+	for (const auto & chunk : chunks)
+		m_chunks.emplace(chunk.first, Stored{std::const_pointer_cast<Chunk>(chunk.second), true});
+
+	floorChanged();
+}
+
+void TiledFloor::reset(const Index2D & size, const Position2D & tileSize)
+{
+	m_tileSize = tileSize;
+	m_halfIndexSize = size;
+	m_halfPositionSize = tileSize * size + tileSize / 2;
+
+	clear();
 }
 
 void TiledFloor::clear()
 {
-	m_image.fill(m_clearColor);
+	const QRgb color = m_clearColor.rgba64().toArgb32();
 
-	OsgColor color = fromQColor(m_clearColor);
+	std::shared_ptr<Chunk> clearChunk = std::make_shared<Chunk>();
+	for (size_t offset = 0; offset < clearChunk->size(); offset += 4)
+		fromRgb(clearChunk->data() + offset, color);
 
-	for (int s = 0; s < m_textureImage->s(); ++s)
-		for (int t = 0; t < m_textureImage->t(); ++t)
-			m_textureImage->setColor(color, static_cast<unsigned int>(s), static_cast<unsigned int>(t));
+	m_clearChunk = std::move(clearChunk);
+	m_chunks.clear();
 
-	m_textureImage->dirty();
+	floorChanged();
 }
 
-TilePosition2D TiledFloor::clamp(const TilePosition2D & position, const TilePosition2D & margin)
+TilePosition2D TiledFloor::clamp(const TilePosition2D & position, const TilePosition2D & margin) const
 {
+	if (m_unbounded)
+		return position.min(TilePosition2D{maxTile, maxTile}).max(TilePosition2D{-maxTile, -maxTile});
+
 	return position.max(-m_halfIndexSize + margin).min(m_halfIndexSize - margin);
 }
 
 TileSensor TiledFloor::getTiles(const TilePosition2D position, size_t size) const
+{
+	return getTiles(position, size, {});
+}
+
+TileSensor TiledFloor::getTiles(const TilePosition2D position, size_t size, const Changes & changes) const
 {
 	//Adjust the position to be inside our bounds
 	const TilePosition2D::value_type margin = static_cast<TilePosition2D::value_type>(size);
-	TilePosition2D target = position.min(m_halfIndexSize - margin).max(-m_halfIndexSize + margin);
+	const TilePosition2D target =
+			m_unbounded ? position : position.min(m_halfIndexSize - margin).max(-m_halfIndexSize + margin);
 
 	auto pixel = [this, target] (int x, int y)
 	{
-		const Index2D index = toIndex(target + TilePosition2D{x,y});
-
-		//Note that the Y axis is inverted
-		return m_image.pixelColor(
-					static_cast<int>(index.x()),
-					m_image.height() -1 - (static_cast<int>(index.y())));
+		return QColor::fromRgba(toRgb(this->pixel(toIndex(target + TilePosition2D{x,y}))));
 	};
 
 	TileSensor::Data data;
@@ -103,22 +167,20 @@ TileSensor TiledFloor::getTiles(const TilePosition2D position, size_t size) cons
 		for (int x = -margin; x <= margin; ++x)
 			data.push_back(pixel(x,y));
 
+	//Later changes override earlier ones
+	const int side = 2 * margin + 1;
+	for (const Change & change : changes)
+	{
+		const TilePosition2D offset = change.tile - target + margin;
+		if ((offset >= 0) && (offset < side))
+			data[static_cast<size_t>(offset.y() * side + offset.x())] = stored(change.color);
+	}
+
 	return TileSensor(data, margin);
 }
 
 TilePosition2D TiledFloor::toTileIndex(const Position2D & position) const
 {
-	using T = Position2D::value_type;
-	auto toTile = [](T coord, T size) -> TilePosition2D::value_type
-	{
-		if (fabs(coord) < size/2)
-			return 0;
-
-		T shifted = std::floor(fabs(coord) + size / 2);
-		T unwrapped = shifted * (coord / fabs(coord));
-		return static_cast<TilePosition2D::value_type>(unwrapped);
-	};
-
 	return TilePosition2D
 	{
 		toTile(position.x(), m_tileSize.x()),
@@ -128,85 +190,86 @@ TilePosition2D TiledFloor::toTileIndex(const Position2D & position) const
 
 Position2D TiledFloor::toPosition(const TilePosition2D & index) const
 {
-	return m_tileSize * index.min(m_halfIndexSize).max(-m_halfIndexSize);
+	return m_tileSize * toIndex(index);
 }
 
 
-Index2D TiledFloor::toIndex(const Position2D & position) const
+TilePosition2D TiledFloor::toIndex(const Position2D & position) const
 {
 	return toIndex(toTileIndex(position));
 }
 
-Index2D TiledFloor::toIndex(const TilePosition2D & position) const
+TilePosition2D TiledFloor::toIndex(const TilePosition2D & position) const
 {
-	//Make sure the position is not out of bounds
-	TilePosition2D bounded = position.min(m_halfIndexSize).max(-m_halfIndexSize);
+	if (m_unbounded)
+		return position.min(TilePosition2D{maxTile, maxTile}).max(TilePosition2D{-maxTile, -maxTile});
 
-	return bounded - m_Base;
+	//Make sure the position is not out of bounds
+	return position.min(m_halfIndexSize).max(-m_halfIndexSize);
 }
 
-void TiledFloor::setColor(const Index2D & position, const QColor & color)
+void TiledFloor::write(const TilePosition2D & tile, const QColor & color)
 {
-	//Note that the Y axis is inverted
-	m_image.setPixelColor(
-				static_cast<int>(position.x()),
-				m_image.height() -1 - static_cast<int>(position.y()),
-				color);
+	const QRgb stored = color.rgba64().toArgb32();
 
-	m_textureImage->setColor(
-				fromQColor(color),
-				static_cast<unsigned int>(position.x()),
-				static_cast<unsigned>(position.y()));
+	fromRgb(chunk(tile).data() + chunkOffset(tile), stored);
+	RuntimeMetrics::global().tileWritten();
 
-	m_textureImage->dirty();
+	for (FloorObserver * observer : m_observers)
+		observer->tileChanged(*this, tile, stored);
 }
 
-QColor TiledFloor::getColor(const Index2D & position) const
+void TiledFloor::apply(const Changes & changes)
 {
-	return m_image.pixelColor(
-				static_cast<int>(position.x()),
-				m_image.height() -1 - static_cast<int>(position.y()));
+	for (const Change & change : changes)
+		setColor(change.tile, change.color);
 }
 
-void TiledFloor::createQuad()
+QColor TiledFloor::stored(const QColor & color)
 {
-	auto toVec3 = [](Position2D pos) -> osg::Vec3
-	{
-		return osg::Vec3
-		{
-			static_cast<osg::Vec3::value_type>(pos.x()),
-			static_cast<osg::Vec3::value_type>(pos.y()),
-			0
-		};
-	};
+	//The same conversion setColor() does
+	return QColor(QRgba64::fromArgb32(color.rgba64().toArgb32()));
+}
 
-	Position2D a;
-	a = a * Position2D{1,-1};
+QColor TiledFloor::read(const TilePosition2D & tile) const
+{
+	return QColor::fromRgba(toRgb(pixel(tile)));
+}
 
-	osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
-	vertices->push_back( toVec3(m_halfPositionSize * Position2D{-1,-1}) );
-	vertices->push_back( toVec3(m_halfPositionSize * Position2D{1,-1}) );
-	vertices->push_back( toVec3(m_halfPositionSize * Position2D{1,1}) );
-	vertices->push_back( toVec3(m_halfPositionSize * Position2D{-1,1}) );
+TiledFloor::Chunk & TiledFloor::chunk(const TilePosition2D & tile)
+{
+	Stored & stored = m_chunks[chunkKey(tile)];
 
-	osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array;
-	normals->push_back( osg::Vec3(0.0f,0.0f, 1.0f) );
+	//Written for the first time
+	if (!stored.chunk)
+		stored.chunk = std::make_shared<Chunk>(*m_clearChunk);
 
-	osg::ref_ptr<osg::Vec2Array> texcoords = new osg::Vec2Array;
-	texcoords->push_back( osg::Vec2(0.0f, 0.0f) );
-	texcoords->push_back( osg::Vec2(1.0f, 0.0f) );
-	texcoords->push_back( osg::Vec2(1.0f, 1.0f) );
-	texcoords->push_back( osg::Vec2(0.0f, 1.0f) );
+	//Leave the snapshots as they are
+	else if (stored.shared)
+	{
+		stored.chunk = std::make_shared<Chunk>(*stored.chunk);
+		stored.shared = false;
+	}
 
-	osg::ref_ptr<osg::Geometry> quad = new osg::Geometry;
-	quad->setVertexArray( vertices );
-	quad->setNormalArray( normals );
-	quad->setNormalBinding( osg::Geometry::BIND_OVERALL );
-	quad->setTexCoordArray( 0, texcoords );
+	return *stored.chunk;
+}
+
+void TiledFloor::addObserver(FloorObserver * observer)
+{
+	if (std::find(m_observers.cbegin(), m_observers.cend(), observer) != m_observers.cend())
+		return;
+
+	m_observers.push_back(observer);
+	observer->floorChanged(*this);
+}
 
-	quad->addPrimitiveSet( new osg::DrawArrays(osg::DrawArrays::QUADS, 0, 4) );
+void TiledFloor::removeObserver(FloorObserver * observer)
+{
+	m_observers.erase(std::remove(m_observers.begin(), m_observers.end(), observer), m_observers.end());
+}
 
-	m_floor = new osg::Geode;
-	m_floor->addDrawable( quad );
-	m_floor->getOrCreateStateSet()->setTextureAttributeAndModes(0, m_texture );
+void TiledFloor::floorChanged()
+{
+	for (FloorObserver * observer : m_observers)
+		observer->floorChanged(*this);
 }
@@ -3,34 +3,119 @@
 
 #include "Types.h"
 #include "TileSensor.h"
+#include "FloorObserver.h"
 
 #include <QImage>
 
-#include <osg/Node>
-#include <osg/Group>
-#include <osg/Geode>
-#include <osg/Texture2D>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace Turtle
 {
 	//Represents and handles a floor divided to tiles
-	//This includes both the simulation and graphical data
+	//The graphical representation is an observer, see FloorRenderer
+	//The tiles are kept in square chunks, allocated when a tile of theirs is first
+	// written, so the memory follows the tiles actually drawn on rather than the size
+	// of the floor. All the chunks not written yet share a single clear one.
+	//The floor has a size, which is the window shown and saved as an image, and
+	// bounds the tiles unless the floor is unbounded.
 	class TiledFloor
 	{
 	public:
+		//Chunks are square, with this many tiles on each side
+		static constexpr int chunkSize = 64;
+
+		//The farthest tile from the origin along each axis, even when unbounded
+		//Half the range of TilePosition, so offsets from any tile still fit it.
+		static constexpr TilePosition maxTile = std::numeric_limits<TilePosition>::max() / 2;
+
+		//The tiles of a chunk, as RGBA8888 pixels, rows going up along the Y axis
+		using Chunk = std::array<uchar, chunkSize * chunkSize * 4>;
+
+		//The written chunks, by their coordinates, see chunkKey()
+		using Chunks = std::unordered_map<quint64, std::shared_ptr<const Chunk>>;
+
+		//Of the image, with the bytes of each pixel in R, G, B, A order
+		static constexpr QImage::Format format = QImage::Format_RGBA8888;
+
+		//Read and write a pixel of a chunk or of the image
+		static QRgb toRgb(const uchar * pixel) { return qRgba(pixel[0], pixel[1], pixel[2], pixel[3]); }
+		static void fromRgb(uchar * pixel, QRgb color)
+		{
+			pixel[0] = static_cast<uchar>(qRed(color));
+			pixel[1] = static_cast<uchar>(qGreen(color));
+			pixel[2] = static_cast<uchar>(qBlue(color));
+			pixel[3] = static_cast<uchar>(qAlpha(color));
+		}
+
+		//The chunk holding a tile, and where in it
+		static quint64 chunkKey(const TilePosition2D & tile)
+		{
+			return
+					(static_cast<quint64>(static_cast<quint32>(chunkCoordinate(tile.x()))) << 32) |
+					static_cast<quint32>(chunkCoordinate(tile.y()));
+		}
+
+		static size_t chunkOffset(const TilePosition2D & tile)
+		{
+			const int x = tile.x() - chunkCoordinate(tile.x()) * chunkSize;
+			const int y = tile.y() - chunkCoordinate(tile.y()) * chunkSize;
+			return static_cast<size_t>(y * chunkSize + x) * 4;
+		}
+
+		//A tile change kept aside, to be applied later
+		struct Change
+		{
+			//Already clamped to the floor
+			TilePosition2D tile;
+			QColor color;
+		};
+
+		using Changes = std::vector<Change>;
 
 		TiledFloor(const Index2D & size = {},
 				const QColor & clearColor = Qt::white,
 				const Position2D & tileSize = {1,1});
 
 		Position2D halfSize() const { return m_halfPositionSize; }
+		Position2D tileSize() const { return m_tileSize; }
+		TilePosition2D halfIndexSize() const { return m_halfIndexSize; }
 
-		//Set a new image
+		//Tiles beyond the size of an unbounded floor are kept as well, and not clamped
+		void setUnbounded(bool unbounded) { m_unbounded = unbounded; }
+		bool isUnbounded() const { return m_unbounded; }
+
+		//Set a new image, as the tiles within the size
 		void setImage(const QImage & image);
 
-		//Access functors
-		const QImage & image() const {return m_image;}
-		osg::ref_ptr<osg::Node> root() {return m_root;}
+		//The tiles within the size, as an image with the Y axis inverted
+		//Made on each call, so better kept by the callers that need it often, see FloorImage.
+		//Null if the size is more than a QImage can hold, see fitsImage().
+		QImage image() const;
+
+		//Whether image() can hold the tiles within the size
+		bool fitsImage() const;
+
+		//Copy the pixels of a part of image() to a buffer, each row right after the other
+		void read(const QRect & rect, uchar * target) const;
+
+		//A snapshot of the written chunks, which stays as it is while the floor changes on
+		//The chunks are shared until the floor writes to them, and copied then.
+		Chunks chunks() const;
+
+		//Of the chunks not written yet
+		std::shared_ptr<const Chunk> clearChunk() const { return m_clearChunk; }
+
+		//Replace the written chunks by a snapshot, see chunks()
+		void setChunks(const Chunks & chunks);
+
+		//The number of chunks written since the floor was cleared
+		size_t chunkCount() const { return m_chunks.size(); }
 
 		//Set the clear color to use
 		void setClearColor(const QColor & color) {m_clearColor = color;}
@@ -41,27 +126,72 @@ namespace Turtle
 		//Clear the floor to its initial state
 		void clear();
 
-		//Clamp the index to the bounding box
-		TilePosition2D clamp(const TilePosition2D & position, const TilePosition2D & margin = {});
+		//Clamp the index to the bounding box, if bounded
+		TilePosition2D clamp(const TilePosition2D & position, const TilePosition2D & margin = {}) const;
 
 		//Set a pixel color at a given position
-		void setColor(const Position2D & position, const QColor & color) {setColor(toIndex(position),color);}
-		void setColor(const TilePosition2D & position, const QColor & color) {setColor(toIndex(position),color);}
+		void setColor(const Position2D & position, const QColor & color) {write(toIndex(position),color);}
+		void setColor(const TilePosition2D & position, const QColor & color) {write(toIndex(position),color);}
 
 		//Get a pixel color at a given position
-		QColor getColor(const Position2D & position) const {return getColor(toIndex(position));}
-		QColor getColor(const TilePosition2D & position) const {return getColor(toIndex(position));}
+		QColor getColor(const Position2D & position) const {return read(toIndex(position));}
+		QColor getColor(const TilePosition2D & position) const {return read(toIndex(position));}
 
 		TileSensor getTiles(const TilePosition2D position, size_t size) const;
 
+		//Like getTiles(), as if the changes were already applied
+		TileSensor getTiles(const TilePosition2D position, size_t size, const Changes & changes) const;
+
+		//Apply the changes, in order
+		void apply(const Changes & changes);
+
+		//A color as it reads back after being set, in the floor's precision
+		static QColor stored(const QColor & color);
+
 		TilePosition2D toTileIndex(const Position2D & position) const;
+
+		//The tile of a coordinate along an axis with tiles of the given size, see toTileIndex()
+		//Inline and free of library rounding calls, so loops over many positions can be vectorized.
+		//Clamped to maxTile, which also keeps the conversion of infinite and NaN coordinates defined.
+		static TilePosition toTile(double coord, double size)
+		{
+			const double half = size / 2;
+			const double magnitude = std::min(static_cast<double>(maxTile), std::fabs(coord));
+
+			//Truncating rounds down, as the value is positive
+			const TilePosition tile = static_cast<TilePosition>(magnitude + half);
+			return (magnitude < half) ? 0 : (coord < 0) ? -tile : tile;
+		}
+
 		Position2D toPosition(const TilePosition2D & index) const;
+
+		//Report all the changes to an observer, which is given the whole floor right away
+		void addObserver(FloorObserver * observer);
+		void removeObserver(FloorObserver * observer);
+
 	private:
-		Index2D toIndex(const Position2D & position) const;
-		Index2D toIndex(const TilePosition2D & position) const;
-		void setColor(const Index2D & position, const QColor & color);
-		QColor getColor(const Index2D & position) const;
-		void createQuad();
+		//Round down, for negative tiles as well
+		static int chunkCoordinate(int tile) { return (tile >= 0) ? tile / chunkSize : -((chunkSize - 1 - tile) / chunkSize); }
+
+		//The tile of a position, clamped to the floor if bounded
+		TilePosition2D toIndex(const Position2D & position) const;
+		TilePosition2D toIndex(const TilePosition2D & position) const;
+
+		void write(const TilePosition2D & tile, const QColor & color);
+		QColor read(const TilePosition2D & tile) const;
+
+		//The pixel of a tile, see toRgb()
+		const uchar * pixel(const TilePosition2D & tile) const
+		{
+			const auto stored = m_chunks.find(chunkKey(tile));
+			return ((stored != m_chunks.cend()) ? stored->second.chunk->data() : m_clearChunk->data()) + chunkOffset(tile);
+		}
+
+		//The chunk of a tile, ready to be written
+		Chunk & chunk(const TilePosition2D & tile);
+
+		//Report the whole floor to the observers
+		void floorChanged();
 
 
 		//The size of each tile
@@ -73,22 +203,24 @@ namespace Turtle
 		//The one sided (distance from origin to edge) size of the floor
 		Position2D m_halfPositionSize;
 
+		bool m_unbounded = false;
+
 		//The color to use for clear operations
 		QColor m_clearColor;
 
-		//The pixels
-		QImage m_image;
-		osg::ref_ptr<osg::Image> m_textureImage;
-		osg::ref_ptr<osg::Texture2D> m_texture;
+		struct Stored
+		{
+			std::shared_ptr<Chunk> chunk;
 
-		//The textured floor geometry
-		osg::ref_ptr<osg::Geode> m_floor;
+			//By a snapshot, so copied before the next write
+			mutable bool shared = false;
+		};
 
-		//The floor root
-		osg::ref_ptr<osg::Group> m_root;
+		//The tiles
+		std::unordered_map<quint64, Stored> m_chunks;
+		std::shared_ptr<const Chunk> m_clearChunk;
 
-		//Base for converting from center-origin to corner-origin
-		TilePosition2D m_Base;
+		std::vector<FloorObserver*> m_observers;
 	};
 
 }
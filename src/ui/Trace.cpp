@@ -0,0 +1,277 @@
+#include "Trace.h"
+
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QThread>
+#include <QCoreApplication>
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Turtle;
+
+std::atomic<bool> Trace::s_running {false};
+std::atomic<int> Trace::s_recording {0};
+
+namespace
+{
+	struct Event
+	{
+		const char * name;
+
+		//The thread the span started on
+		quint32 thread;
+
+		std::int64_t start;
+		std::int64_t end;
+	};
+
+	//Events are appended by the owning thread and read by save(), once it waited out record()
+	//A block is never moved once published.
+	struct Block
+	{
+		static constexpr size_t capacity = 4096;
+
+		std::array<Event, capacity> events;
+		std::atomic<size_t> count {0};
+		std::atomic<Block*> next {nullptr};
+	};
+
+	struct ThreadBuffer
+	{
+		//Blocks beyond this are not allocated, and their events are dropped
+		static constexpr size_t maxBlocks = 256;
+
+		~ThreadBuffer()
+		{
+			for (Block * block = first; block; )
+			{
+				Block * next = block->next.load();
+				delete block;
+				block = next;
+			}
+		}
+
+		quint32 id = 0;
+		QString name;
+
+		//Allocated on the first span
+		Block * first = nullptr;
+		Block * last = nullptr;
+		size_t blocks = 0;
+
+		//The generation of the trace the buffer is filled for, see Trace::start()
+		quint32 generation = 0;
+	};
+
+	struct Registry
+	{
+		QMutex lock;
+
+		//Kept after their threads are gone, so their spans are still saved
+		std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+		std::atomic<quint32> generation {0};
+		std::int64_t start = 0;
+	};
+
+	Registry & registry()
+	{
+		static Registry instance;
+		return instance;
+	}
+
+	//Allocated on the first span of the thread
+	thread_local ThreadBuffer * currentBuffer = nullptr;
+
+	//Set by Trace::nameThread()
+	thread_local QString currentName;
+
+	ThreadBuffer & threadBuffer()
+	{
+		if (currentBuffer)
+			return *currentBuffer;
+
+		Registry & registry = ::registry();
+		QMutexLocker locker(&registry.lock);
+
+		registry.buffers.push_back(std::make_unique<ThreadBuffer>());
+		ThreadBuffer * buffer = registry.buffers.back().get();
+		buffer->id = static_cast<quint32>(registry.buffers.size());
+		buffer->name = currentName;
+		if (buffer->name.isEmpty())
+			buffer->name = QThread::currentThread()->objectName();
+		if (buffer->name.isEmpty() && QCoreApplication::instance() && (QThread::currentThread() == QCoreApplication::instance()->thread()))
+			buffer->name = "Main";
+		else if (buffer->name.isEmpty())
+			buffer->name = QString("Thread %1").arg(buffer->id);
+
+		currentBuffer = buffer;
+		return *buffer;
+	}
+}
+
+std::int64_t Trace::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::start()
+{
+	Registry & registry = ::registry();
+	registry.start = now();
+
+	//Each thread discards its old spans on its next one
+	registry.generation.fetch_add(1, std::memory_order_relaxed);
+	s_running.store(true, std::memory_order_release);
+}
+
+void Trace::stop()
+{
+	//Ordered against record(), see there
+	s_running.store(false, std::memory_order_seq_cst);
+}
+
+void Trace::nameThread(const QString & name)
+{
+	currentName = name;
+
+	if (!currentBuffer)
+		return;
+
+	QMutexLocker locker(&registry().lock);
+	currentBuffer->name = name;
+}
+
+quint32 Trace::threadId()
+{
+	return threadBuffer().id;
+}
+
+void Trace::record(const char * name, quint32 thread, std::int64_t start, std::int64_t end)
+{
+	//Either save() sees this call and waits for it, or this call sees the trace stopped
+	s_recording.fetch_add(1, std::memory_order_seq_cst);
+	if (s_running.load(std::memory_order_seq_cst))
+		append(name, thread, start, end);
+	s_recording.fetch_sub(1, std::memory_order_release);
+}
+
+void Trace::append(const char * name, quint32 thread, std::int64_t start, std::int64_t end)
+{
+	ThreadBuffer & buffer = threadBuffer();
+
+	const quint32 generation = registry().generation.load(std::memory_order_relaxed);
+	if (buffer.generation != generation)
+	{
+		//Reuse the blocks of the previous trace
+		for (Block * block = buffer.first; block; block = block->next.load(std::memory_order_relaxed))
+			block->count.store(0, std::memory_order_release);
+
+		buffer.last = buffer.first;
+		buffer.generation = generation;
+	}
+
+	if (!buffer.first)
+	{
+		buffer.first = buffer.last = new Block;
+		buffer.blocks = 1;
+	}
+
+	Block * block = buffer.last;
+	size_t count = block->count.load(std::memory_order_relaxed);
+
+	if (count == Block::capacity)
+	{
+		Block * next = block->next.load(std::memory_order_relaxed);
+		if (!next)
+		{
+			if (buffer.blocks == ThreadBuffer::maxBlocks)
+				return;
+
+			next = new Block;
+			++buffer.blocks;
+			block->next.store(next, std::memory_order_release);
+		}
+
+		block = buffer.last = next;
+		count = 0;
+	}
+
+	block->events[count] = {name, thread, start, end};
+	block->count.store(count + 1, std::memory_order_release);
+}
+
+bool Trace::save(const QString & path)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	//Spans ending now are dropped, and the ones being appended are let finish
+	stop();
+	while (s_recording.load(std::memory_order_seq_cst))
+		std::this_thread::yield();
+
+	Registry & registry = ::registry();
+	QMutexLocker locker(&registry.lock);
+
+	const std::int64_t origin = registry.start;
+	auto microseconds = [](std::int64_t nanoseconds) { return QString::number(static_cast<double>(nanoseconds) * 1e-3, 'f', 3); };
+
+	QTextStream out(&file);
+	out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+	bool first = true;
+	auto separate = [&out, &first]
+	{
+		if (!first)
+			out << ",\n";
+		first = false;
+	};
+
+	for (const auto & buffer : registry.buffers)
+	{
+		QString name = buffer->name;
+		name.replace('\\', "\\\\").replace('"', "\\\"");
+
+		separate();
+		out
+				<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id
+				<< ",\"args\":{\"name\":\"" << name << "\"}}";
+
+		//Spans of an older trace are left in threads that recorded nothing since
+		for (Block * block = buffer->first; block; block = block->next.load(std::memory_order_acquire))
+		{
+			const size_t count = block->count.load(std::memory_order_acquire);
+			for (size_t i = 0; i < count; ++i)
+			{
+				const Event & event = block->events[i];
+				if (event.start < origin)
+					continue;
+
+				separate();
+				out
+						<< "{\"name\":\"" << event.name
+						<< "\",\"cat\":\"turtle\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+						<< ",\"ts\":" << microseconds(event.start - origin)
+						<< ",\"dur\":" << microseconds(event.end - event.start) << "}";
+			}
+
+			//Later blocks are left from an older trace
+			if (count < Block::capacity)
+				break;
+		}
+	}
+
+	out << "\n]}\n";
+	out.flush();
+
+	return out.status() == QTextStream::Ok;
+}
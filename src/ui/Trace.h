@@ -0,0 +1,81 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+
+namespace Turtle
+{
+	//Timed spans of code on all the threads, saved as a Chrome/Perfetto trace
+	//While stopped, a span costs a single relaxed load. While running, each thread
+	// appends to a buffer of its own, without locking.
+	//Spans are marked by TURTLE_TRACE(name), with a string literal name.
+	class Trace
+	{
+	public:
+		//Start recording, discarding all the spans recorded before
+		static void start();
+		static void stop();
+
+		static bool isRunning() { return s_running.load(std::memory_order_relaxed); }
+
+		//Write the spans recorded since the last start as Chrome trace events
+		//Should be called while stopped, and waits for the spans still being recorded.
+		static bool save(const QString & path);
+
+		//Name the calling thread in the trace
+		//Only remembered until the thread records its first span, so it costs nothing while stopped.
+		static void nameThread(const QString & name);
+
+		//Records the span of its own lifetime, if started while tracing and ended before stopping
+		//The span is shown on the thread it started on, even if it ends on another one,
+		// e.g. in a fiber resumed by another worker.
+		class Scope
+		{
+		public:
+			explicit Scope(const char * name) :
+				m_name{name},
+				m_start{isRunning() ? now() : 0},
+				m_thread{m_start ? threadId() : 0}
+			{}
+
+			~Scope()
+			{
+				if (m_start)
+					record(m_name, m_thread, m_start, now());
+			}
+
+			Scope(const Scope &) = delete;
+			Scope & operator=(const Scope &) = delete;
+
+		private:
+			const char * m_name;
+			std::int64_t m_start;
+			quint32 m_thread;
+		};
+
+	private:
+		static std::int64_t now();
+		static quint32 threadId();
+		static void record(const char * name, quint32 thread, std::int64_t start, std::int64_t end);
+		static void append(const char * name, quint32 thread, std::int64_t start, std::int64_t end);
+
+		static std::atomic<bool> s_running;
+
+		//Calls of record() under way, waited for by save()
+		static std::atomic<int> s_recording;
+	};
+
+}
+
+#ifdef TURTLE_NO_TRACE
+#	define TURTLE_TRACE(name)
+#else
+#	define TURTLE_TRACE_CONCAT(a, b) a##b
+#	define TURTLE_TRACE_SCOPE(name, line) Turtle::Trace::Scope TURTLE_TRACE_CONCAT(traceScope, line)(name)
+#	define TURTLE_TRACE(name) TURTLE_TRACE_SCOPE(name, __LINE__)
+#endif
+
+#endif // TRACE_H
@@ -1,6 +1,7 @@
 #include "TurtleActor.h"
 #include "World.h"
 #include "TiledFloor.h"
+#include "Trace.h"
 
 #include <cmath>
 
@@ -8,21 +9,16 @@ using namespace Turtle;
 
 const double TurtleActor::pi = 	acos(-1);
 
-TurtleActor::TurtleActor(World &world) :
-	Actor("Turtle"),
+TurtleActor::TurtleActor(World &world, QString name) :
+	Actor(name),
 	m_world{world},
-	m_robot{radius},
-	m_root{new osg::MatrixTransform},
 	commandData{}
 {
-	m_root->addChild(m_robot.root());
 	reset();
 }
 
 bool TurtleActor::operator()(int steps)
 {
-	stepHat(steps);
-
 	if (!m_internalState.active && m_internalState.unpause)
 	{
 		m_internalState.unpause = false;
@@ -38,11 +34,19 @@ bool TurtleActor::operator()(int steps)
 
 	processSetCommand();
 
-	stepPosition(steps);
-	stepAngle(steps);
-	updateState();
-	stepPen();
+	stepMotion(steps);
+
+	//Run the rest of the motion right away, step by step as if animated
+	//Without any speed it would never end, so it's left to the animation.
+	if (m_internalState.instant && (m_internalState.linearSpeed > 0) && (m_internalState.rotationSpeed > 0))
+		for (int i = 0; m_internalState.pending && (i < maxInstantSteps); ++i)
+		{
+			m_internalState.pending = false;
+			stepMotion(steps);
+		}
+
 	updateTileSensor();
+	publish();
 
 	callback(CallbackType::Current);
 
@@ -66,6 +70,7 @@ bool TurtleActor::command(Command & data)
 		case Command::Turtle::Command::Get:
 			return commandGet(data);
 		case Command::Turtle::Command::Set:
+		case Command::Turtle::Command::Transaction:
 			commandSet(data);
 	}
 
@@ -77,7 +82,7 @@ bool TurtleActor::commandGet(Command & data) const
 	updateCommandPosition(data.data.turtle);
 
 	//Fill data that does not depends on the command
-	data.data.turtle.tileSensor = m_internalState.tileSensor;
+	data.data.setTileSensor(m_internalState.tileSensor);
 	data.data.turtle.penDown = m_state.pen.down;
 
 	if (data.data.turtle.target != Command::Turtle::Target::Tile)
@@ -112,7 +117,10 @@ void TurtleActor::reset()
 {
 	m_state = {};
 
-	m_internalState.colorCycle = 0;
+	m_state.current.position = m_internalState.homePosition;
+	m_state.current.angle = m_internalState.homeAngle;
+	m_state.target = m_state.current;
+	m_state.target.tile = m_world.floor().toTileIndex(m_state.target.position);
 
 	m_internalState.lastPenPosition = m_state.current.position;
 
@@ -127,9 +135,16 @@ void TurtleActor::reset()
 
 	updateState();
 	updateTileSensor();
+	publish();
 	callback(CallbackType::Reset);
 }
 
+void TurtleActor::setHome(const Position2D & position, double angle)
+{
+	m_internalState.homePosition = position;
+	m_internalState.homeAngle = normalizeAngle(angle);
+}
+
 double TurtleActor::normalizeAngle(double angle)
 {
 	return fmod(angle + 1.5, 1.0) - 0.5;
@@ -137,91 +152,124 @@ double TurtleActor::normalizeAngle(double angle)
 
 void TurtleActor::processSetCommand()
 {
+	TURTLE_TRACE("TurtleActor::processSetCommand");
+
 	if (!commandData.valid)
 		return;
 
-	//The Get commands should never reach us,
-	// but we check for this anyway.
-	if (commandData.data.turtle.command != Command::Turtle::Command::Set)
-		return;
+	switch (commandData.data.turtle.command)
+	{
+		case Command::Turtle::Command::Get:
+			//The Get commands should never reach us,
+			// but we check for this anyway.
+			break;
+
+		case Command::Turtle::Command::Set:
+			applySetCommand(commandData.data.turtle);
+			break;
+
+		case Command::Turtle::Command::Transaction:
+			//Apply all the operations in this step, updating the derived state
+			// and the pen after each one, as if each was a separate command
+			for (auto & operation : commandData.data.transaction())
+			{
+				applySetCommand(operation);
+				updateState();
+				stepPen();
+			}
+			break;
+	}
 
+	commandData.valid = false;
+}
+
+void TurtleActor::applySetCommand(Command::Turtle & data)
+{
 	//The set bits are only valid for the target and current targets
 	if (
-		(commandData.data.turtle.target != Command::Turtle::Target::Target)
+		(data.target != Command::Turtle::Target::Target)
 		&&
-		(commandData.data.turtle.target != Command::Turtle::Target::Current)
+		(data.target != Command::Turtle::Target::Current)
 		)
 	{
-		commandData.data.turtle.setPosition = false;
-		commandData.data.turtle.setHeading = false;
-		commandData.data.turtle.setPenColor = false;
-		commandData.data.turtle.setPenState = false;
+		data.setPosition = false;
+		data.setHeading = false;
+		data.setPenColor = false;
+		data.setPenState = false;
 	}
 
-	updateCommandPosition(commandData.data.turtle);
+	updateCommandPosition(data);
 
-	if (commandData.data.turtle.setPosition)
+	if (data.setPosition)
 	{
-		if (commandData.data.turtle.target == Command::Turtle::Target::Current)
-			m_state.current.position = commandData.data.turtle.position;
+		if (data.target == Command::Turtle::Target::Current)
+			m_state.current.position = data.position;
 
 		//The target is always set since "current" assumes the position
 		// will stay that way
-		m_state.target.position = commandData.data.turtle.position;
+		m_state.target.position = data.position;
 		m_state.target.tile = m_world.floor().toTileIndex(m_state.target.position);
 	}
 
-	if (commandData.data.turtle.setHeading)
+	if (data.setHeading)
 	{
-		if (commandData.data.turtle.target == Command::Turtle::Target::Current)
-			m_state.current.angle = commandData.data.turtle.angle;
+		if (data.target == Command::Turtle::Target::Current)
+			m_state.current.angle = data.angle;
 
 		//The target is always set since "current" assumes the position
 		// will stay that way
-		m_state.target.angle = commandData.data.turtle.angle;
+		m_state.target.angle = data.angle;
 	}
 
-	if (commandData.data.turtle.setPenColor)
+	if (data.setPenColor)
 	{
-		m_state.pen.color = commandData.data.turtle.color;
+		m_state.pen.color = data.color;
 		m_internalState.penDirty = true;
 	}
 
-	if (commandData.data.turtle.setPenState)
+	if (data.setPenState)
 	{
-		m_state.pen.down = commandData.data.turtle.penDown;
+		m_state.pen.down = data.penDown;
 		m_internalState.penDirty = true;
 	}
 
-	if (commandData.data.turtle.target == Command::Turtle::Target::Tile)
-		m_world.floor().setColor(
-					commandData.data.turtle.tile,
-					commandData.data.turtle.color);
-
-	commandData.valid = false;
+	if (data.target == Command::Turtle::Target::Tile)
+		setTile(
+					data.tile,
+					data.color);
 }
 
-void TurtleActor::stepHat(int steps)
+void TurtleActor::stepMotion(int steps)
 {
-	float alpha = static_cast<float>(sin(pi * m_internalState.colorCycle));
-	m_internalState.colorCycle = fmod(m_internalState.colorCycle + steps * 1e-1 / m_internalState.cycleSpeed, 1);
-	m_robot.setHatColor({0,1-alpha,alpha,1});
+	stepPosition(steps);
+	stepAngle(steps);
+	updateState();
+	stepPen();
 }
 
 void TurtleActor::stepPosition(int steps)
 {
 	//Calculate distance to set point
-	osg::Vec3 delta = static_cast<osg::Vec3>(m_state.target.position - m_state.current.position);
-	double distance = static_cast<double>(delta.length());
+	//Done in single precision, matching osg::Vec3::length() and normalize()
+	const Position2D delta = m_state.target.position - m_state.current.position;
+	const float dx = static_cast<float>(delta.x());
+	const float dy = static_cast<float>(delta.y());
+	const float length = std::sqrt(dx * dx + dy * dy);
+	double distance = static_cast<double>(length);
 
 	if (distance <= (m_internalState.linearSpeed * steps))
 		//The step is small enough to directly set it
 		m_state.current.position = m_state.target.position;
 	else
 	{
-		osg::Vec3 unit = delta;
-		unit.normalize();
-		m_state.current.position += Position2D{unit} * m_internalState.linearSpeed * steps;
+		const float inverse = 1.0f / length;
+		const Position2D unit
+		{
+			static_cast<double>(dx * inverse),
+			static_cast<double>(dy * inverse)
+		};
+
+		m_state.current.position += unit * m_internalState.linearSpeed * steps;
 		m_internalState.pending = true;
 	}
 }
@@ -251,17 +299,12 @@ void TurtleActor::stepAngle(int steps)
 
 void TurtleActor::stepPen()
 {
-	if (m_internalState.penDirty)
-	{
-		m_robot.setTopColor(fromQColor(m_state.pen.color));
-		m_robot.setPenColor(fromQColor(m_state.pen.color));
-		m_robot.setPenState(m_state.pen.down);
-	}
+	TURTLE_TRACE("TurtleActor::stepPen");
 
 	if (m_state.pen.down && (m_internalState.penDirty || (m_state.current.tile != m_internalState.lastPenPosition)))
 	{
 		m_internalState.lastPenPosition = m_state.current.tile;
-		m_world.floor().setColor(m_state.current.tile, m_state.pen.color);
+		setTile(m_state.current.tile, m_state.pen.color);
 
 		//Set this so the next block will invoke the callback
 		m_internalState.penDirty = true;
@@ -273,51 +316,102 @@ void TurtleActor::stepPen()
 
 void TurtleActor::updateState()
 {
-	m_root->setMatrix(
-				osg::Matrix::rotate(2*pi*m_state.current.angle,0,0,1) *
-				osg::Matrix::translate(static_cast<osg::Vec3>(m_state.current.position))
-				);
-
 	m_state.current.tile = m_world.floor().toTileIndex(m_state.current.position);
 	updateHeading();
 }
 
 void TurtleActor::updateTileSensor()
 {
+	TURTLE_TRACE("TurtleActor::updateTileSensor");
+
 	//Get the tile data
-	const auto raw = m_world.floor().getTiles(m_state.current.tile, tileSensorSize);
+	//While buffered the floor is shared, so our own changes are overlaid on it
+	const auto raw = m_world.floor().getTiles(m_state.current.tile, tileSensorSize, m_floorChanges);
 
 	TileSensor::Data data;
+	data.reserve((2 * tileSensorSize + 1) * (2 * tileSensorSize + 1));
 	for (int front = -tileSensorSize; front <= tileSensorSize; ++front)
 		for (int side = -tileSensorSize; side <= tileSensorSize; ++side)
-		{
-			const auto color = raw.get(positionToLocal({front, side}));
+			data.push_back(raw.get(positionToLocal({front, side})));
+
+	TileSensor sensor(data, tileSensorSize);
 
-			data.push_back(color);
+	//Most steps see the same tiles, and the replies already sent keep sharing the previous sensor
+	if (m_internalState.tileSensor && (*m_internalState.tileSensor == sensor))
+		return;
 
+	size_t index = 0;
+	for (int front = -tileSensorSize; front <= tileSensorSize; ++front)
+		for (int side = -tileSensorSize; side <= tileSensorSize; ++side)
 			//Note that the Y axis is inverted
 			m_tileSensor.setPixelColor(
 						tileSensorSize + side,
 						m_tileSensor.height() -1 - (tileSensorSize + front),
-						color);
-		}
+						data[index++]);
+
+	m_internalState.tileSensor = std::make_shared<const TileSensor>(sensor);
+}
+
+void TurtleActor::setTile(const TilePosition2D & tile, const QColor & color)
+{
+	if (m_buffered)
+		m_floorChanges.push_back({m_world.floor().clamp(tile), color});
+	else
+		m_world.floor().setColor(tile, color);
+}
+
+void TurtleActor::commit()
+{
+	m_world.floor().apply(m_floorChanges);
+	m_floorChanges.clear();
+
+	//The callbacks might step us again, e.g. in instant mode
+	std::vector<CallbackType> callbacks;
+	callbacks.swap(m_deferredCallbacks);
+
+	for (const CallbackType type : callbacks)
+		callback(type);
+}
+
+void TurtleActor::publish()
+{
+	//Published before the callbacks, so it's visible by the time a reply is
+	Snapshot snapshot;
+	snapshot.current = m_state.current;
+	snapshot.penColor = m_state.pen.color;
+	snapshot.penDown = m_state.pen.down;
 
-	m_internalState.tileSensor = {data, tileSensorSize};
+	size_t index = 0;
+	for (int front = -tileSensorSize; front <= tileSensorSize; ++front)
+		for (int side = -tileSensorSize; side <= tileSensorSize; ++side)
+			snapshot.sensor[index++] = m_internalState.tileSensor->get(front, side);
+
+	m_snapshot.store(snapshot);
+}
+
+TileSensor TurtleActor::Snapshot::tileSensor() const
+{
+	return {TileSensor::Data(sensor.cbegin(), sensor.cend()), tileSensorSize};
 }
 
 void TurtleActor::updateHeading()
+{
+	m_state.current.heading = toHeading(m_state.current.angle);
+}
+
+Heading TurtleActor::toHeading(double angle)
 {
 	//Find the direction
 	constexpr double quanta = 1.0 / 8;
 
-	if ((m_state.current.angle >= -quanta) && (m_state.current.angle <= quanta))
-		m_state.current.heading = Heading::PositiveX;
-	else if ((m_state.current.angle > quanta) && (m_state.current.angle < 3*quanta))
-		m_state.current.heading = Heading::PositiveY;
-	else if ((m_state.current.angle < -quanta) && (m_state.current.angle > -3*quanta))
-		m_state.current.heading = Heading::NegativeY;
+	if ((angle >= -quanta) && (angle <= quanta))
+		return Heading::PositiveX;
+	else if ((angle > quanta) && (angle < 3*quanta))
+		return Heading::PositiveY;
+	else if ((angle < -quanta) && (angle > -3*quanta))
+		return Heading::NegativeY;
 	else
-		m_state.current.heading = Heading::NegativeX;
+		return Heading::NegativeX;
 }
 
 void TurtleActor::updateCommandPosition(Command::Turtle & data) const
@@ -398,11 +492,16 @@ TilePosition2D TurtleActor::positionToLocal(const TilePosition2D position) const
 }
 
 TilePosition2D TurtleActor::positionToGlobal(const TilePosition2D position) const
+{
+	return tileToGlobal(position, m_state.current.heading);
+}
+
+TilePosition2D TurtleActor::tileToGlobal(const TilePosition2D position, Heading heading)
 {
 	const auto front = position.x();
 	const auto side = position.y();
 
-	switch (m_state.current.heading)
+	switch (heading)
 	{
 		case Heading::PositiveX: return {front, side};
 		case Heading::NegativeX: return {-front, -side};
@@ -429,6 +528,12 @@ Position2D TurtleActor::positionToGlobal(const Position2D position) const
 
 void TurtleActor::callback(CallbackType type)
 {
+	if (m_buffered)
+	{
+		m_deferredCallbacks.push_back(type);
+		return;
+	}
+
 	for (auto & callback : m_callbacks)
 		if (callback)
 			callback(type);
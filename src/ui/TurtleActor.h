@@ -1,17 +1,19 @@
 #ifndef TURTLEACTOR_H
 #define TURTLEACTOR_H
 
+#include <array>
 #include <functional>
+#include <memory>
 #include <vector>
 #include <QColor>
 #include <QImage>
-#include <osg/MatrixTransform>
 
 #include "Types.h"
 #include "Actor.h"
-#include "Robot.h"
 #include "TileSensor.h"
 #include "Command.h"
+#include "SeqLock.h"
+#include "TiledFloor.h"
 
 namespace Turtle
 {
@@ -60,14 +62,37 @@ namespace Turtle
 
 		static constexpr double radius = 0.5;
 		static constexpr int tileSensorSize = 3;
+		static constexpr int tileSensorCells = (tileSensorSize*2 + 1) * (tileSensorSize*2 + 1);
+
+		//Motion steps run in a single instant step, before leaving the rest to the next one
+		//Kept small enough for a step to be a short turn of the event loop.
+		static constexpr int maxInstantSteps = 1 << 12;
+
+		//The state published for readers on other threads
+		//It matches the reply to a Get command for the current location.
+		struct Snapshot
+		{
+			Location current;
+			CommandColor penColor;
+			bool penDown;
+
+			//In TileSensor order
+			std::array<CommandColor, tileSensorCells> sensor;
+
+			TileSensor tileSensor() const;
+		};
 
 		using Callback = std::function<void(CallbackType)>;
 		using Callbacks = std::vector<Callback>;
 
-		TurtleActor(World & world);
+		TurtleActor(World & world, QString name = "Turtle");
 
 		bool operator()(int steps = 1) override;
 
+		bool isParallel() const override { return true; }
+		void setBuffered(bool buffered) override { m_buffered = buffered; }
+		void commit() override;
+
 		//Try to execute the command
 		//Will return false if the command will not be executed
 		bool command(Command & data);
@@ -77,12 +102,13 @@ namespace Turtle
 
 		//Access functors
 		//---------------
-		const osg::ref_ptr<osg::Node> root() const { return m_root; }
-		const osg::ref_ptr<osg::Node> robotRoot() const { return m_robot.root(); }
+		const State & state() const { return m_state; }
 		const QImage & tileSensorImage() const { return m_tileSensor; }
 		Callbacks & callbacks(void) { return m_callbacks; }
+		const SeqLock<Snapshot> & snapshot() const { return m_snapshot; }
 		double & linearSpeed(void) { return m_internalState.linearSpeed; }
 		double & rotationSpeed(void) { return m_internalState.rotationSpeed; }
+		bool & instant(void) { return m_internalState.instant; }
 
 
 		//Control functions
@@ -97,27 +123,50 @@ namespace Turtle
 		//Reset to initial settings
 		void reset();
 
+		//Set where the actor is placed by reset()
+		void setHome(const Position2D & position, double angle = 0);
+
+		World & world() { return m_world; }
+
+		//Transform a tile offset relative to a heading to the global frame
+		static TilePosition2D tileToGlobal(const TilePosition2D position, Heading heading);
+
+		//The heading nearest to an angle
+		static Heading toHeading(double angle);
+
 	protected:
 		static const double pi;
 		static double normalizeAngle(double angle);
 
 		void processSetCommand();
+		void applySetCommand(Command::Turtle & data);
 
-		void stepHat(int steps);
+		void stepMotion(int steps);
 		void stepPosition(int steps);
 		void stepAngle(int steps);
 		void stepPen();
 		void updateState();
 		void updateTileSensor();
 
+		//Set a floor tile, or keep the change aside while buffered
+		void setTile(const TilePosition2D & tile, const QColor & color);
+
+		//Publish the current state to the snapshot
+		void publish();
+
 		struct InternalState
 		{
 			//Speed, in units/step
 			double linearSpeed = 1.0;
 			double rotationSpeed = 0.05;
-			double cycleSpeed = 25.0;
 
-			double colorCycle;
+			//Where to start from after a reset
+			Position2D homePosition;
+			double homeAngle = 0;
+
+			//Run all the motion steps of a command in a single step
+			//The pen draws exactly as in the animated motion.
+			bool instant = false;
 
 			//The last position where the pen drawed
 			TilePosition2D lastPenPosition;
@@ -137,18 +186,24 @@ namespace Turtle
 			//A pause cancelation was requested
 			bool unpause;
 
-			TileSensor tileSensor;
+			//Shared with the replies, a new one is made whenever it changes
+			std::shared_ptr<const TileSensor> tileSensor;
 		};
 
 		World & m_world;
-		Robot m_robot;
-		osg::ref_ptr<osg::MatrixTransform> m_root;
 
 		State m_state;
 		InternalState m_internalState;
 
 		QImage m_tileSensor;
 
+		SeqLock<Snapshot> m_snapshot;
+
+		//While buffered, floor changes and callbacks wait for commit()
+		bool m_buffered = false;
+		TiledFloor::Changes m_floorChanges;
+		std::vector<CallbackType> m_deferredCallbacks;
+
 		Command commandData;
 
 	private:
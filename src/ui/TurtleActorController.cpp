@@ -1,18 +1,89 @@
 #include "TurtleActorController.h"
 
-#include <QInputDialog>
+#include "World.h"
+#include "Trace.h"
+#include "RuntimeMetrics.h"
+
+#include <algorithm>
 
 TurtleActorController::TurtleActorController(
 		TurtleActor &actor,
 		QObject *parent) :
 	QObject(parent),
 	actor{actor},
-	pause{false}
+	callbackIndex{0},
+	pause{false},
+	mailbox{nullptr},
+	userInput{nullptr},
+	journal{nullptr},
+	journalTurtle{0},
+	busy{false},
+	instantQueued{false},
+	draining{false},
+	swarmWatched{false},
+	swarmCallbackIndex{0},
+	swarmBusy{false}
 {
 	//Add our callback dispatcher to the actors' callbacks list
+	callbackIndex = actor.callbacks().size();
 	actor.callbacks().push_back([this](TurtleActor::CallbackType type){callback(type);} );
 }
 
+TurtleActorController::~TurtleActorController()
+{
+	attach(nullptr);
+
+	//Cleared rather than removed, so the other indices stay valid
+	actor.callbacks()[callbackIndex] = {};
+
+	if (swarmWatched)
+		actor.world().swarm().callbacks()[swarmCallbackIndex] = {};
+}
+
+void TurtleActorController::attach(CommandMailbox * mailbox)
+{
+	if (this->mailbox)
+		this->mailbox->setNotifier({});
+
+	this->mailbox = mailbox;
+
+	if (mailbox)
+		//Called from the brain thread, so only schedule the draining
+		mailbox->setNotifier([this]
+		{
+			QMetaObject::invokeMethod(this, [this]{drain();}, Qt::QueuedConnection);
+		});
+}
+
+void TurtleActorController::addFloorMirror(FloorMirror * mirror)
+{
+	//Registered with the floor on the first sync, so brains that never read tiles cost nothing
+	floorMirrors.push_back(mirror);
+
+	//Called from the brain thread, so only schedule the sync
+	mirror->setSyncRequest([this, mirror]
+	{
+		QMetaObject::invokeMethod(this, [this, mirror]{syncFloorMirror(mirror);}, Qt::QueuedConnection);
+	});
+}
+
+void TurtleActorController::removeFloorMirror(FloorMirror * mirror)
+{
+	mirror->setSyncRequest({});
+	actor.world().floor().removeObserver(mirror);
+	floorMirrors.erase(std::remove(floorMirrors.begin(), floorMirrors.end(), mirror), floorMirrors.end());
+}
+
+void TurtleActorController::syncFloorMirror(FloorMirror * mirror)
+{
+	//The mirror may have been removed since it asked
+	if (std::find(floorMirrors.cbegin(), floorMirrors.cend(), mirror) == floorMirrors.cend())
+		return;
+
+	actor.world().floor().addObserver(mirror);
+	mirror->sync(actor.world().floor());
+}
+
 void TurtleActorController::setSingleStep(bool enable)
 {
 	pause = enable;
@@ -24,17 +95,27 @@ void TurtleActorController::continueSingleStep()
 	actor.unpause();
 }
 
-void TurtleActorController::command(const Command & data)
+void TurtleActorController::command(Command data)
 {
-	if (!data.valid)
-		return;
+	TURTLE_TRACE("TurtleActorController::command");
 
 	if (data.reply)
 		return;
 
+	if (journal)
+		journal->record(CommandJournal::Entry::Kind::Command, journalTurtle, data);
+
+	if (!data.valid)
+	{
+		//Reply right away so the sender is not left waiting
+		data.reply = true;
+		reply(data);
+		return;
+	}
+
 	emit signalCommand(data);
 
-	commandData = data;
+	commandData = std::move(data);
 	commandData.reply = true;
 	commandData.valid = false;
 
@@ -42,74 +123,241 @@ void TurtleActorController::command(const Command & data)
 	{
 		case Command::Destination::UI:
 			commandUI(commandData);
-			emit commandReply(commandData);
+			reply(commandData);
 			break;
 
 		case Command::Destination::Turtle:
+		{
 			const bool ok = actor.command(commandData);
 			commandData.reply = true;
 			if (!ok || (commandData.data.turtle.command == Command::Turtle::Command::Get))
-				emit commandReply(commandData);
+				reply(commandData);
 			else
+			{
 				//Set as valid since the command was accepted an it will
 				// be successfully completed
 				commandData.valid = true;
+
+				//The reply is sent when the actor becomes active again
+				busy = true;
+
+				//Don't wait for the world to step, the command completes at once
+				if (actor.instant())
+					stepInstant();
+			}
+			break;
+		}
+
+		case Command::Destination::Swarm:
+			if (commandSwarm(commandData))
+			{
+				//The reply is sent once the swarm completes the motion
+				busy = true;
+				swarmBusy = true;
+			}
+			else
+				reply(commandData);
 			break;
 	}
 }
 
+void TurtleActorController::stepInstant()
+{
+	//Stop once the command completes, or if the actor can not progress, e.g. when paused
+	if (!actor() || !busy || !actor.instant() || instantQueued)
+		return;
+
+	//Let the event loop turn between the chunks of a long motion
+	instantQueued = true;
+	QMetaObject::invokeMethod(this, [this]
+	{
+		instantQueued = false;
+		stepInstant();
+	}, Qt::QueuedConnection);
+}
+
+void TurtleActorController::drain()
+{
+	//Acknowledge first, so any command posted from now on schedules us again
+	if (mailbox)
+		mailbox->acknowledgeNotification();
+
+	//UI commands might spin a nested event loop that calls us again
+	if (!mailbox || draining)
+		return;
+
+	draining = true;
+
+	//Commands are executed one at a time, in order
+	Command next;
+	while (!busy && mailbox && mailbox->take(next))
+		command(std::move(next));
+
+	draining = false;
+}
+
 void TurtleActorController::commandUI(Command & data)
 {
-	switch (data.data.ui.command)
+	switch (data.data.ui().command)
 	{
 		case Command::UI::Command::Log:
+			Turtle::RuntimeMetrics::global().logged();
 			emit log(
-						data.data.ui.text,
-						data.data.ui.title,
-						data.data.ui.level);
+						data.data.ui().text,
+						data.data.ui().title,
+						data.data.ui().level);
 
 			data.valid = true;
 			return;
 
 		case Command::UI::Command::GetInt:
-			data.data.ui.integer =
-					QInputDialog::getInt(
-						nullptr,
-						data.data.ui.title,
-						data.data.ui.text,
-						data.data.ui.integer,
-						static_cast<int>(data.data.ui.min),
-						static_cast<int>(data.data.ui.max),
-						static_cast<int>(data.data.ui.step),
-						&data.valid);
+			data.valid =
+					userInput &&
+					userInput->getInteger(
+						data.data.ui().title,
+						data.data.ui().text,
+						data.data.ui().integer,
+						static_cast<int>(data.data.ui().min),
+						static_cast<int>(data.data.ui().max),
+						static_cast<int>(data.data.ui().step));
 			return;
 
 		case Command::UI::Command::GetDouble:
-			data.data.ui.real =
-					QInputDialog::getDouble(
-						nullptr,
-						data.data.ui.title,
-						data.data.ui.text,
-						data.data.ui.real,
-						data.data.ui.min,
-						data.data.ui.max,
-						static_cast<int>(data.data.ui.step),
-						&data.valid);
+			data.valid =
+					userInput &&
+					userInput->getDouble(
+						data.data.ui().title,
+						data.data.ui().text,
+						data.data.ui().real,
+						data.data.ui().min,
+						data.data.ui().max,
+						data.data.ui().step);
 			return;
 
 		case Command::UI::Command::GetString:
-			data.data.ui.string =
-					QInputDialog::getText(
-						nullptr,
-						data.data.ui.title,
-						data.data.ui.text,
-						QLineEdit::Normal,
-						data.data.ui.string,
-						&data.valid);
+			data.valid =
+					userInput &&
+					userInput->getString(
+						data.data.ui().title,
+						data.data.ui().text,
+						data.data.ui().string);
 			return;
 	}
 }
 
+bool TurtleActorController::commandSwarm(Command & data)
+{
+	SwarmActor & swarm = actor.world().swarm();
+
+	if (!swarmWatched)
+	{
+		swarmCallbackIndex = swarm.callbacks().size();
+		swarm.callbacks().push_back([this]{swarmStepped();});
+		swarmWatched = true;
+	}
+
+	Command::Swarm & request = data.data.swarm();
+
+	//Until the request is known to be good, so a rejected one is not replied as valid
+	data.valid = false;
+	request.states.clear();
+	request.sensors.clear();
+
+	switch (request.command)
+	{
+		case Command::Swarm::Command::Add:
+			request.group.clear();
+			for (const Command::Turtle & operation : request.operations)
+				request.group.push_back(static_cast<quint32>(swarm.add(operation.position, operation.angle)));
+
+			data.valid = true;
+			return false;
+
+		case Command::Swarm::Command::Get:
+			if (!resolveSwarmGroup(request))
+				return false;
+
+			request.states.resize(request.group.size());
+
+			for (size_t i = 0; i < request.group.size(); ++i)
+			{
+				swarm.commandGet(request.group[i], request.states[i]);
+
+				if (request.sensorSize > 0)
+					request.sensors.push_back(
+								actor.world().floor().getTiles(
+									request.states[i].tile,
+									static_cast<size_t>(request.sensorSize)));
+			}
+
+			data.valid = true;
+			return false;
+
+		case Command::Swarm::Command::Set:
+			if (!resolveSwarmGroup(request))
+				return false;
+
+			if ((request.operations.size() != 1) && (request.operations.size() != request.group.size()))
+				return false;
+
+			for (size_t i = 0; i < request.group.size(); ++i)
+			{
+				Command::Turtle operation = request.operations[(request.operations.size() == 1) ? 0 : i];
+				swarm.command(request.group[i], operation);
+			}
+
+			data.valid = true;
+
+			//Jumps and pens are complete already
+			return isSwarmPending(request);
+
+		case Command::Swarm::Command::Clear:
+			swarm.clear();
+			request.group.clear();
+
+			data.valid = true;
+			return false;
+	}
+
+	return false;
+}
+
+void TurtleActorController::swarmStepped()
+{
+	if (!swarmBusy || isSwarmPending(commandData.data.swarm()))
+		return;
+
+	swarmBusy = false;
+	busy = false;
+	reply(commandData);
+
+	//Called from within the world's step, so continue with the next command, if any, after it
+	QMetaObject::invokeMethod(this, [this]{drain();}, Qt::QueuedConnection);
+}
+
+bool TurtleActorController::resolveSwarmGroup(Command::Swarm & swarm) const
+{
+	const SwarmActor & actors = actor.world().swarm();
+
+	//An empty group addresses all the turtles
+	if (swarm.group.empty())
+		for (size_t i = 0; i < actors.size(); ++i)
+			swarm.group.push_back(static_cast<quint32>(i));
+
+	return std::all_of(
+				swarm.group.cbegin(), swarm.group.cend(),
+				[&actors](quint32 index) { return index < actors.size(); });
+}
+
+bool TurtleActorController::isSwarmPending(const Command::Swarm & swarm) const
+{
+	const SwarmActor & actors = actor.world().swarm();
+
+	return std::any_of(
+				swarm.group.cbegin(), swarm.group.cend(),
+				[&actors](quint32 index) { return (index < actors.size()) && actors.isPending(index); });
+}
+
 void TurtleActorController::callback(TurtleActor::CallbackType type)
 {
 	//Get the current state
@@ -133,12 +381,28 @@ void TurtleActorController::callback(TurtleActor::CallbackType type)
 			emit newCurrentState(stateCommand);
 
 			//Make sure any waiters are unblocked
-			emit commandReply(stateCommand);
+			if (busy)
+			{
+				busy = false;
+				swarmBusy = false;
+				stateCommand.sequence = commandData.sequence;
+				reply(stateCommand);
+			}
+
+			drain();
 			break;
 
 		case TurtleActor::CallbackType::Active:
 			emit newRunState(true);
-			emit commandReply(commandData);
+
+			if (busy && !swarmBusy)
+			{
+				busy = false;
+				reply(commandData);
+			}
+
+			//Continue with the next command, if any
+			drain();
 			break;
 
 		case TurtleActor::CallbackType::Paused:
@@ -150,3 +414,14 @@ void TurtleActorController::callback(TurtleActor::CallbackType type)
 			break;
 	}
 }
+
+void TurtleActorController::reply(const Command & data)
+{
+	if (journal)
+		journal->record(CommandJournal::Entry::Kind::Reply, journalTurtle, data);
+
+	if (mailbox)
+		mailbox->reply(data);
+
+	emit commandReply(data);
+}
@@ -4,7 +4,11 @@
 #include <QObject>
 
 #include "Command.h"
+#include "CommandMailbox.h"
 #include "TurtleActor.h"
+#include "FloorMirror.h"
+#include "UserInput.h"
+#include "CommandJournal.h"
 
 using namespace Turtle;
 
@@ -17,8 +21,31 @@ public:
 			TurtleActor & actor,
 			QObject *parent = nullptr);
 
+	//Must be destroyed before the actor
+	~TurtleActorController() override;
+
+	//Attach to a command channel, or detach when null
+	//Commands are taken from the channel and replies are posted back to it
+	void attach(CommandMailbox * mailbox);
+
+	//The actor's published state, readable from any thread
+	const SeqLock<TurtleActor::Snapshot> & snapshot() const { return actor.snapshot(); }
+
+	//Stream the floor under the actor to a mirror, or stop streaming
+	//The mirror streams from the floor once it first asks for a sync, i.e. once its brain reads a tile.
+	void addFloorMirror(FloorMirror * mirror);
+	void removeFloorMirror(FloorMirror * mirror);
+
+	//Answer the brain's input requests with this, or refuse them when null
+	void setUserInput(UserInput * input) { userInput = input; }
+
+	//Record the commands and replies, as coming from the turtle at this world index
+	//Set to null to stop recording.
+	void setJournal(CommandJournal * journal, quint32 turtle = 0) { this->journal = journal; journalTurtle = turtle; }
+
 	double linearSpeed() const { return actor.linearSpeed(); }
 	double rotationSpeed() const { return actor.rotationSpeed(); }
+	bool isInstant() const { return actor.instant(); }
 
 signals:
 	void log(QString text, QString title, int level);
@@ -39,20 +66,70 @@ public slots:
 	void setLinearSpeed(double speed) const { actor.linearSpeed() = speed; }
 	void setRotationSpeed(double speed) const { actor.rotationSpeed() = speed; }
 
+	//Complete Set commands right away, instead of animating them
+	void setInstant(bool enable) const { actor.instant() = enable; }
+
 	void reset() { actor.reset(); }
 
 	void setSingleStep(bool enable);
 	void continueSingleStep();
 
-	void command(const Command & data);
+	void command(Command data);
 
 private:
+	//Execute all available commands from the attached channel
+	void drain();
+
+	//Step the actor at once, queueing the rest of a long motion for the next turn of the event loop
+	void stepInstant();
+
+	//Send a snapshot of the floor to a mirror that asked for it
+	void syncFloorMirror(FloorMirror * mirror);
+
 	void commandUI(Command & data);
+
+	//Returns whether the reply should wait for the addressed turtles to complete their motion
+	bool commandSwarm(Command & data);
+
+	//Called after each step of the swarm
+	void swarmStepped();
+
+	//Fill in an empty group with the whole swarm, returning false if it addresses a missing turtle
+	bool resolveSwarmGroup(Command::Swarm & swarm) const;
+
+	//Whether any addressed turtle is still in motion
+	bool isSwarmPending(const Command::Swarm & swarm) const;
 	void callback(TurtleActor::CallbackType type);
+	void reply(const Command & data);
 
 	TurtleActor & actor;
+	size_t callbackIndex;
 	bool pause;
 
+	CommandMailbox * mailbox;
+	UserInput * userInput;
+
+	std::vector<FloorMirror *> floorMirrors;
+
+	CommandJournal * journal;
+	quint32 journalTurtle;
+
+	//Set while the actor executes a command that was not replied to yet
+	bool busy;
+
+	//Set while the rest of an instant motion is queued
+	bool instantQueued;
+
+	//Set while commands are drained from the channel
+	bool draining;
+
+	//Set once our callback was added to the swarm
+	bool swarmWatched;
+	size_t swarmCallbackIndex;
+
+	//Set while waiting for the swarm to complete a command
+	bool swarmBusy;
+
 	Command commandData;
 };
 
@@ -0,0 +1,90 @@
+#include "TurtleAgent.h"
+
+TurtleAgent::TurtleAgent(
+		TurtleActor & actor,
+		Turtle::FiberScheduler * scheduler,
+		QObject *parent) :
+	QObject{parent},
+	turtle{actor},
+	actorController{new TurtleActorController(actor, this)}
+{
+	if (scheduler)
+	{
+		fiberBrain = new FiberBrainController(actorController, *scheduler, this);
+		connect(fiberBrain, &FiberBrainController::started, this, &TurtleAgent::started);
+		connect(fiberBrain, &FiberBrainController::stopped, this, &TurtleAgent::stopped);
+	}
+	else
+	{
+		threadedBrain = new ThreadedBrainController(actorController, this);
+		connect(threadedBrain, &ThreadedBrainController::started, this, &TurtleAgent::started);
+		connect(threadedBrain, &ThreadedBrainController::stopped, this, &TurtleAgent::stopped);
+	}
+}
+
+TurtleAgent::TurtleAgent(
+		TurtleActor & actor,
+		Turtle::CoroutineScheduler & scheduler,
+		QObject *parent) :
+	QObject{parent},
+	turtle{actor},
+	actorController{new TurtleActorController(actor, this)},
+	coroutineBrain{new CoroutineBrainController(actorController, scheduler, this)}
+{
+	connect(coroutineBrain, &CoroutineBrainController::started, this, &TurtleAgent::started);
+	connect(coroutineBrain, &CoroutineBrainController::stopped, this, &TurtleAgent::stopped);
+}
+
+TurtleAgent::~TurtleAgent()
+{
+	//The brain detaches from the controller, so it goes first
+	delete threadedBrain;
+	delete fiberBrain;
+	delete coroutineBrain;
+	delete actorController;
+}
+
+void TurtleAgent::start()
+{
+	if (threadedBrain)
+		threadedBrain->start();
+
+	if (fiberBrain)
+		fiberBrain->start();
+
+	if (coroutineBrain)
+		coroutineBrain->start();
+}
+
+void TurtleAgent::stop()
+{
+	if (threadedBrain)
+		threadedBrain->stop();
+
+	if (fiberBrain)
+		fiberBrain->stop();
+
+	if (coroutineBrain)
+		coroutineBrain->stop();
+}
+
+void TurtleAgent::setProgram(ThreadedBrain::Program program)
+{
+	if (threadedBrain)
+		threadedBrain->setProgram(program);
+
+	if (fiberBrain)
+		fiberBrain->setProgram(program);
+}
+
+void TurtleAgent::setWriteBehind(bool enable)
+{
+	if (threadedBrain)
+		threadedBrain->setWriteBehind(enable);
+
+	if (fiberBrain)
+		fiberBrain->setWriteBehind(enable);
+
+	if (coroutineBrain)
+		coroutineBrain->setWriteBehind(enable);
+}
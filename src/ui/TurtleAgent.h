@@ -0,0 +1,62 @@
+#ifndef TURTLEAGENT_H
+#define TURTLEAGENT_H
+
+#include <QPointer>
+#include <QObject>
+
+#include "TurtleActor.h"
+#include "TurtleActorController.h"
+#include "ThreadedBrainController.h"
+#include "FiberBrainController.h"
+#include "FiberScheduler.h"
+#include "CoroutineBrainController.h"
+#include "CoroutineScheduler.h"
+
+//A turtle of the world together with its command channel and brain
+//The brain runs on a thread of its own, on a fiber when a fiber scheduler is given,
+// or as a task when a coroutine scheduler is given.
+class TurtleAgent : public QObject
+{
+	Q_OBJECT
+public:
+	explicit TurtleAgent(
+			TurtleActor & actor,
+			Turtle::FiberScheduler * scheduler = nullptr,
+			QObject *parent = nullptr);
+
+	TurtleAgent(
+			TurtleActor & actor,
+			Turtle::CoroutineScheduler & scheduler,
+			QObject *parent = nullptr);
+
+	//Stops the brain
+	//Must be destroyed before the actor
+	~TurtleAgent() override;
+
+	TurtleActor & actor() const { return turtle; }
+	TurtleActorController * controller() const { return actorController; }
+
+	//Set the program run by a threaded or fiber brain, see ThreadedBrain::setProgram()
+	//Coroutine brains run tasks, so they keep their own program.
+	void setProgram(ThreadedBrain::Program program);
+
+signals:
+	void started();
+	void stopped();
+
+public slots:
+	void start();
+	void stop();
+
+	//Enable the brain's write-behind mode
+	void setWriteBehind(bool enable);
+
+private:
+	TurtleActor & turtle;
+	QPointer<TurtleActorController> actorController;
+	QPointer<ThreadedBrainController> threadedBrain;
+	QPointer<FiberBrainController> fiberBrain;
+	QPointer<CoroutineBrainController> coroutineBrain;
+};
+
+#endif // TURTLEAGENT_H
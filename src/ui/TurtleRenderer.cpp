@@ -0,0 +1,41 @@
+#include "TurtleRenderer.h"
+#include "OsgTypes.h"
+
+#include <cmath>
+
+using namespace Turtle;
+
+const double TurtleRenderer::pi = acos(-1);
+
+TurtleRenderer::TurtleRenderer(const TurtleActor & actor) :
+	m_actor{actor},
+	m_robot{TurtleActor::radius},
+	m_root{new osg::MatrixTransform}
+{
+	m_root->addChild(m_robot.root());
+	update(0);
+}
+
+void TurtleRenderer::update(double elapsed)
+{
+	const TurtleActor::State & state = m_actor.state();
+
+	m_root->setMatrix(
+				osg::Matrix::rotate(2*pi*state.current.angle,0,0,1) *
+				osg::Matrix::translate(static_cast<osg::Vec3>(state.current.position))
+				);
+
+	if (!m_penValid || (m_pen.color != state.pen.color) || (m_pen.down != state.pen.down))
+	{
+		m_pen = state.pen;
+		m_penValid = true;
+
+		m_robot.setTopColor(fromQColor(m_pen.color));
+		m_robot.setPenColor(fromQColor(m_pen.color));
+		m_robot.setPenState(m_pen.down);
+	}
+
+	float alpha = static_cast<float>(sin(pi * m_colorCycle));
+	m_colorCycle = fmod(m_colorCycle + elapsed / m_cycleTime, 1);
+	m_robot.setHatColor({0,1-alpha,alpha,1});
+}
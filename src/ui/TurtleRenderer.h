@@ -0,0 +1,44 @@
+#ifndef TURTLERENDERER_H
+#define TURTLERENDERER_H
+
+#include "Types.h"
+#include "TurtleActor.h"
+#include "Robot.h"
+
+#include <osg/MatrixTransform>
+
+namespace Turtle
+{
+	//The graphical representation of a TurtleActor
+	//The actor's state is pulled once per frame, so simulation steps cost nothing here.
+	class TurtleRenderer
+	{
+	public:
+		explicit TurtleRenderer(const TurtleActor & actor);
+
+		//Update to the actor's current state, animating by the time elapsed, in seconds
+		void update(double elapsed);
+
+		//Access functors
+		osg::ref_ptr<osg::Node> root() const { return m_root; }
+		osg::ref_ptr<osg::Node> robotRoot() const { return m_robot.root(); }
+
+	private:
+		static const double pi;
+
+		const TurtleActor & m_actor;
+
+		Robot m_robot;
+		osg::ref_ptr<osg::MatrixTransform> m_root;
+
+		//The time for a full hat color cycle, in seconds
+		double m_cycleTime = 2.5;
+		double m_colorCycle = 0;
+
+		//The pen the robot shows
+		TurtleActor::Pen m_pen;
+		bool m_penValid = false;
+	};
+
+}
+#endif // TURTLERENDERER_H
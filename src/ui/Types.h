@@ -5,34 +5,14 @@
 
 #include <QColor>
 
-#include <osg/Vec2>
-#include <osg/Vec3>
-#include <osg/Vec4>
-
 #include <array>
 #include <algorithm>
 
 namespace Turtle
 {
-	using OsgColor = osg::Vec4;
-
-	//Helper template to count number of elements in osg vectors
+	//Helper template to count number of elements in foreign vectors
+	//Specialize for vectors without a Count member, see OsgTypes.h
 	template <typename V> struct CountVector  {static constexpr int Count() {return V::Count;}};
-	template <> struct CountVector<osg::Vec2> { static constexpr int Count() {return 2;}};
-	template <> struct CountVector<osg::Vec3> { static constexpr int Count() {return 3;}};
-	template <> struct CountVector<osg::Vec4> { static constexpr int Count() {return 4;}};
-
-	template <typename T = void>
-	OsgColor fromQColor(const QColor & color)
-	{
-		return OsgColor
-		{
-			static_cast<OsgColor::value_type>(color.redF()),
-			static_cast<OsgColor::value_type>(color.greenF()),
-			static_cast<OsgColor::value_type>(color.blueF()),
-			static_cast<OsgColor::value_type>(color.alphaF())
-		};
-	}
 
 
 	template <typename T, int N>
@@ -46,7 +26,7 @@ namespace Turtle
 
 		Coordinate(V v = {}) : m_v(v) {}
 
-		//Construction from osg vectors
+		//Construction from foreign vectors
 		template <typename V> explicit Coordinate(const V & v) { *this = v; }
 
 		//Construction from Coordinate
@@ -96,7 +76,7 @@ namespace Turtle
 			return *this;
 		}
 
-		//Assignment from osg vectors
+		//Assignment from foreign vectors
 		template <typename V> Type & operator=(const V & v)
 		{
 			for (size_t i = 0; i < std::min(N, CountVector<V>::Count()); ++i)
@@ -106,7 +86,7 @@ namespace Turtle
 		}
 
 
-		//Conversion to osg vectors
+		//Conversion to foreign vectors
 		template <typename V> explicit operator V() const
 		{
 			V v;
@@ -0,0 +1,35 @@
+#ifndef USERINPUT_H
+#define USERINPUT_H
+
+#include <QString>
+
+namespace Turtle
+{
+	//Answers the brain's requests for user input
+	//Each request returns whether it was accepted, with the answer in value.
+	//The value holds the default on entry, and is left unchanged when not accepted.
+	class UserInput
+	{
+	public:
+		virtual ~UserInput() = default;
+
+		virtual bool getInteger(
+				const QString & title,
+				const QString & label,
+				int & value,
+				int min, int max, int step) = 0;
+
+		virtual bool getDouble(
+				const QString & title,
+				const QString & label,
+				double & value,
+				double min, double max, double step) = 0;
+
+		virtual bool getString(
+				const QString & title,
+				const QString & label,
+				QString & value) = 0;
+	};
+}
+
+#endif // USERINPUT_H
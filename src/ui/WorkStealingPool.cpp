@@ -0,0 +1,124 @@
+#include "WorkStealingPool.h"
+#include "Trace.h"
+
+#include <algorithm>
+
+using namespace Turtle;
+
+WorkStealingPool::WorkStealingPool(unsigned int workers)
+{
+	if (!workers)
+		workers = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+	for (unsigned int i = 0; i <= workers; ++i)
+		m_queues.push_back(std::make_unique<Queue>());
+
+	m_workers.reserve(workers);
+	for (unsigned int i = 0; i < workers; ++i)
+		m_workers.emplace_back(&WorkStealingPool::work, this, i + 1);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+	m_stopping.store(true);
+	m_bell.ring();
+
+	for (auto & worker : m_workers)
+		worker.join();
+}
+
+void WorkStealingPool::parallelFor(size_t count, const Body & body, size_t grain)
+{
+	grain = std::max<size_t>(grain, 1);
+
+	//Not worth waking anyone up
+	if (m_workers.empty() || (count <= grain))
+	{
+		for (size_t i = 0; i < count; ++i)
+			body(i);
+		return;
+	}
+
+	const size_t ranges = (count + grain - 1) / grain;
+
+	m_body = &body;
+	m_remaining.store(ranges, std::memory_order_relaxed);
+
+	//Deal the ranges round robin, the queue locks publish the body
+	for (size_t i = 0; i < ranges; ++i)
+	{
+		Queue & queue = *m_queues[i % m_queues.size()];
+		std::lock_guard<std::mutex> locker(queue.lock);
+		queue.ranges.push_back({i * grain, std::min(count, (i + 1) * grain)});
+	}
+
+	m_bell.ring();
+
+	run(0);
+
+	//Wait for the ranges taken by others
+	for (size_t left; (left = m_remaining.load(std::memory_order_acquire)) != 0;)
+		m_remaining.wait(left, std::memory_order_acquire);
+}
+
+void WorkStealingPool::work(size_t self)
+{
+	Trace::nameThread(QString("Step worker %1").arg(self));
+
+	//Starting from 0 so a batch posted before we got here is not missed
+	uint32_t seen = 0;
+
+	for (;;)
+	{
+		m_bell.wait(seen);
+		seen = m_bell.value();
+
+		if (m_stopping.load())
+			return;
+
+		run(self);
+	}
+}
+
+void WorkStealingPool::run(size_t self)
+{
+	Range range;
+	while (take(self, range))
+	{
+		for (size_t i = range.begin; i < range.end; ++i)
+			(*m_body)(i);
+
+		if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			m_remaining.notify_all();
+	}
+}
+
+bool WorkStealingPool::take(size_t self, Range & range)
+{
+	{
+		Queue & own = *m_queues[self];
+		std::lock_guard<std::mutex> locker(own.lock);
+
+		if (!own.ranges.empty())
+		{
+			range = own.ranges.back();
+			own.ranges.pop_back();
+			return true;
+		}
+	}
+
+	for (size_t i = 1; i < m_queues.size(); ++i)
+	{
+		Queue & victim = *m_queues[(self + i) % m_queues.size()];
+		std::lock_guard<std::mutex> locker(victim.lock);
+
+		if (!victim.ranges.empty())
+		{
+			range = victim.ranges.front();
+			victim.ranges.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
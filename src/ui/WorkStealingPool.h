@@ -0,0 +1,78 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SpscRing.h"
+
+namespace Turtle
+{
+	//A fork-join pool of threads that balance the work by stealing it
+	//Each thread has a queue of index ranges. It takes work from the back of its own
+	// queue, and once that runs dry steals from the front of the others'.
+	class WorkStealingPool
+	{
+	public:
+		using Body = std::function<void(size_t index)>;
+
+		//The calling thread takes part in the work,
+		// so use 0 workers for one less than the hardware threads
+		explicit WorkStealingPool(unsigned int workers = 0);
+		WorkStealingPool(const WorkStealingPool &) = delete;
+		WorkStealingPool & operator=(const WorkStealingPool &) = delete;
+
+		~WorkStealingPool();
+
+		//Call the body for every index in [0, count), returning once all are done
+		//Indices are handed out in ranges of the grain size. The body must not throw.
+		//Not reentrant: only one thread may call this at a time.
+		void parallelFor(size_t count, const Body & body, size_t grain = 1);
+
+		unsigned int workers() const { return static_cast<unsigned int>(m_workers.size()); }
+
+	private:
+		struct Range
+		{
+			size_t begin;
+			size_t end;
+		};
+
+		struct Queue
+		{
+			std::mutex lock;
+			std::deque<Range> ranges;
+		};
+
+		//Worker thread main loop
+		void work(size_t self);
+
+		//Run ranges until there are none left to take
+		void run(size_t self);
+
+		//Take a range from our own queue, or steal one
+		bool take(size_t self, Range & range);
+
+		//One per thread, the caller's is the first
+		std::vector<std::unique_ptr<Queue>> m_queues;
+
+		//The current body, read only after taking a range
+		const Body * m_body = nullptr;
+
+		//Ranges not yet done
+		std::atomic<size_t> m_remaining {0};
+
+		std::atomic<bool> m_stopping {false};
+		Doorbell m_bell;
+
+		std::vector<std::thread> m_workers;
+	};
+}
+
+#endif // WORKSTEALINGPOOL_H
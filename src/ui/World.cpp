@@ -1,24 +1,86 @@
 #include "World.h"
 
 #include "TurtleActor.h"
+#include "Trace.h"
+#include "RuntimeMetrics.h"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 
 using namespace Turtle;
 
-World::World() :
-	m_mainActor(*this)
+World::World()
 {
-	m_actors.push_back(m_mainActor);
+	m_turtles.push_back(std::make_unique<TurtleActor>(*this));
+	m_actors.push_back(*m_turtles.back());
+}
+
+TurtleActor & World::addTurtle()
+{
+	const size_t index = m_turtles.size();
+
+	m_turtles.push_back(std::make_unique<TurtleActor>(*this, "Turtle " + QString::number(index + 1)));
+	TurtleActor & turtle = *m_turtles.back();
+	m_actors.push_back(turtle);
+
+	const auto home = turtleHome(index);
+	turtle.setHome(home.first, home.second);
+	turtle.reset();
+
+	return turtle;
+}
 
-	//Add all graphical elements to the scene
-	m_scene.addChild(m_floor.root());
-	m_scene.addChild(m_mainActor.root());
+void World::removeTurtle(TurtleActor & turtle)
+{
+	if (&turtle == &mainActor())
+		return;
+
+	m_actors.erase(
+				std::remove_if(
+					m_actors.begin(), m_actors.end(),
+					[&turtle](const Actor & actor) { return &actor == &turtle; }),
+				m_actors.end());
+
+	m_turtles.erase(
+				std::remove_if(
+					m_turtles.begin(), m_turtles.end(),
+					[&turtle](const auto & actor) { return actor.get() == &turtle; }),
+				m_turtles.end());
+}
+
+SwarmActor & World::swarm()
+{
+	if (!m_swarm)
+	{
+		m_swarm = std::make_unique<SwarmActor>(*this);
+		m_actors.push_back(*m_swarm);
+	}
+
+	return *m_swarm;
 }
 
 void World::resize(const Index2D & size, const Position2D & tileSize)
 {
 	m_floor.reset(size, tileSize);
+	bound();
+}
+
+void World::setUnbounded(bool unbounded)
+{
+	m_floor.setUnbounded(unbounded);
+	bound();
+}
+
+void World::bound()
+{
+	if (m_floor.isUnbounded())
+	{
+		const Position::value_type infinity = std::numeric_limits<Position::value_type>::infinity();
+		boundingBox[0] = Position{-infinity, -infinity};
+		boundingBox[1] = Position{infinity, infinity};
+		return;
+	}
 
 	boundingBox[0] = -m_floor.halfSize();
 	boundingBox[1] = m_floor.halfSize();
@@ -27,7 +89,7 @@ void World::resize(const Index2D & size, const Position2D & tileSize)
 void World::reset()
 {
 	m_floor.clear();
-	m_mainActor.reset();
+	resetTurtles();
 }
 
 void World::setImage(const QImage & image)
@@ -52,21 +114,86 @@ void World::setImage(const QImage & image)
 
 	resize(halfSize);
 	m_floor.setImage(image.copy({{0,0},size}));
-	m_mainActor.reset();
+	resetTurtles();
+}
+
+void World::setFloor(const Index2D & size, const TiledFloor::Chunks & chunks)
+{
+	resize(size);
+	m_floor.setChunks(chunks);
+	resetTurtles();
 }
 
 bool World::operator()(int steps)
 {
+	if (m_actors.empty() || m_stepping)
+		return false;
+
+	TURTLE_TRACE("World::operator()");
+
+	m_stepping = true;
+	++m_stepCount;
+	RuntimeMetrics::global().stepped();
+
+	//Each actor getting to be first in turn
+	const size_t count = m_actors.size();
+	m_firstActor %= count;
+
+	auto actor = [this, count](size_t i) -> Actor & { return m_actors[(m_firstActor + i) % count]; };
+
+	m_changed.assign(count, false);
+
+	for (size_t i = 0; i < count; ++i)
+		actor(i).setBuffered(true);
+
+	auto step = [&actor, this, steps](size_t i)
+	{
+		Actor & stepped = actor(i);
+		if (stepped.isParallel())
+			m_changed[i] = stepped(steps);
+	};
+
+	if (m_pool && (count >= parallelThreshold))
+		m_pool->parallelFor(
+					count, step,
+					std::max<size_t>(1, count / (8 * (m_pool->workers() + 1))));
+	else
+		for (size_t i = 0; i < count; ++i)
+			step(i);
+
+	//Apply the changes in order, stepping the rest of the actors in between
 	bool dirty = false;
+	for (size_t i = 0; i < count; ++i)
+	{
+		Actor & stepped = actor(i);
+		stepped.setBuffered(false);
+
+		if (stepped.isParallel())
+		{
+			stepped.commit();
+			dirty |= static_cast<bool>(m_changed[i]);
+		}
+		else
+			dirty |= stepped(steps);
+	}
 
-	//Execute all the actors
-	std::for_each(
-				m_actors.begin(), m_actors.end(),
-				[&dirty, steps](auto & actor) { dirty |= actor(steps);});
+	m_firstActor = (m_firstActor + 1) % count;
+	m_stepping = false;
 
 	return dirty;
 }
 
+void World::setStepThreads(unsigned int threads)
+{
+	if (!threads)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	if (threads == 1)
+		m_pool.reset();
+	else if (!m_pool || (m_pool->workers() != threads - 1))
+		m_pool = std::make_unique<WorkStealingPool>(threads - 1);
+}
+
 Position World::clamp(const Position & position, const Position & margin)
 {
 	return position.max(boundingBox[0] + margin).min(boundingBox[1] - margin);
@@ -96,3 +223,37 @@ Position World::edge(const Position &from, const Position &to, const Position &
 	return from + direction * t;
 }
 
+
+void World::resetTurtles()
+{
+	//The homes depend on the size, which might have changed
+	for (size_t i = 0; i < m_turtles.size(); ++i)
+	{
+		const auto home = turtleHome(i);
+		m_turtles[i]->setHome(home.first, home.second);
+		m_turtles[i]->reset();
+	}
+
+	if (m_swarm)
+		m_swarm->reset();
+}
+
+std::pair<Position, double> World::turtleHome(size_t index)
+{
+	if (!index)
+		return {{}, 0};
+
+	//A sunflower spiral, which is evenly spread at any count
+	static const double pi = acos(-1);
+	static const double goldenAngle = pi * (3 - sqrt(5));
+	constexpr double spacing = 1.5;
+
+	const double angle = goldenAngle * static_cast<double>(index);
+	const double radius = spacing * sqrt(static_cast<double>(index));
+
+	const Position position = clamp(
+				{radius * cos(angle), radius * sin(angle)},
+				{TurtleActor::radius, TurtleActor::radius});
+
+	return {position, angle / (2 * pi)};
+}
@@ -5,16 +5,18 @@
 #include "TiledFloor.h"
 #include "Actor.h"
 #include "TurtleActor.h"
-#include "Scene.h"
+#include "SwarmActor.h"
+#include "WorkStealingPool.h"
 
 #include <vector>
 #include <array>
+#include <memory>
 
 namespace Turtle
 {
 
 	//Represents and handles the simulated world
-	//This includes both the simulation and graphical data
+	//The graphical representation is kept separately, see WorldRenderer
 	class World
 	{
 	public:
@@ -23,17 +25,48 @@ namespace Turtle
 		void resize(const Index2D & size, const Position2D & tileSize = {1,1});
 		void reset();
 
+		//Let the turtles go, and draw, beyond the size of the floor, see TiledFloor::setUnbounded()
+		void setUnbounded(bool unbounded);
+
 		//Set a new image
 		void setImage(const QImage & image);
 
+		//Set a new floor of the given half size, with these chunks written, see TiledFloor::chunks()
+		//Unlike setImage(), keeps the tiles beyond the size of an unbounded floor.
+		void setFloor(const Index2D & size, const TiledFloor::Chunks & chunks);
+
 		//Execute the simulated world step(s)
 		//Returns whether something in the world changed
+		//Each actor steps against the world as it was before the step, seeing only its own
+		// changes, which are applied in order afterwards. So stepping in parallel gives
+		// the very same results as stepping serially.
 		bool operator()(int steps = 1);
 
+		//The number of times the world was stepped
+		quint64 stepCount() const { return m_stepCount; }
+
+		//Step the actors on this many threads, including the caller
+		//1 (the default) steps serially, and 0 uses all the hardware threads.
+		void setStepThreads(unsigned int threads);
+
+		//Add a turtle, sharing the floor with the rest
+		//Each turtle starts at a home of its own, see turtleHome().
+		TurtleActor & addTurtle();
+
+		//Remove a turtle, which can not be the main one
+		//Anything controlling the turtle should be destroyed first.
+		void removeTurtle(TurtleActor & turtle);
+
+		//The brainless turtles, stepped together as a single actor
+		//It's created on first use, and goes home on reset() with the rest.
+		SwarmActor & swarm();
+		bool hasSwarm() const { return static_cast<bool>(m_swarm); }
+
 		//Access functors
 		TiledFloor & floor() {return m_floor;}
-		TurtleActor & mainActor() { return m_mainActor;}
-		Scene & scene() {return m_scene;}
+		TurtleActor & mainActor() { return *m_turtles.front();}
+		size_t turtleCount() const { return m_turtles.size(); }
+		TurtleActor & turtle(size_t index) { return *m_turtles[index]; }
 
 		//Clamp the position to the bounding box
 		Position clamp(const Position & position, const Position & margin = {});
@@ -43,6 +76,16 @@ namespace Turtle
 		Position edge(const Position & from, const Position & to, const Position & margin = {});
 
 	private:
+		//Set the bounding box to the floor
+		void bound();
+
+		//Send all the turtles home
+		void resetTurtles();
+
+		//Where the turtle at an index starts, facing away from the origin
+		//The main turtle starts at the origin, and the rest spiral out evenly.
+		std::pair<Position, double> turtleHome(size_t index);
+
 		//The world bounding box
 		std::array<Position, 2> boundingBox;
 
@@ -52,15 +95,31 @@ namespace Turtle
 		//The floor of the world
 		TiledFloor m_floor;
 
-		//The main actor of the world
-		TurtleActor m_mainActor;
+		//The turtles of the world, the first is the main one
+		std::vector<std::unique_ptr<TurtleActor>> m_turtles;
 
-		//The 3D scene
-		Scene m_scene;
+		std::unique_ptr<SwarmActor> m_swarm;
 
 		//The actors
 		std::vector<std::reference_wrapper<Actor>> m_actors;
 
+		//The actor that steps first, rotated on every step so none is favored
+		size_t m_firstActor = 0;
+
+		//Fewer actors are always stepped serially
+		static constexpr size_t parallelThreshold = 8;
+
+		//Steps the actors in parallel, if set
+		std::unique_ptr<WorkStealingPool> m_pool;
+
+		//Whether each actor changed in the current step, in stepping order
+		std::vector<char> m_changed;
+
+		//Set while stepping, as callbacks might spin a nested event loop
+		bool m_stepping = false;
+
+		quint64 m_stepCount = 0;
+
 	};
 
 }
@@ -0,0 +1,74 @@
+#include "WorldRenderer.h"
+
+#include <algorithm>
+
+using namespace Turtle;
+
+WorldRenderer::WorldRenderer(World & world) :
+	m_world{world},
+	m_floor{world.floor()},
+	m_mainActor{world.mainActor()}
+{
+	//Add all graphical elements to the scene
+	m_scene.addChild(m_floor.root());
+	m_scene.addChild(m_mainActor.root());
+
+	updateTurtles();
+}
+
+void WorldRenderer::update(double elapsed)
+{
+	updateTurtles();
+
+	m_mainActor.update(elapsed);
+
+	for (auto & turtle : m_turtles)
+		turtle.second->update(elapsed);
+
+	if (m_swarm)
+		m_swarm->update();
+}
+
+void WorldRenderer::setCamera(osg::Camera * camera)
+{
+	m_camera = camera;
+
+	if (m_swarm)
+		m_swarm->setCamera(camera);
+}
+
+void WorldRenderer::updateTurtles()
+{
+	decltype(m_turtles) turtles;
+
+	for (size_t i = 1; i < m_world.turtleCount(); ++i)
+	{
+		const TurtleActor * actor = &m_world.turtle(i);
+
+		auto existing = std::find_if(
+					m_turtles.begin(), m_turtles.end(),
+					[actor](const auto & turtle) { return turtle.first == actor; });
+
+		if (existing != m_turtles.end())
+			turtles.push_back(std::move(*existing));
+		else
+		{
+			turtles.emplace_back(actor, std::make_unique<TurtleRenderer>(*actor));
+			m_scene.addChild(turtles.back().second->root());
+		}
+	}
+
+	//Whatever is left belongs to removed turtles, so only its nodes are touched
+	for (auto & turtle : m_turtles)
+		if (turtle.second)
+			m_scene.removeChild(turtle.second->root());
+
+	m_turtles = std::move(turtles);
+
+	if (!m_swarm && m_world.hasSwarm())
+	{
+		m_swarm = std::make_unique<SwarmRenderer>(m_world.swarm());
+		m_swarm->setCamera(m_camera.get());
+		m_scene.addChild(m_swarm->root());
+	}
+}
@@ -0,0 +1,51 @@
+#ifndef WORLDRENDERER_H
+#define WORLDRENDERER_H
+
+#include "World.h"
+#include "Scene.h"
+#include "FloorRenderer.h"
+#include "TurtleRenderer.h"
+#include "SwarmRenderer.h"
+
+#include <memory>
+#include <vector>
+
+namespace Turtle
+{
+	//The 3D scene showing a World
+	class WorldRenderer
+	{
+	public:
+		explicit WorldRenderer(World & world);
+
+		//Update to the world's current state, animating by the time elapsed, in seconds
+		//Turtles added to or removed from the world are picked up here.
+		void update(double elapsed);
+
+		//Show only the swarm turtles this camera sees, or all of them if none is set
+		void setCamera(osg::Camera * camera);
+
+		//Access functors
+		osg::ref_ptr<osg::Group> root() {return m_scene.root();}
+		TurtleRenderer & mainActor() {return m_mainActor;}
+
+	private:
+		//Match the renderers to the world's turtles
+		void updateTurtles();
+
+		World & m_world;
+
+		Scene m_scene;
+		FloorRenderer m_floor;
+		TurtleRenderer m_mainActor;
+
+		//The rest of the turtles
+		std::vector<std::pair<const TurtleActor*, std::unique_ptr<TurtleRenderer>>> m_turtles;
+
+		//Created once the world has a swarm
+		std::unique_ptr<SwarmRenderer> m_swarm;
+		osg::observer_ptr<osg::Camera> m_camera;
+	};
+
+}
+#endif // WORLDRENDERER_H